@@ -15,6 +15,7 @@
  */
 #ifndef RAINY_WINAPI_NOTIFICATION_HPP
 #define RAINY_WINAPI_NOTIFICATION_HPP
+#ifdef _WIN32
 #include <Windows.h>
 #include <ShObjIdl.h>
 #include <strsafe.h>
@@ -23,35 +24,266 @@
 #include <roapi.h>
 #include <propvarutil.h>
 #include <functiondiscoverykeys.h>
-#include <iostream>
 #include <winstring.h>
+#endif
+#include <iostream>
 #include <string.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#ifdef _WIN32
 #include <winrt/windows.storage.h>
 #include <winrt/windows.data.xml.dom.h>
 #include <winrt/windows.ui.notifications.h>
 #include <winrt/windows.storage.fileproperties.h>
 #include <winrt/windows.foundation.collections.h>
+#else
+/* 非Windows平台上只有后端接口与内存后端，这里提供它们用到的HRESULT子集，数值与Windows SDK一致 */
+using HRESULT = std::int32_t;
+#ifndef S_OK
+#define S_OK ((HRESULT)0)
+#endif
+#ifndef E_NOTIMPL
+#define E_NOTIMPL ((HRESULT)0x80004001)
+#endif
+#ifndef E_FAIL
+#define E_FAIL ((HRESULT)0x80004005)
+#endif
+#ifndef E_INVALIDARG
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#endif
+#ifndef SUCCEEDED
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#endif
+#ifndef FAILED
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#endif
+#ifndef ERROR_NOT_FOUND
+#define ERROR_NOT_FOUND 1168L
+#endif
+#ifndef HRESULT_FROM_WIN32
+#define HRESULT_FROM_WIN32(x) ((HRESULT)(x) <= 0 ? ((HRESULT)(x)) : ((HRESULT)(((x) & 0x0000FFFF) | (7 << 16) | 0x80000000)))
+#endif
+#endif
 
 #define RAINY_NODISCARD [[nodiscard]]
 
+// 定义RAINY_NOTIFICATION_NO_METRICS时不计时也不计数，notification::metrics()只返回仪表
+#ifdef RAINY_NOTIFICATION_NO_METRICS
+#define RAINY_NOTIFICATION_METRICS 0
+#else
+#define RAINY_NOTIFICATION_METRICS 1
+#endif
+
 namespace rainy::internals {
-    using abi_toast_dismissal_reason = winrt::Windows::UI::Notifications::ToastDismissalReason;
-    using abi_template_type = winrt::Windows::UI::Notifications::ToastTemplateType;
+#ifdef _WIN32
+    using platform_error = winrt::hresult_error;
+#else
+    /**
+     * @brief 平台调用失败时抛出的异常。Windows上即winrt::hresult_error，其他平台上的后端不会抛出
+     */
+    class platform_error : public std::runtime_error {
+    public:
+        explicit platform_error(const HRESULT code) : std::runtime_error("platform error"), code_(code) {
+        }
+
+        RAINY_NODISCARD HRESULT code() const noexcept {
+            return code_;
+        }
+
+    private:
+        HRESULT code_;
+    };
+#endif
+
     constexpr static std::size_t text_fields_count[] = { 1, 2, 2, 3, 1, 2, 2, 3 };
+
+    /**
+     * @brief 检查HRESULT是否表示通知器已经失效（例如通知服务重启导致的RPC断开），需要重新创建
+     * @param hr 后端返回的HRESULT
+     * @return 如果需要重新创建通知器，返回true
+     */
+    constexpr bool is_stale_notifier_error(const HRESULT hr) noexcept {
+        switch (static_cast<std::uint32_t>(hr)) {
+            case 0x80010007u: // RPC_E_SERVER_DIED
+            case 0x80010012u: // RPC_E_SERVER_DIED_DNE
+            case 0x80010108u: // RPC_E_DISCONNECTED
+            case 0x800706BAu: // RPC_S_SERVER_UNAVAILABLE
+            case 0x80000013u: // RO_E_CLOSED
+                return true;
+            default:
+                return false;
+        }
+    }
 }
 
 namespace rainy {
     enum class notification_template_type {
-        image_and_text01 = internals::abi_template_type::ToastImageAndText01,
-        image_and_text02 = internals::abi_template_type::ToastImageAndText02,
-        image_and_text03 = internals::abi_template_type::ToastImageAndText03,
-        image_and_text04 = internals::abi_template_type::ToastImageAndText04,
-        text01 = internals::abi_template_type::ToastText01,
-        text02 = internals::abi_template_type::ToastText02,
-        text03 = internals::abi_template_type::ToastText03,
-        text04 = internals::abi_template_type::ToastText04
+        // 数值与Windows.UI.Notifications.ToastTemplateType一致
+        image_and_text01 = 0,
+        image_and_text02 = 1,
+        image_and_text03 = 2,
+        image_and_text04 = 3,
+        text01 = 4,
+        text02 = 5,
+        text03 = 6,
+        text04 = 7
+    };
+}
+
+namespace rainy::internals {
+    /* 与ToastTemplateType一一对应的模板名，按notification_template_type的值索引 */
+    constexpr std::wstring_view legacy_template_names[] = {
+        L"ToastImageAndText01", L"ToastImageAndText02", L"ToastImageAndText03", L"ToastImageAndText04",
+        L"ToastText01",         L"ToastText02",         L"ToastText03",         L"ToastText04",
+    };
+
+    /**
+     * @brief 编译期可拼接的定长字符串
+     * @tparam Capacity 最大字符数
+     */
+    template <std::size_t Capacity>
+    struct fixed_wstring {
+        constexpr fixed_wstring &append(std::wstring_view text) noexcept {
+            for (const wchar_t ch: text) {
+                data[size++] = ch;
+            }
+            return *this;
+        }
+
+        constexpr std::wstring_view view() const noexcept {
+            return {data, size};
+        }
+
+        wchar_t data[Capacity]{};
+        std::size_t size{0};
+    };
+
+    /**
+     * @brief 传统模板在编译期确定的visual布局
+     * @brief 插槽依次为图像（仅ImageAndText类型）与各行文本，segment(i)位于第i个插槽之前，segment(slots_count)位于最后一个插槽之后
+     * @tparam Type 模板类型
+     */
+    template <notification_template_type Type>
+    struct static_layout {
+        static constexpr std::size_t index = static_cast<std::size_t>(Type);
+        static constexpr std::size_t fields_count = text_fields_count[index];
+        static constexpr bool has_image = Type < notification_template_type::text01;
+        static constexpr std::size_t slots_count = fields_count + (has_image ? 1 : 0);
+        static constexpr std::wstring_view closing = L"</binding></visual>";
+
+        static constexpr std::array<fixed_wstring<80>, slots_count + 1> segments = [] {
+            std::array<fixed_wstring<80>, slots_count + 1> result{};
+            std::size_t current = 0;
+            result[current].append(L"<visual><binding template=\"").append(legacy_template_names[index]).append(L"\">");
+            if (has_image) {
+                result[current].append(L"<image id=\"1\" src=\"");
+                result[++current].append(L"\"/>");
+            }
+            for (std::size_t i = 0; i < fields_count; ++i) {
+                const wchar_t id[] = {static_cast<wchar_t>(L'1' + i)};
+                result[current].append(L"<text id=\"").append({id, 1}).append(L"\">");
+                result[++current].append(L"</text>");
+            }
+            return result;
+        }();
+
+        /**
+         * @brief 所有插槽为空时的visual骨架
+         */
+        static constexpr fixed_wstring<256> skeleton = [] {
+            fixed_wstring<256> result{};
+            for (const auto &segment: segments) {
+                result.append(segment.view());
+            }
+            result.append(closing);
+            return result;
+        }();
+
+        static constexpr std::wstring_view segment(const std::size_t pos) noexcept {
+            return segments[pos].view();
+        }
+    };
+
+    /**
+     * @brief 传统模板的完整toast骨架，以及各插入点在骨架中的偏移
+     * @brief 内容与ToastNotificationManager::GetTemplateContent返回的XML一致，构建toast时按偏移分段复制即可，无需经过DOM
+     */
+    struct legacy_skeleton {
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        std::wstring_view xml;
+        std::size_t toast_attributes;   // "<toast"之后，toast属性的插入点
+        std::size_t visual_begin;       // "<visual>"的起始位置
+        std::size_t binding_attributes; // template属性之后，binding属性的插入点
+        std::size_t binding_end;        // "</binding>"的起始位置，attribution等附加节点的插入点
+        std::size_t image_src;          // 图像src属性值的插入点，无图像时为npos
+        std::size_t text[3];            // 各行文本的插入点，不存在的行为npos
+    };
+
+    template <notification_template_type Type>
+    struct legacy_toast {
+        using layout = static_layout<Type>;
+
+        static constexpr std::wstring_view open = L"<toast>";
+        static constexpr std::wstring_view close = L"</toast>";
+
+        static constexpr fixed_wstring<256> xml = [] {
+            fixed_wstring<256> result{};
+            result.append(open).append(layout::skeleton.view()).append(close);
+            return result;
+        }();
+
+        static constexpr legacy_skeleton make() noexcept {
+            legacy_skeleton result{xml.view(), open.size() - 1, open.size(), 0, 0, legacy_skeleton::npos,
+                                   {legacy_skeleton::npos, legacy_skeleton::npos, legacy_skeleton::npos}};
+            result.binding_attributes = result.visual_begin + std::wstring_view{L"<visual><binding template=\""}.size() +
+                                        legacy_template_names[layout::index].size() + 1;
+            std::size_t offset = result.visual_begin;
+            for (std::size_t slot = 0; slot < layout::slots_count; ++slot) {
+                offset += layout::segment(slot).size();
+                if (layout::has_image && slot == 0) {
+                    result.image_src = offset;
+                } else {
+                    result.text[slot - (layout::has_image ? 1 : 0)] = offset;
+                }
+            }
+            result.binding_end = offset + layout::segment(layout::slots_count).size();
+            return result;
+        }
+    };
+
+    /* 按notification_template_type的值索引 */
+    constexpr legacy_skeleton legacy_skeletons[] = {
+        legacy_toast<notification_template_type::image_and_text01>::make(),
+        legacy_toast<notification_template_type::image_and_text02>::make(),
+        legacy_toast<notification_template_type::image_and_text03>::make(),
+        legacy_toast<notification_template_type::image_and_text04>::make(),
+        legacy_toast<notification_template_type::text01>::make(),
+        legacy_toast<notification_template_type::text02>::make(),
+        legacy_toast<notification_template_type::text03>::make(),
+        legacy_toast<notification_template_type::text04>::make(),
     };
 }
 
@@ -77,6 +309,17 @@ namespace rainy {
             loop
         };
 
+        /**
+         * @brief 通知的优先级，决定异步显示的出队顺序与达到数量上限时的驱逐顺序
+         */
+        enum class priority_t : std::uint8_t {
+            low,
+            normal,
+            high // 在支持的平台上映射为ToastNotificationPriority::High
+        };
+
+        static constexpr std::size_t priority_levels = 3;
+
         enum class textfield {
             first_line,
             second_line,
@@ -117,31 +360,85 @@ namespace rainy {
             call10,
         };
 
+        /**
+         * @brief 通知模板中的操作按钮
+         * @brief 标签被复制到模板自身的连续存储中，短标签使用内联缓冲区，不需要分配堆内存，调用者也无需保持原字符串有效
+         */
         class actions_t {
         public:
+            static constexpr std::size_t max_actions = 5;
+            static constexpr std::size_t inline_capacity = 64; // 内联缓冲区可容纳的字符数（所有标签合计）
+
             actions_t(notification_template *this_) : this_(this_) {
             }
 
-            const auto &get_container() const noexcept {
-                return data;
+            actions_t(const actions_t &) = delete;
+
+            /**
+             * @brief 复制操作标签，this_仍指向所属的通知模板
+             */
+            actions_t &operator=(const actions_t &right) {
+                if (this != &right) {
+                    reserve(right.used_);
+                    std::char_traits<wchar_t>::copy(buffer(), right.buffer(), right.used_);
+                    used_ = right.used_;
+                    labels_ = right.labels_;
+                    actions_count_ = right.actions_count_;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief 移动操作标签，this_仍指向所属的通知模板。对方使用堆存储时直接接管
+             */
+            actions_t &operator=(actions_t &&right) noexcept {
+                if (this == &right) {
+                    return *this;
+                }
+                if (right.heap_) {
+                    heap_ = std::move(right.heap_);
+                    capacity_ = right.capacity_;
+                } else {
+                    // 对方的标签在内联缓冲区中，总能放入本对象现有的存储
+                    std::char_traits<wchar_t>::copy(buffer(), right.inline_, right.used_);
+                }
+                used_ = right.used_;
+                labels_ = right.labels_;
+                actions_count_ = right.actions_count_;
+                right.capacity_ = inline_capacity;
+                right.clear();
+                return *this;
+            }
+
+            /**
+             * @brief 获取所有操作标签
+             * @return 指向本对象存储的标签视图，在标签被修改之前有效
+             */
+            std::array<std::wstring_view, max_actions> get_container() const noexcept {
+                std::array<std::wstring_view, max_actions> container{};
+                for (std::size_t i = 0; i < actions_count_; ++i) {
+                    container[i] = action_label(i);
+                }
+                return container;
             }
 
             /**
-             * @brief 获取通知模板中的操作按钮的标签的引用，按位置索引
+             * @brief 获取通知模板中的操作按钮的标签，按位置索引
              * @param pos 指定的位置索引
-             * @return 对应的位置索引的操作按钮的标签的引用
+             * @return 对应的位置索引的操作按钮的标签，在标签被修改之前有效
              */
-            const std::wstring_view &action_label(const std::size_t pos) const noexcept {
-                return data.at(pos);
+            std::wstring_view action_label(const std::size_t pos) const noexcept {
+                const label &target = labels_.at(pos);
+                return {buffer() + target.offset, target.length};
             }
 
             /**
              * @brief 添加一个操作标签，最多支持5个标签
              * @param label 标签内容
              */
-            void add_action(std::wstring_view label) noexcept {
-                if (!this_->has_input() && actions_count_ != 5) {
-                    data[actions_count_++] = label;
+            void add_action(std::wstring_view label) {
+                if (!this_->has_input() && actions_count_ != max_actions) {
+                    append(label);
                 }
             }
 
@@ -149,12 +446,12 @@ namespace rainy {
              * @brief 批量添加操作标签，最多支持5个标签
              * @param ilist 初始化列表
              */
-            void add_action(std::initializer_list<std::wstring_view> ilist) noexcept {
+            void add_action(std::initializer_list<std::wstring_view> ilist) {
                 for (const auto &label: ilist) {
-                    if (actions_count_ == 5) {
+                    if (actions_count_ == max_actions) {
                         break;
                     }
-                    data[actions_count_++] = label;
+                    append(label);
                 }
             }
 
@@ -183,18 +480,21 @@ namespace rainy {
                 if (pos >= actions_count_) {
                     return false;
                 }
+                splice(pos, 0);
                 for (std::size_t i = pos; i < actions_count_ - 1; ++i) {
-                    data[i] = data[i + 1];
+                    labels_[i] = labels_[i + 1];
                 }
-                --actions_count_;
+                labels_[--actions_count_] = {};
                 return true;
             }
 
             /**
-             * @brief 清空所有操作标签
+             * @brief 清空所有操作标签，已分配的存储保留以便复用
              */
             void clear() noexcept {
                 actions_count_ = 0;
+                used_ = 0;
+                labels_ = {};
             }
 
             /**
@@ -203,17 +503,83 @@ namespace rainy {
              * @param label 新的标签内容
              * @return true 如果设置成功
              */
-            bool set_action_label(const std::size_t pos, std::wstring_view label) noexcept {
+            bool set_action_label(const std::size_t pos, std::wstring_view label) {
                 if (pos >= actions_count_) {
                     return false;
                 }
-                data[pos] = label;
+                if (owns(label)) {
+                    const std::wstring copy{label};
+                    return set_action_label(pos, copy);
+                }
+                reserve(used_ - labels_[pos].length + label.size());
+                splice(pos, label.size());
+                std::char_traits<wchar_t>::copy(buffer() + labels_[pos].offset, label.data(), label.size());
                 return true;
             }
 
         private:
+            struct label {
+                std::uint32_t offset;
+                std::uint32_t length;
+            };
+
+            wchar_t *buffer() noexcept {
+                return heap_ ? heap_.get() : inline_;
+            }
+
+            const wchar_t *buffer() const noexcept {
+                return heap_ ? heap_.get() : inline_;
+            }
+
+            bool owns(std::wstring_view label) const noexcept {
+                const wchar_t *first = buffer();
+                return !label.empty() && std::less_equal<>{}(first, label.data()) && std::less<>{}(label.data(), first + capacity_);
+            }
+
+            void reserve(const std::size_t required) {
+                if (required <= capacity_) {
+                    return;
+                }
+                const std::size_t capacity = (std::max)(required, capacity_ * 2);
+                auto storage = std::make_unique<wchar_t[]>(capacity);
+                std::char_traits<wchar_t>::copy(storage.get(), buffer(), used_);
+                heap_ = std::move(storage);
+                capacity_ = capacity;
+            }
+
+            void append(std::wstring_view text) {
+                if (owns(text)) {
+                    const std::wstring copy{text};
+                    append(copy);
+                    return;
+                }
+                reserve(used_ + text.size());
+                std::char_traits<wchar_t>::copy(buffer() + used_, text.data(), text.size());
+                labels_[actions_count_++] = {static_cast<std::uint32_t>(used_), static_cast<std::uint32_t>(text.size())};
+                used_ += text.size();
+            }
+
+            /**
+             * @brief 将pos处的标签长度调整为length，并移动其后的标签。调用前必须保证容量足够
+             */
+            void splice(const std::size_t pos, const std::size_t length) noexcept {
+                label &target = labels_[pos];
+                const std::size_t tail = target.offset + target.length;
+                const std::size_t new_tail = target.offset + length;
+                std::char_traits<wchar_t>::move(buffer() + new_tail, buffer() + tail, used_ - tail);
+                used_ = used_ - target.length + length;
+                for (std::size_t i = pos + 1; i < actions_count_; ++i) {
+                    labels_[i].offset = static_cast<std::uint32_t>(labels_[i].offset - tail + new_tail);
+                }
+                target.length = static_cast<std::uint32_t>(length);
+            }
+
             std::size_t actions_count_{0};
-            std::array<std::wstring_view, 5> data{};
+            std::array<label, max_actions> labels_{};
+            std::size_t used_{0};
+            std::size_t capacity_{inline_capacity};
+            std::unique_ptr<wchar_t[]> heap_{};
+            wchar_t inline_[inline_capacity];
             notification_template *this_;
         };
 
@@ -227,7 +593,78 @@ namespace rainy {
          * @brief 构造函数，以指定模板类型初始化
          * @param type 指定的模板类型
          */
-        notification_template(notification_template_type type) : template_type_(type), has_input_(false), actions(this) {
+        notification_template(notification_template_type type) : actions(this), template_type_(type) {
+        }
+
+        notification_template(const notification_template &right) : notification_template(right.template_type_) {
+            *this = right;
+        }
+
+        notification_template(notification_template &&right) noexcept : notification_template(right.template_type_) {
+            *this = std::move(right);
+        }
+
+        notification_template &operator=(const notification_template &) = default;
+        notification_template &operator=(notification_template &&) noexcept = default;
+
+        /**
+         * @brief 数据绑定的键值对，键对应模板字符串中形如{key}的占位符
+         */
+        struct data_binding {
+            std::wstring key;
+            std::wstring value;
+        };
+
+        /**
+         * @brief 进度条，各属性既可以是字面值，也可以是形如{key}的绑定占位符
+         */
+        struct progress_bar_t {
+            std::wstring value;        // 0.0至1.0之间的数值，或"indeterminate"
+            std::wstring status;       // 进度条下方左侧的状态文本
+            std::wstring title;        // 进度条上方的标题，可为空
+            std::wstring value_string; // 替代默认百分比显示的文本，可为空
+        };
+
+        /**
+         * @brief 将模板恢复为新构造时的状态，但保留字符串与操作标签已分配的存储
+         * @param type 恢复后的模板类型
+         * @note 在循环中复用同一模板时，只要内容长度不超过此前的最大长度，重新填充模板不会分配堆内存
+         */
+        void reset(notification_template_type type = notification_template_type::text01) {
+            for (auto &text: text_fields_) {
+                text.clear();
+            }
+            image_path_.clear();
+            hero_image_path_.clear();
+            audio_path_.clear();
+            attribution_text_.clear();
+            coalescing_key_.clear();
+            tag_.clear();
+            group_.clear();
+            progress_bar_.value.clear();
+            progress_bar_.status.clear();
+            progress_bar_.title.clear();
+            progress_bar_.value_string.clear();
+            for (std::size_t i = 0; i < bindings_count_; ++i) {
+                bindings_[i].key.clear();
+                bindings_[i].value.clear();
+            }
+            bindings_count_ = 0;
+            scenario_.assign(L"Default");
+            actions.clear();
+            for (std::size_t i = 0; i < inputs_count_; ++i) {
+                inputs_[i].id.clear();
+                inputs_[i].placeholder.clear();
+            }
+            inputs_count_ = 0;
+            inline_hero_image = false;
+            expiration_ = 0;
+            id_ = -1;
+            priority_ = priority_t::normal;
+            audio_option_ = audio_option_t::default_option;
+            template_type_ = type;
+            duration_ = duration_t::system;
+            crop_hint_ = crop_hint::square;
         }
 
         /**
@@ -399,15 +836,56 @@ namespace rainy {
             }
         }
 
+        /**
+         * @brief 输入框，用户输入的内容在激活时以id为键回报
+         */
+        struct input_t {
+            std::wstring id;
+            std::wstring placeholder;
+        };
+
+        static constexpr std::size_t max_inputs = 5;
+
         /**
          * @brief 设置是否允许用户输入
-         * @param enable 是否允许用户输入
-         * @note 如果没有操作按钮，则默认允许用户输入
+         * @param enable 是否允许用户输入。启用时若尚无输入框，则添加一个id为textBox的输入框；禁用时移除全部输入框
+         * @note 存在操作按钮时无法启用用户输入
+        */
+        void toggle_input(const bool enable = true) {
+            if (!enable) {
+                inputs_count_ = 0;
+            } else if (inputs_count_ == 0) {
+                add_input(L"textBox");
+            }
+        }
+
+        /**
+         * @brief 添加一个具名输入框，回复按钮提交时会带上全部输入框的内容
+         * @param id 输入框的id，不能为空，不能重复，且不能包含'='与';'
+         * @param placeholder 输入框为空时显示的提示文本
+         * @return 存在操作按钮、输入框已达max_inputs个或id无效时返回false
         */
-        void toggle_input(const bool enable = true) noexcept {
-            if (actions.empty()) {
-                has_input_ = true;
+        bool add_input(std::wstring_view id, std::wstring_view placeholder = L"...") {
+            if (!actions.empty() || inputs_count_ == max_inputs || id.empty() || id.find_first_of(L"=;") != std::wstring_view::npos) {
+                return false;
+            }
+            for (std::size_t i = 0; i < inputs_count_; ++i) {
+                if (inputs_[i].id == id) {
+                    return false;
+                }
             }
+            input_t &input = inputs_[inputs_count_++];
+            input.id = id;
+            input.placeholder = placeholder;
+            return true;
+        }
+
+        /**
+         * @brief 获取已添加的输入框
+         * @return 按添加顺序排列的输入框，回复按钮关联第一个输入框
+        */
+        RAINY_NODISCARD std::span<const input_t> inputs() const noexcept {
+            return {inputs_.data(), inputs_count_};
         }
 
         /**
@@ -415,7 +893,7 @@ namespace rainy {
          * @return true 如果允许用户输入
         */
         bool has_input() const noexcept {
-            return has_input_;
+            return inputs_count_ != 0;
         }
 
         /**
@@ -511,6 +989,148 @@ namespace rainy {
             expiration_ = milliseconds_from_now;
         }
 
+        /**
+         * @brief 获取通知的优先级
+         * @return 未设置时为priority_t::normal
+         */
+        RAINY_NODISCARD priority_t priority() const noexcept {
+            return priority_;
+        }
+
+        /**
+         * @brief 设置通知的优先级
+         * @param priority 优先级
+         */
+        void priority(const priority_t priority) noexcept {
+            priority_ = priority;
+        }
+
+        /**
+         * @brief 获取调用者指定的通知ID
+         * @return 未指定时返回-1，此时show()会自动生成ID
+         */
+        RAINY_NODISCARD std::int64_t id() const noexcept {
+            return id_;
+        }
+
+        /**
+         * @brief 指定通知ID，show()将使用该ID而不是自动生成
+         * @param id 非负的通知ID，为-1时恢复自动生成
+         * @attention 若该ID已被仍在显示的通知占用，show()会以notification_error::duplicate_id失败
+         */
+        void id(const std::int64_t id) noexcept {
+            id_ = id;
+        }
+
+        /**
+         * @brief 获取合并键
+         * @return 未设置时为空
+         */
+        RAINY_NODISCARD std::wstring_view coalescing_key() const noexcept {
+            return coalescing_key_;
+        }
+
+        /**
+         * @brief 设置合并键。启用准入控制后，合并窗口内具有相同键的通知会合并为一条，按键限流时也以此区分令牌桶
+         * @param key 合并键，为空时不参与合并
+         */
+        void coalescing_key(std::wstring_view key) {
+            coalescing_key_ = key;
+        }
+
+        /**
+         * @brief 获取Tag
+         * @return 未设置时为空
+         */
+        RAINY_NODISCARD std::wstring_view tag() const noexcept {
+            return tag_;
+        }
+
+        /**
+         * @brief 设置Tag。同一Group内Tag唯一，以相同Tag与Group显示的新通知会替换旧通知
+         * @param tag Tag，不超过64个字符
+         */
+        void tag(std::wstring_view tag) {
+            tag_ = tag;
+        }
+
+        /**
+         * @brief 获取Group
+         * @return 未设置时为空
+         */
+        RAINY_NODISCARD std::wstring_view group() const noexcept {
+            return group_;
+        }
+
+        /**
+         * @brief 设置Group，可通过notification::hide_group一次移除同组的全部通知
+         * @param group Group，不超过64个字符
+         */
+        void group(std::wstring_view group) {
+            group_ = group;
+        }
+
+        /**
+         * @brief 设置进度条，仅在启用现代特性时输出，且会使模板使用ToastGeneric
+         * @param value 进度值，0.0至1.0之间的数值、"indeterminate"，或形如{key}的占位符
+         * @param status 状态文本或占位符
+         * @param title 标题或占位符，为空时不显示
+         * @param value_string 替代默认百分比显示的文本或占位符，为空时显示百分比
+         */
+        void progress_bar(std::wstring_view value, std::wstring_view status, std::wstring_view title = {},
+                          std::wstring_view value_string = {}) {
+            progress_bar_.value = value;
+            progress_bar_.status = status;
+            progress_bar_.title = title;
+            progress_bar_.value_string = value_string;
+        }
+
+        /**
+         * @brief 获取进度条
+         * @return 进度条，value为空时表示未设置
+         */
+        RAINY_NODISCARD const progress_bar_t &progress_bar() const noexcept {
+            return progress_bar_;
+        }
+
+        /**
+         * @brief 检查当前模板是否包含进度条
+         * @return 指示是否包含进度条
+         */
+        RAINY_NODISCARD bool has_progress_bar() const noexcept {
+            return !progress_bar_.value.empty();
+        }
+
+        /**
+         * @brief 声明一个绑定值。通知显示后可通过notification::update只推送变化的值，而无需重新生成XML
+         * @param key 键，对应模板字符串中的{key}占位符
+         * @param initial_value 显示时的初始值
+         * @note 重复声明同一个键会覆盖其初始值
+         */
+        void bind(std::wstring_view key, std::wstring_view initial_value) {
+            for (std::size_t i = 0; i < bindings_count_; ++i) {
+                if (bindings_[i].key == key) {
+                    bindings_[i].value = initial_value;
+                    return;
+                }
+            }
+            if (bindings_count_ == bindings_.size()) {
+                bindings_.emplace_back();
+            }
+            // reset()之后复用此前的键值字符串
+            data_binding &binding = bindings_[bindings_count_++];
+            binding.key.assign(key);
+            binding.value.assign(initial_value);
+        }
+
+        /**
+         * @brief 获取已声明的绑定值
+         * @return 按声明顺序排列的键值对
+         */
+        RAINY_NODISCARD std::span<const data_binding> bindings() const noexcept {
+            return {bindings_.data(), bindings_count_};
+        }
+
         /**
          * @brief 获取通知模板使用的类型
          * @return 返回一个枚举值，表示通知模板的类型
@@ -544,7 +1164,7 @@ namespace rainy {
          * @return 指示是否为通用模板
          */
         RAINY_NODISCARD bool is_toast_generic() const noexcept {
-            return has_hero_image() || crop_hint_ == crop_hint::circle;
+            return has_hero_image() || crop_hint_ == crop_hint::circle || has_progress_bar();
         }
 
         /**
@@ -566,63 +1186,328 @@ namespace rainy {
         actions_t actions;
 
     private:
-        bool has_input_;
+        std::array<input_t, max_inputs> inputs_{};
+        std::size_t inputs_count_{0};
         bool inline_hero_image{false};
         std::int64_t expiration_{0};
+        std::int64_t id_{-1};
+        priority_t priority_{priority_t::normal};
         std::array<std::wstring, 3> text_fields_{};
         std::wstring image_path_{};
         std::wstring hero_image_path_{};
         std::wstring audio_path_{};
         std::wstring attribution_text_{};
+        std::wstring coalescing_key_{};
+        std::wstring tag_{};
+        std::wstring group_{};
+        progress_bar_t progress_bar_{};
+        std::vector<data_binding> bindings_{}; // 前bindings_count_项有效，其余为reset()后保留存储的空项
+        std::size_t bindings_count_{0};
         std::wstring scenario_{L"Default"};
         audio_option_t audio_option_{audio_option_t::default_option};
         notification_template_type template_type_{notification_template_type::text01};
         duration_t duration_{duration_t::system};
         crop_hint crop_hint_{crop_hint::square};
     };
-}
 
-namespace rainy {
-    struct notification_handler {
-        enum class dismissal_reason {
-            user_canceled = internals::abi_toast_dismissal_reason::UserCanceled,
-            application_hidden = internals::abi_toast_dismissal_reason::ApplicationHidden,
-            timed_out = internals::abi_toast_dismissal_reason::TimedOut
-        };
+    /**
+     * @brief 布局在编译期确定的通知模板
+     * @brief 文本行数、图像插槽与绑定（固定为对应的传统模板，不支持Hero Image与圆形裁剪）由Type决定，设置不存在的行会在编译期报错。
+     * @brief toast_xml_serializer与notification::show对其有专门的重载，visual部分直接由编译期生成的片段拼接
+     * @tparam Type 模板类型
+     */
+    template <notification_template_type Type>
+    class static_notification_template : private notification_template {
+    public:
+        using layout = internals::static_layout<Type>;
+
+        static constexpr notification_template_type type = Type;
+        static constexpr std::size_t fields_count = layout::fields_count;
+        static constexpr bool has_image = layout::has_image;
+
+        static_notification_template() : notification_template(Type) {
+        }
 
-        virtual ~notification_handler() = default;
-        
         /**
-         * @brief 通知被激活
-        */
-        virtual void activated() const = 0;
+         * @brief 设置指定行的文本
+         * @tparam Line 行号，从0开始，必须小于fields_count
+         * @param text 文本内容
+         */
+        template <std::size_t Line>
+        void set_line(std::wstring_view text) {
+            static_assert(Line < fields_count, "this template type does not have the requested text line");
+            set_text_field(text, static_cast<textfield>(Line));
+        }
 
         /**
-         * @brief 通知被激活，并带有操作按钮的索引
-         * @param action_idx 操作按钮的索引
-        */
-        virtual void activated(int action_idx) const = 0;
+         * @brief 获取指定行的文本
+         * @tparam Line 行号，从0开始，必须小于fields_count
+         * @return 文本内容
+         */
+        template <std::size_t Line>
+        RAINY_NODISCARD std::wstring_view line() const {
+            static_assert(Line < fields_count, "this template type does not have the requested text line");
+            return text_field(static_cast<textfield>(Line));
+        }
 
         /**
-         * @brief 通知被激活，并带有用户输入的文本
-         * @param response 用户输入的文本
-        */
-        virtual void activated(const std::wstring_view response) const = 0;
+         * @brief 设置图像路径，仅ImageAndText类型可用
+         * @param img_path 图像路径
+         */
+        void set_image_path(std::wstring_view img_path) {
+            static_assert(has_image, "this template type does not have an image slot");
+            notification_template::set_image_path(img_path);
+        }
 
         /**
-         * @brief 通知被关闭
-         * @param state 关闭原因
-        */
-        virtual void dismissed(dismissal_reason state) const = 0;
+         * @brief 获取对应的运行时模板，可用于任何接受notification_template的接口
+         * @return 运行时模板
+         */
+        RAINY_NODISCARD const notification_template &get() const noexcept {
+            return *this;
+        }
+
+        using notification_template::actions;
+        using notification_template::attribution_text;
+        using notification_template::audio_option;
+        using notification_template::audio_path;
+        using notification_template::coalescing_key;
+        using notification_template::duration;
+        using notification_template::expiration;
+        using notification_template::add_input;
+        using notification_template::has_input;
+        using notification_template::inputs;
+        using notification_template::id;
+        using notification_template::priority;
+        using notification_template::scenario;
+        using notification_template::set_attribution_text;
+        using notification_template::toggle_input;
+
+        RAINY_NODISCARD std::wstring_view image_path() const {
+            return notification_template::image_path();
+        }
 
         /**
-         * @brief 通知发送失败
-        */
-        virtual void failed() const = 0;
+         * @brief 将模板恢复为新构造时的状态，保留已分配的存储，模板类型不变
+         */
+        void reset() {
+            notification_template::reset(Type);
+        }
     };
+}
 
-    struct mono_notification_handler_t final : notification_handler {
-        ~mono_notification_handler_t() = default;
+namespace rainy {
+    /**
+     * @brief toast激活参数的解析结果
+     * @brief 参数采用紧凑的"key=value;"编码，例如"action=2;"或"action=reply;input=textBox;"。最后一个分号可以省略，
+     * @brief 键不能为空，键与值都不能包含';'，值中的'='视为普通字符
+     * @attention 解析结果只引用原字符串，其生命周期不能超过被解析的字符串
+     */
+    class toast_arguments {
+    public:
+        static constexpr std::size_t max_fields = 8;
+
+        struct field {
+            std::wstring_view key;
+            std::wstring_view value;
+        };
+
+        toast_arguments() noexcept = default;
+
+        /**
+         * @brief 原地解析，不分配内存也不抛出异常
+         * @param text 激活参数
+         * @return 格式错误或字段超过max_fields个时返回false，此时结果为空
+         */
+        bool parse(const std::wstring_view text) noexcept {
+            constexpr std::size_t npos = std::wstring_view::npos;
+            const wchar_t *const data = text.data();
+            count_ = 0;
+            std::size_t begin = 0;
+            std::size_t separator = npos;
+            // 单次扫描，同时定位每个字段的'='与';'
+            for (std::size_t i = 0; i <= text.size(); ++i) {
+                const bool at_end = i == text.size();
+                if (!at_end && data[i] == L'=') {
+                    separator = separator == npos ? i : separator;
+                    continue;
+                }
+                if (!at_end && data[i] != L';') {
+                    continue;
+                }
+                if (at_end && begin == i) {
+                    break; // 允许省略最后一个分号
+                }
+                if (separator == npos || separator == begin || count_ == max_fields) {
+                    count_ = 0;
+                    return false;
+                }
+                fields_[count_++] = {{data + begin, separator - begin}, {data + separator + 1, i - separator - 1}};
+                begin = i + 1;
+                separator = npos;
+            }
+            return true;
+        }
+
+        /**
+         * @brief 查找指定键的值
+         * @param key 键
+         * @return 键重复时返回第一个值，不存在时返回std::nullopt
+         */
+        RAINY_NODISCARD std::optional<std::wstring_view> find(std::wstring_view key) const noexcept {
+            for (std::size_t i = 0; i < count_; ++i) {
+                if (fields_[i].key == key) {
+                    return fields_[i].value;
+                }
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief 获取操作按钮的索引
+         * @return action为非负整数时返回其值，否则返回std::nullopt
+         */
+        RAINY_NODISCARD std::optional<int> action_index() const noexcept {
+            const auto action = find(L"action");
+            if (!action || action->empty() || action->size() > 9) {
+                return std::nullopt; // 9位以内的十进制数不会溢出int
+            }
+            int index = 0;
+            for (const wchar_t ch: *action) {
+                if (ch < L'0' || ch > L'9') {
+                    return std::nullopt;
+                }
+                index = index * 10 + (ch - L'0');
+            }
+            return index;
+        }
+
+        /**
+         * @brief 检查是否由回复按钮激活
+         * @return 指示是否由回复按钮激活
+         */
+        RAINY_NODISCARD bool is_reply() const noexcept {
+            return find(L"action") == std::wstring_view{L"reply"};
+        }
+
+        RAINY_NODISCARD std::span<const field> fields() const noexcept {
+            return {fields_.data(), count_};
+        }
+
+    private:
+        std::array<field, max_fields> fields_{};
+        std::size_t count_{0};
+    };
+
+    /**
+     * @brief 激活时回报的一个输入框的内容
+     */
+    struct user_input {
+        std::wstring_view id;
+        std::wstring_view value;
+    };
+
+    /**
+     * @brief 一次激活的全部信息
+     * @attention 所有视图都引用平台对象持有的字符串，仅在事件回调期间有效，需要保留时应自行复制
+     */
+    struct activation {
+        std::wstring_view arguments{};      // 原始激活参数
+        std::span<const user_input> inputs{}; // 全部输入框的内容
+
+        /**
+         * @brief 查找指定输入框的内容
+         * @param id 输入框的id
+         * @return 不存在时返回std::nullopt
+         */
+        RAINY_NODISCARD std::optional<std::wstring_view> input(std::wstring_view id) const noexcept {
+            for (const auto &entry: inputs) {
+                if (entry.id == id) {
+                    return entry.value;
+                }
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief 解析激活参数，得到操作按钮的索引或回复按钮关联的输入框内容
+         * @param action_index 由操作按钮激活时输出其索引
+         * @param reply 由回复按钮激活时输出其关联的输入框内容
+         * @note 参数格式错误时两者均不输出，应按普通激活处理
+         */
+        void resolve(std::optional<int> &action_index, std::optional<std::wstring_view> &reply) const noexcept {
+            toast_arguments parsed;
+            if (!parsed.parse(arguments)) {
+                return;
+            }
+            if (parsed.is_reply()) {
+                const auto id = parsed.find(L"input");
+                reply = input(id ? *id : std::wstring_view{L"textBox"});
+            } else {
+                action_index = parsed.action_index();
+            }
+        }
+    };
+
+    struct notification_handler {
+        enum class dismissal_reason {
+            // 数值与Windows.UI.Notifications.ToastDismissalReason一致
+            user_canceled = 0,
+            application_hidden = 1,
+            timed_out = 2
+        };
+
+        virtual ~notification_handler() = default;
+        
+        /**
+         * @brief 通知被激活
+        */
+        virtual void activated() const = 0;
+
+        /**
+         * @brief 通知被激活，并带有操作按钮的索引
+         * @param action_idx 操作按钮的索引
+        */
+        virtual void activated(int action_idx) const = 0;
+
+        /**
+         * @brief 通知被激活，并带有用户输入的文本
+         * @param response 用户输入的文本
+        */
+        virtual void activated(const std::wstring_view response) const = 0;
+
+        /**
+         * @brief 通知被关闭
+         * @param state 关闭原因
+        */
+        virtual void dismissed(dismissal_reason state) const = 0;
+
+        /**
+         * @brief 通知发送失败
+        */
+        virtual void failed() const = 0;
+
+        /**
+         * @brief 通知被激活，带有完整的激活信息。默认实现解析激活参数，并转发到相应的activated重载
+         * @param args 激活信息，仅在调用期间有效
+         * @note 回复按钮激活时转发其关联的输入框内容；参数格式错误时按普通激活处理
+        */
+        virtual void activated(const activation &args) const {
+            std::optional<int> action_index;
+            std::optional<std::wstring_view> reply;
+            args.resolve(action_index, reply);
+            if (reply) {
+                activated(*reply);
+            } else if (action_index) {
+                activated(*action_index);
+            } else {
+                activated();
+            }
+        }
+    };
+
+    struct mono_notification_handler_t final : notification_handler {
+        ~mono_notification_handler_t() = default;
         void activated() const override {
         }
         void activated(int action_idx) const override {
@@ -648,99 +1533,2061 @@ namespace rainy {
 
         event_type type;
         std::variant<std::wstring_view, notification_handler::dismissal_reason, int, std::monostate> data;
+        activation details{}; // 激活事件的原始参数与全部输入框的内容，仅在回调期间有效
     };
 }
 
-namespace rainy::utility {
-    class xml_notifcation_field {
+namespace rainy::internals {
+    /**
+     * @brief 将接受const notification_event &的仿函数适配为notification_handler
+     * @tparam EventHandler 仿函数类型
+     */
+    template <typename EventHandler>
+    struct callable_handler final : EventHandler, notification_handler {
+        using event_t = notification_event;
+
+        callable_handler(EventHandler &&handler) : EventHandler(std::move(handler)) {
+        }
+
+        void activated() const override {
+            event_t event{event_t::event_type::activated, {}};
+            call_handler(event);
+        }
+
+        void activated(int action_idx) const override {
+            event_t event{event_t::event_type::activated_with_action_idx, action_idx};
+            call_handler(event);
+        }
+
+        void activated(const std::wstring_view response) const override {
+            event_t event{event_t::event_type::activated_with_reply, response};
+            call_handler(event);
+        }
+
+        void activated(const activation &args) const override {
+            std::optional<int> action_index;
+            std::optional<std::wstring_view> reply;
+            args.resolve(action_index, reply);
+            event_t event{event_t::event_type::activated, {}, args};
+            if (reply) {
+                event.type = event_t::event_type::activated_with_reply;
+                event.data = *reply;
+            } else if (action_index) {
+                event.type = event_t::event_type::activated_with_action_idx;
+                event.data = *action_index;
+            }
+            call_handler(event);
+        }
+
+        void dismissed(dismissal_reason state) const override {
+            event_t event{event_t::event_type::dismissed, state};
+            call_handler(event);
+        }
+
+        void failed() const override {
+            event_t event{event_t::event_type::failed, {}};
+            call_handler(event);
+        }
+
+        void call_handler(const event_t &event) const {
+            (*this)(event);
+        }
+    };
+
+    /**
+     * @brief 类型擦除的事件处理器，由通知注册表的槽位独占持有
+     * @brief 小型且可无异常移动的仿函数直接存放在内部缓冲区中，其余的放在堆上。事件经由单个函数指针分发，
+     * @brief 继承自notification_handler的处理器直接调用其虚函数，不构造notification_event
+     */
+    class inline_handler {
     public:
-        struct context_bridge {
-            struct state {
-                static constexpr int placeholder = 0;
-                static constexpr int is_supporting_modern_features = 2;
-                static constexpr int is_enable_modern_features = 4;
-                static constexpr int is_win10_anniversary_or_higher = 8;
-            };
+        static constexpr std::size_t inline_capacity = 6 * sizeof(void *);
 
-            template <typename Notifcation>
-            context_bridge(Notifcation &context) : option() {
-                if (context.is_supporting_modern_features()) {
-                    option |= state::is_supporting_modern_features;
-                }
-                if (context.is_enable_modern_features()) {
-                    option |= state::is_enable_modern_features;
+        inline_handler() noexcept = default;
+
+        /**
+         * @brief 持有共享的处理器
+         * @param handler 通知处理器，为空时构造空的inline_handler
+         */
+        inline_handler(std::shared_ptr<notification_handler> handler) noexcept {
+            if (handler) {
+                store<shared_target>(std::move(handler));
+            }
+        }
+
+        inline_handler(const inline_handler &) = delete;
+        inline_handler &operator=(const inline_handler &) = delete;
+
+        inline_handler(inline_handler &&other) noexcept {
+            take(other);
+        }
+
+        inline_handler &operator=(inline_handler &&other) noexcept {
+            if (this != &other) {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~inline_handler() {
+            reset();
+        }
+
+        /**
+         * @brief 引用调用者持有的处理器，不获取所有权
+         * @param handler 通知处理器，必须在通知的生命周期内保持有效
+         */
+        static inline_handler borrow(const notification_handler &handler) noexcept {
+            inline_handler result;
+            result.store<borrowed_target>(&handler);
+            return result;
+        }
+
+        /**
+         * @brief 默认构造一个继承自notification_handler的处理器
+         * @tparam Handler 处理器类型
+         */
+        template <typename Handler>
+        static inline_handler make() {
+            static_assert(std::is_base_of_v<notification_handler, Handler>);
+            inline_handler result;
+            result.emplace<Handler>();
+            return result;
+        }
+
+        /**
+         * @brief 包装接受const notification_event &的仿函数
+         * @tparam Fx 仿函数类型
+         * @param fx 仿函数
+         */
+        template <typename Fx>
+        static inline_handler from_callable(Fx &&fx) {
+            inline_handler result;
+            result.emplace<std::decay_t<Fx>>(std::forward<Fx>(fx));
+            return result;
+        }
+
+        explicit operator bool() const noexcept {
+            return invoke_ != nullptr;
+        }
+
+        void activated(const activation &args) const {
+            invoke_(storage_, event_kind::activated, &args, {});
+        }
+
+        void dismissed(const notification_handler::dismissal_reason reason) const {
+            invoke_(storage_, event_kind::dismissed, nullptr, reason);
+        }
+
+        void failed() const {
+            invoke_(storage_, event_kind::failed, nullptr, {});
+        }
+
+    private:
+        enum class event_kind : unsigned char {
+            activated,
+            dismissed,
+            failed
+        };
+
+        using invoke_fn = void (*)(const void *storage, event_kind kind, const activation *args,
+                                   notification_handler::dismissal_reason reason);
+        using relocate_fn = void (*)(void *destination, void *source) noexcept; // destination为空时仅析构source
+
+        template <typename Ty>
+        struct value_target {
+            template <typename... Args>
+            explicit value_target(Args &&...args) : value(std::forward<Args>(args)...) {
+            }
+
+            const Ty &get() const noexcept {
+                return value;
+            }
+
+            Ty value;
+        };
+
+        template <typename Ty>
+        struct boxed_target {
+            template <typename... Args>
+            explicit boxed_target(Args &&...args) : value(std::make_unique<Ty>(std::forward<Args>(args)...)) {
+            }
+
+            const Ty &get() const noexcept {
+                return *value;
+            }
+
+            std::unique_ptr<Ty> value;
+        };
+
+        struct shared_target {
+            explicit shared_target(std::shared_ptr<notification_handler> handler) noexcept : handler(std::move(handler)) {
+            }
+
+            const notification_handler &get() const noexcept {
+                return *handler;
+            }
+
+            std::shared_ptr<notification_handler> handler;
+        };
+
+        struct borrowed_target {
+            explicit borrowed_target(const notification_handler *handler) noexcept : handler(handler) {
+            }
+
+            const notification_handler &get() const noexcept {
+                return *handler;
+            }
+
+            const notification_handler *handler;
+        };
+
+        template <typename Ty>
+        static constexpr bool fits_inline = sizeof(value_target<Ty>) <= inline_capacity &&
+                                            alignof(value_target<Ty>) <= alignof(std::max_align_t) &&
+                                            std::is_nothrow_move_constructible_v<Ty>;
+
+        template <typename Ty, typename... Args>
+        void emplace(Args &&...args) {
+            if constexpr (fits_inline<Ty>) {
+                store<value_target<Ty>>(std::forward<Args>(args)...);
+            } else {
+                store<boxed_target<Ty>>(std::forward<Args>(args)...);
+            }
+        }
+
+        template <typename Target, typename... Args>
+        void store(Args &&...args) {
+            static_assert(sizeof(Target) <= inline_capacity && alignof(Target) <= alignof(std::max_align_t));
+            ::new (static_cast<void *>(storage_)) Target(std::forward<Args>(args)...);
+            invoke_ = &invoke_target<Target>;
+            relocate_ = &relocate_target<Target>;
+        }
+
+        template <typename Target>
+        static void invoke_target(const void *storage, const event_kind kind, const activation *args,
+                                  const notification_handler::dismissal_reason reason) {
+            const auto &handler = std::launder(static_cast<const Target *>(storage))->get();
+            using handler_type = std::remove_cv_t<std::remove_reference_t<decltype(handler)>>;
+            if constexpr (std::is_base_of_v<notification_handler, handler_type>) {
+                // 派生类重写其他activated重载时会隐藏activated(const activation &)，因此经由基类调用
+                const notification_handler &target = handler;
+                switch (kind) {
+                    case event_kind::activated:
+                        target.activated(*args);
+                        break;
+                    case event_kind::dismissed:
+                        target.dismissed(reason);
+                        break;
+                    case event_kind::failed:
+                        target.failed();
+                        break;
                 }
-                if (context.is_win10_anniversary_or_higher()) {
-                    option |= state::is_win10_anniversary_or_higher;
+            } else {
+                using event_t = notification_event;
+                event_t event{event_t::event_type::failed, {}};
+                switch (kind) {
+                    case event_kind::activated: {
+                        std::optional<int> action_index;
+                        std::optional<std::wstring_view> reply;
+                        args->resolve(action_index, reply);
+                        event = {event_t::event_type::activated, {}, *args};
+                        if (reply) {
+                            event.type = event_t::event_type::activated_with_reply;
+                            event.data = *reply;
+                        } else if (action_index) {
+                            event.type = event_t::event_type::activated_with_action_idx;
+                            event.data = *action_index;
+                        }
+                        break;
+                    }
+                    case event_kind::dismissed:
+                        event = {event_t::event_type::dismissed, reason};
+                        break;
+                    case event_kind::failed:
+                        break;
                 }
+                handler(event);
             }
+        }
 
-            bool is_supporting_modern_features() const noexcept {
-                return option & state::is_supporting_modern_features;
+        template <typename Target>
+        static void relocate_target(void *destination, void *source) noexcept {
+            auto *target = std::launder(static_cast<Target *>(source));
+            if (destination) {
+                ::new (destination) Target(std::move(*target));
             }
+            target->~Target();
+        }
 
-            bool is_enable_modern_features() const noexcept {
-                return option & state::is_enable_modern_features;
+        void take(inline_handler &other) noexcept {
+            if (other.invoke_) {
+                other.relocate_(storage_, other.storage_);
+                invoke_ = std::exchange(other.invoke_, nullptr);
+                relocate_ = std::exchange(other.relocate_, nullptr);
             }
+        }
 
-            bool is_win10_anniversary_or_higher() const noexcept {
-                return option & state::is_win10_anniversary_or_higher;
+        void reset() noexcept {
+            if (invoke_) {
+                relocate_(nullptr, storage_);
+                invoke_ = nullptr;
+                relocate_ = nullptr;
             }
+        }
 
-        private:
-            int option;
+        alignas(std::max_align_t) unsigned char storage_[inline_capacity];
+        invoke_fn invoke_{nullptr};
+        relocate_fn relocate_{nullptr};
+    };
+}
+
+namespace rainy {
+    /**
+     * @brief 平台能力快照，由后端在notification::init()中探测一次，之后在每次show时经由context_bridge传递
+     */
+    struct platform_capabilities {
+        bool modern_features{false};       // 支持Modern Toast（Windows 10及以上）
+        bool win10_anniversary{false};     // Windows 10 Anniversary Update（14393）或更高版本
+        bool hero_image{false};            // 支持Hero Image
+        bool crop_circle{false};           // 支持图像的圆形裁剪
+        bool input_support{false};         // 支持输入框与回复操作
+    };
+}
+
+namespace rainy::utility {
+    struct context_bridge {
+        struct state {
+            static constexpr int placeholder = 0;
+            static constexpr int is_supporting_modern_features = 2;
+            static constexpr int is_enable_modern_features = 4;
+            static constexpr int is_win10_anniversary_or_higher = 8;
+            static constexpr int is_supporting_hero_image = 16;
+            static constexpr int is_supporting_crop_circle = 32;
+            static constexpr int is_supporting_input = 64;
         };
 
-        xml_notifcation_field(context_bridge ctx_bridge,const notification_template& notifcation_template);
+        /**
+         * @brief 从通知对象构造，使用其能力快照与现代特性开关
+         */
+        template <typename Notifcation, std::enable_if_t<!std::is_same_v<std::remove_cv_t<Notifcation>, context_bridge>, int> = 0>
+        context_bridge(Notifcation &context) : context_bridge(context.capabilities(), context.is_enable_modern_features()) {
+        }
 
-        operator winrt::Windows::Data::Xml::Dom::XmlDocument &() noexcept {
-            return xml;
+        /**
+         * @brief 从能力快照构造
+         * @param capabilities 平台能力快照
+         * @param enable_modern_features 是否启用现代特性
+         */
+        context_bridge(const platform_capabilities &capabilities, const bool enable_modern_features) noexcept : option() {
+            if (capabilities.modern_features) {
+                option |= state::is_supporting_modern_features;
+            }
+            if (enable_modern_features) {
+                option |= state::is_enable_modern_features;
+            }
+            if (capabilities.win10_anniversary) {
+                option |= state::is_win10_anniversary_or_higher;
+            }
+            if (capabilities.hero_image) {
+                option |= state::is_supporting_hero_image;
+            }
+            if (capabilities.crop_circle) {
+                option |= state::is_supporting_crop_circle;
+            }
+            if (capabilities.input_support) {
+                option |= state::is_supporting_input;
+            }
+        }
+
+        bool is_supporting_modern_features() const noexcept {
+            return option & state::is_supporting_modern_features;
+        }
+
+        bool is_enable_modern_features() const noexcept {
+            return option & state::is_enable_modern_features;
+        }
+
+        bool is_win10_anniversary_or_higher() const noexcept {
+            return option & state::is_win10_anniversary_or_higher;
+        }
+
+        bool is_supporting_hero_image() const noexcept {
+            return option & state::is_supporting_hero_image;
+        }
+
+        bool is_supporting_crop_circle() const noexcept {
+            return option & state::is_supporting_crop_circle;
+        }
+
+        bool is_supporting_input() const noexcept {
+            return option & state::is_supporting_input;
+        }
+
+        /**
+         * @brief 还原为能力快照
+         * @return 平台能力快照
+         */
+        platform_capabilities capabilities() const noexcept {
+            return {is_supporting_modern_features(), is_win10_anniversary_or_higher(), is_supporting_hero_image(),
+                    is_supporting_crop_circle(), is_supporting_input()};
+        }
+
+        /**
+         * @brief 获取全部状态位
+         * @return 由state中各个值组合而成的状态位
+         */
+        int options() const noexcept {
+            return option;
         }
 
-        void load_xml(const std::wstring_view xml_view) {
-            if (!xml_view.empty()) {
-                xml.LoadXml(winrt::hstring{xml_view});
-            }
-        }
+    private:
+        int option;
+    };
+
+    /**
+     * @brief 预编译的通知骨架
+     * @brief 由toast_xml_serializer::compile生成。骨架中只保留文本与图像路径等可变内容的插槽，渲染时仅需填充插槽
+     */
+    class compiled_toast_template {
+    public:
+        enum class slot_kind : std::uint8_t {
+            first_line,
+            second_line,
+            third_line,
+            attribution,
+            image,
+            hero_image
+        };
+
+        /**
+         * @brief 使用指定模板的可变内容填充插槽，并将完整的toast XML写入缓冲区
+         * @param notifcation_template 通知模板，必须与编译时的模板形状一致
+         * @param buffer 输出缓冲区，原有内容会被清空，但容量会被保留
+         */
+        void render(const notification_template &notifcation_template, std::wstring &buffer) const;
+
+        /**
+         * @brief 获取骨架中固定部分的长度
+         * @return 骨架长度（以wchar_t计）
+         */
+        RAINY_NODISCARD std::size_t skeleton_size() const noexcept {
+            return skeleton_.size();
+        }
+
+        /**
+         * @brief 获取骨架中的插槽数量
+         * @return 插槽数量
+         */
+        RAINY_NODISCARD std::size_t slots_count() const noexcept {
+            return slots_.size();
+        }
+
+        /**
+         * @brief 将指定插槽的内容按XML规则写入缓冲区
+         * @param buffer 输出缓冲区
+         * @param kind 插槽类型
+         * @param notifcation_template 提供插槽内容的通知模板
+         */
+        static void fill_slot(std::wstring &buffer, slot_kind kind, const notification_template &notifcation_template);
+
+    private:
+        friend class toast_xml_serializer;
+
+        struct slot {
+            std::size_t offset;
+            slot_kind kind;
+        };
+
+        std::wstring skeleton_{};
+        std::vector<slot> slots_{};
+    };
+
+    /**
+     * @brief 不依赖WinRT DOM的通知XML序列化器
+     * @brief 直接根据notification_template将toast XML写入一个预分配的std::wstring缓冲区，仅在最终交付时才需要XmlDocument::LoadXml
+     */
+    class toast_xml_serializer {
+    public:
+        /**
+         * @brief 以指定的上下文构造序列化器
+         * @param ctx_bridge 通知上下文，决定是否输出现代特性相关的节点
+         */
+        explicit toast_xml_serializer(context_bridge ctx_bridge) noexcept : ctx_bridge_(ctx_bridge) {
+        }
+
+        /**
+         * @brief 估算序列化指定模板所需的缓冲区大小（以wchar_t计）
+         * @param notifcation_template 通知模板
+         * @return 估算的字符数，用于一次性预分配缓冲区
+         */
+        RAINY_NODISCARD std::size_t estimate_size(const notification_template &notifcation_template) const noexcept;
+
+        /**
+         * @brief 将通知模板序列化到指定的缓冲区
+         * @param notifcation_template 通知模板
+         * @param buffer 输出缓冲区，原有内容会被清空，但容量会被保留
+         */
+        void serialize(const notification_template &notifcation_template, std::wstring &buffer) const;
+
+        /**
+         * @brief 将通知模板序列化为一个新的字符串
+         * @param notifcation_template 通知模板
+         * @return 序列化后的toast XML
+         */
+        RAINY_NODISCARD std::wstring serialize(const notification_template &notifcation_template) const;
+
+        /**
+         * @brief 将通知模板的形状编译为可复用的骨架
+         * @param notifcation_template 通知模板，其中的文本与图像路径不会被写入骨架
+         * @return 预编译的通知骨架
+         */
+        RAINY_NODISCARD compiled_toast_template compile(const notification_template &notifcation_template) const;
+
+        /**
+         * @brief 将编译期布局的通知模板序列化到指定的缓冲区，visual部分由编译期生成的片段拼接
+         * @param notifcation_template 通知模板
+         * @param buffer 输出缓冲区，原有内容会被清空，但容量会被保留
+         * @note 输出与以notifcation_template.get()调用serialize的结果相同
+         */
+        template <notification_template_type Type>
+        void serialize(const static_notification_template<Type> &notifcation_template, std::wstring &buffer) const;
+
+        /**
+         * @brief 将文本按XML规则转义后追加到缓冲区
+         * @param buffer 输出缓冲区
+         * @param text 需要转义的文本
+         */
+        static void append_escaped(std::wstring &buffer, std::wstring_view text);
+
+    private:
+        struct direct_writer;
+        struct compile_writer;
+
+        template <typename Writer>
+        void write(const notification_template &notifcation_template, Writer &writer) const;
+
+        template <typename Writer>
+        void write_open(const notification_template &notifcation_template, Writer &writer) const;
+
+        template <typename Writer>
+        void write_close(const notification_template &notifcation_template, Writer &writer) const;
+
+        context_bridge ctx_bridge_;
+    };
+
+    /**
+     * @brief 以通知模板形状为键的骨架缓存
+     * @brief 形状由模板类型、操作按钮、音频、场景等除文本与图像路径以外的内容决定。超出容量时淘汰最久未使用的骨架
+     */
+    class template_cache {
+    public:
+        struct statistics {
+            std::uint64_t hits;
+            std::uint64_t misses;
+            std::uint64_t evictions;
+            std::size_t size;
+            std::size_t capacity;
+        };
+
+        /**
+         * @brief 构造缓存
+         * @param capacity 最多缓存的骨架数量，为0时禁用缓存
+         */
+        explicit template_cache(std::size_t capacity = 32) : capacity_(capacity) {
+        }
+
+        template_cache(const template_cache &) = delete;
+        template_cache &operator=(const template_cache &) = delete;
+
+        /**
+         * @brief 将通知模板渲染为toast XML。形状命中时仅填充插槽，否则先编译骨架并加入缓存
+         * @param ctx_bridge 通知上下文
+         * @param notifcation_template 通知模板
+         * @param buffer 输出缓冲区
+         */
+        void render(context_bridge ctx_bridge, const notification_template &notifcation_template, std::wstring &buffer);
+
+        /**
+         * @brief 设置缓存容量，必要时立即淘汰多余的骨架
+         * @param capacity 最多缓存的骨架数量，为0时禁用缓存
+         */
+        void set_capacity(std::size_t capacity);
+
+        /**
+         * @brief 清空缓存，统计计数保持不变
+         */
+        void clear();
+
+        /**
+         * @brief 获取缓存的统计信息
+         * @return 命中、未命中、淘汰次数以及当前大小
+         */
+        RAINY_NODISCARD statistics stats() const;
+
+        /**
+         * @brief 生成通知模板的形状键
+         * @param ctx_bridge 通知上下文
+         * @param notifcation_template 通知模板
+         * @param key 输出的形状键，原有内容会被清空
+         */
+        static void make_shape_key(context_bridge ctx_bridge, const notification_template &notifcation_template, std::wstring &key);
+
+    private:
+        struct entry {
+            std::wstring key;
+            std::shared_ptr<const compiled_toast_template> compiled;
+        };
+
+        void evict_to(std::size_t capacity);
+
+        mutable std::mutex lock_;
+        std::size_t capacity_;
+        std::list<entry> lru_{};
+        std::unordered_map<std::wstring_view, std::list<entry>::iterator> index_{};
+        std::wstring key_buffer_{};
+        std::uint64_t hits_{0};
+        std::uint64_t misses_{0};
+        std::uint64_t evictions_{0};
+    };
+}
+
+namespace rainy::utility {
+    /**
+     * @brief 通知ID生成器
+     * @brief 生成的ID为正的64位整数：高15位为实例标签，低48位为单调递增的计数器。
+     * @brief 实例标签在同时存在的实例之间唯一，实例析构后归还并可被之后创建的实例复用。
+     * @brief 因此同一实例生成的ID单调递增，同时存在的实例（不超过32768个）之间不会冲突
+     */
+    class id_generator {
+    public:
+        id_generator() noexcept;
+
+        ~id_generator();
+
+        id_generator(const id_generator &) = delete;
+        id_generator &operator=(const id_generator &) = delete;
+
+        /**
+         * @brief 生成下一个ID
+         * @return 正的64位ID
+         */
+        std::int64_t next() noexcept {
+            const std::uint64_t counter = counter_.fetch_add(1, std::memory_order_relaxed) & counter_mask;
+            return static_cast<std::int64_t>(tag_ | counter);
+        }
+
+        /**
+         * @brief 获取实例标签
+         * @return 位于ID高位的实例标签
+         */
+        RAINY_NODISCARD std::uint64_t tag() const noexcept {
+            return tag_ >> counter_bits;
+        }
+
+    private:
+        static constexpr int counter_bits = 48;
+        static constexpr std::uint64_t counter_mask = (std::uint64_t{1} << counter_bits) - 1;
+
+        std::uint64_t tag_;
+        std::atomic<std::uint64_t> counter_{1};
+    };
+}
+
+namespace rainy::utility {
+    /**
+     * @brief 有界的多生产者多消费者队列
+     * @brief 基于环形缓冲区，每个单元带有序号，入队与出队各只需一次CAS，不会分配内存
+     * @tparam Ty 元素类型，必须可默认构造且可移动
+     */
+    template <typename Ty>
+    class bounded_queue {
+    public:
+        /**
+         * @brief 构造队列
+         * @param capacity 容量，会向上取整为2的幂
+         */
+        explicit bounded_queue(const std::size_t capacity) : mask_(round_up(capacity) - 1), cells_(new cell[mask_ + 1]) {
+            for (std::size_t i = 0; i <= mask_; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bounded_queue(const bounded_queue &) = delete;
+        bounded_queue &operator=(const bounded_queue &) = delete;
+
+        /**
+         * @brief 尝试入队
+         * @param value 元素
+         * @return 队列已满时返回false，此时value保持不变
+         */
+        template <typename Uty>
+        bool try_push(Uty &&value) {
+            std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+            for (;;) {
+                cell &target = cells_[position & mask_];
+                const std::size_t sequence = target.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (diff == 0) {
+                    if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        target.value = std::forward<Uty>(value);
+                        target.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    position = enqueue_position_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief 尝试出队
+         * @param value 输出的元素
+         * @return 队列为空时返回false
+         */
+        bool try_pop(Ty &value) {
+            std::size_t position = dequeue_position_.load(std::memory_order_relaxed);
+            for (;;) {
+                cell &target = cells_[position & mask_];
+                const std::size_t sequence = target.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+                if (diff == 0) {
+                    if (dequeue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        value = std::move(target.value);
+                        target.sequence.store(position + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    position = dequeue_position_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief 获取队列中元素数量的近似值
+         * @return 并发修改时可能不精确
+         */
+        RAINY_NODISCARD std::size_t size_approx() const noexcept {
+            const std::size_t enqueued = enqueue_position_.load(std::memory_order_relaxed);
+            const std::size_t dequeued = dequeue_position_.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        RAINY_NODISCARD std::size_t capacity() const noexcept {
+            return mask_ + 1;
+        }
+
+    private:
+        struct cell {
+            std::atomic<std::size_t> sequence{0};
+            Ty value{};
+        };
+
+        static std::size_t round_up(const std::size_t capacity) noexcept {
+            std::size_t result = 2;
+            while (result < capacity) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        const std::size_t mask_;
+        std::unique_ptr<cell[]> cells_;
+        alignas(64) std::atomic<std::size_t> enqueue_position_{0};
+        alignas(64) std::atomic<std::size_t> dequeue_position_{0};
+    };
+}
+
+namespace rainy::utility {
+    /**
+     * @brief 以通知ID为键的并发注册表
+     * @brief 采用开放寻址，每个槽位带有一个控制字：高32位为代数（generation），其余为引用计数与状态。
+     * @brief 查找、访问与移除不加锁；插入之间互斥以保证同一ID只会插入一次，扩容时另行短暂加锁。移除时若仍有访问者持有引用，则由最后一个访问者负责析构，
+     * @brief 因此可以在任意线程（包括事件回调线程）上移除条目
+     * @tparam Ty 条目类型
+     */
+    template <typename Ty>
+    class notification_registry {
+    public:
+        /**
+         * @brief 构造注册表
+         * @param initial_capacity 初始槽位数，会向上取整为2的幂
+         */
+        explicit notification_registry(std::size_t initial_capacity = 256) : head_(round_up(initial_capacity)), tail_(&head_) {
+        }
+
+        ~notification_registry() {
+            for (table *t = &head_; t; t = t->next.load(std::memory_order_acquire)) {
+                for (std::size_t i = 0; i <= t->mask; ++i) {
+                    const std::uint64_t state = t->slots[i].control.load(std::memory_order_acquire) & state_mask;
+                    if (state == state_live || state == state_retiring) {
+                        t->slots[i].value().~Ty();
+                    }
+                }
+            }
+            for (table *t = head_.next.load(std::memory_order_acquire); t;) {
+                table *next = t->next.load(std::memory_order_acquire);
+                delete t;
+                t = next;
+            }
+        }
+
+        notification_registry(const notification_registry &) = delete;
+        notification_registry &operator=(const notification_registry &) = delete;
+
+        /**
+         * @brief 以id为键原位构造条目
+         * @param id 通知ID
+         * @param args 构造参数，仅在确实插入时才会被使用
+         * @return 如果id已存在，返回false
+         * @attention 插入之间互斥，查找、访问与移除仍然无锁。否则两个线程可能同时确认同一ID不存在，并各自插入一个条目
+         */
+        template <typename... Args>
+        bool emplace(const std::int64_t id, Args &&...args) {
+            std::lock_guard<std::mutex> guard(insert_lock_);
+            if (slot *existing = acquire(id)) {
+                release(*existing);
+                return false;
+            }
+            for (;;) {
+                table *t = tail_.load(std::memory_order_acquire);
+                if (t->live.load(std::memory_order_relaxed) < (t->mask + 1) / 2 && try_emplace(*t, id, std::forward<Args>(args)...)) {
+                    size_.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                grow(t, (t->mask + 1) * 2);
+            }
+        }
+
+        /**
+         * @brief 在持有条目引用的情况下访问条目。访问期间条目可以被移除，但要等到访问结束后才会析构
+         * @param id 通知ID
+         * @param fx 访问函数，接受Ty &
+         * @return 如果id不存在，返回false
+         * @attention 同一条目可能被多个线程同时访问，fx对条目的修改需要自行保证线程安全
+         */
+        template <typename Fx>
+        bool visit(const std::int64_t id, Fx &&fx) {
+            slot *target = acquire(id);
+            if (!target) {
+                return false;
+            }
+            const release_guard guard{this, target};
+            fx(target->value());
+            return true;
+        }
+
+        /**
+         * @brief 移除条目
+         * @param id 通知ID
+         * @return 如果id不存在（或已被移除），返回false
+         */
+        bool erase(const std::int64_t id) noexcept {
+            const std::size_t hashed = hash(id);
+            for (table *t = &head_; t; t = t->next.load(std::memory_order_acquire)) {
+                if (!t->may_contain(id)) {
+                    continue;
+                }
+                for (std::size_t probe = 0; probe <= t->max_probe.load(std::memory_order_acquire); ++probe) {
+                    slot &s = t->slots[(hashed + probe) & t->mask];
+                    std::uint64_t control = s.control.load(std::memory_order_acquire);
+                    if ((control & state_mask) == state_empty) {
+                        break;
+                    }
+                    while ((control & state_mask) == state_live && s.key.load(std::memory_order_relaxed) == id) {
+                        if (s.control.compare_exchange_weak(control, (control & ~state_mask) | state_retiring,
+                                                            std::memory_order_acq_rel, std::memory_order_acquire)) {
+                            t->live.fetch_sub(1, std::memory_order_relaxed);
+                            size_.fetch_sub(1, std::memory_order_relaxed);
+                            if ((control & refs_mask) == 0) {
+                                reclaim(s);
+                            }
+                            return true;
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 仅当条目满足条件时才移除。判断期间持有条目的引用，因此不会误删同一ID的新条目以外的对象
+         * @param id 通知ID
+         * @param pred 判断函数，接受Ty &
+         * @return 如果条目被移除，返回true
+         */
+        template <typename Pred>
+        bool erase_if(const std::int64_t id, Pred &&pred) {
+            table *owner = nullptr;
+            slot *target = acquire(id, &owner);
+            if (!target) {
+                return false;
+            }
+            const release_guard guard{this, target};
+            if (!pred(target->value())) {
+                return false;
+            }
+            // 持有引用时槽位不会被回收，状态仍为live即说明仍是同一条目
+            std::uint64_t control = target->control.load(std::memory_order_acquire);
+            while ((control & state_mask) == state_live) {
+                if (target->control.compare_exchange_weak(control, (control & ~state_mask) | state_retiring, std::memory_order_acq_rel,
+                                                          std::memory_order_acquire)) {
+                    owner->live.fetch_sub(1, std::memory_order_relaxed);
+                    size_.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 为即将插入的条目预留空间，避免在插入过程中扩容
+         * @param additional 即将插入的条目数
+         */
+        void reserve(const std::size_t additional) {
+            table *t = tail_.load(std::memory_order_acquire);
+            const std::size_t required = t->live.load(std::memory_order_relaxed) + additional;
+            if (required >= (t->mask + 1) / 2) {
+                grow(t, required * 2);
+            }
+        }
+
+        /**
+         * @brief 依次访问所有条目
+         * @param fx 访问函数，接受(std::int64_t id, Ty &)
+         * @attention 遍历期间插入或移除的条目可能被访问到，也可能不会
+         */
+        template <typename Fx>
+        void for_each(Fx &&fx) {
+            for (table *t = &head_; t; t = t->next.load(std::memory_order_acquire)) {
+                for (std::size_t i = 0; i <= t->mask; ++i) {
+                    slot &s = t->slots[i];
+                    std::uint64_t control = s.control.load(std::memory_order_acquire);
+                    while ((control & state_mask) == state_live) {
+                        if (s.control.compare_exchange_weak(control, control + ref_one, std::memory_order_acq_rel,
+                                                            std::memory_order_acquire)) {
+                            const release_guard guard{this, &s};
+                            fx(s.key.load(std::memory_order_relaxed), s.value());
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief 获取条目数量
+         * @return 当前未被移除的条目数量
+         */
+        RAINY_NODISCARD std::size_t size() const noexcept {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr std::uint64_t state_mask = 0x7;
+        static constexpr std::uint64_t state_empty = 0; // 从未被使用，探测到此即可停止
+        static constexpr std::uint64_t state_constructing = 1;
+        static constexpr std::uint64_t state_live = 2;
+        static constexpr std::uint64_t state_retiring = 3; // 已移除，等待最后一个访问者析构
+        static constexpr std::uint64_t state_free = 4;     // 曾被使用，可以复用
+        static constexpr std::uint64_t ref_one = 0x8;
+        static constexpr std::uint64_t refs_mask = 0xFFFFFFF8;
+        static constexpr std::uint64_t generation_mask = 0xFFFFFFFF00000000;
+        static constexpr std::uint64_t generation_one = 0x100000000;
+        static constexpr std::size_t max_insert_probe = 32;
+
+        struct slot {
+            std::atomic<std::uint64_t> control{0};
+            std::atomic<std::int64_t> key{0};
+            alignas(Ty) unsigned char storage[sizeof(Ty)];
+
+            Ty &value() noexcept {
+                return *std::launder(reinterpret_cast<Ty *>(storage));
+            }
+        };
+
+        struct table {
+            explicit table(const std::size_t capacity) : mask(capacity - 1), slots(new slot[capacity]) {
+            }
+
+            const std::size_t mask;
+            std::unique_ptr<slot[]> slots;
+            std::atomic<std::size_t> live{0};
+            std::atomic<std::size_t> max_probe{0}; // 插入时用到的最长探测距离，查找不会超过它
+            std::atomic<table *> next{nullptr};
+            // 曾插入过的键的范围。插入只发生在最新的表上，生成的ID单调递增，因此旧表的范围互不重叠，查找可以直接跳过
+            std::atomic<std::int64_t> min_key{(std::numeric_limits<std::int64_t>::max)()};
+            std::atomic<std::int64_t> max_key{(std::numeric_limits<std::int64_t>::min)()};
+
+            bool may_contain(const std::int64_t id) const noexcept {
+                return id >= min_key.load(std::memory_order_acquire) && id <= max_key.load(std::memory_order_acquire);
+            }
+        };
+
+        struct release_guard {
+            notification_registry *self;
+            slot *target;
+
+            ~release_guard() {
+                self->release(*target);
+            }
+        };
+
+        static std::size_t round_up(const std::size_t capacity) noexcept {
+            std::size_t result = 16;
+            while (result < capacity) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        static std::size_t hash(const std::int64_t id) noexcept {
+            auto value = static_cast<std::uint64_t>(id);
+            value ^= value >> 30;
+            value *= 0xBF58476D1CE4E5B9ull;
+            value ^= value >> 27;
+            value *= 0x94D049BB133111EBull;
+            value ^= value >> 31;
+            return static_cast<std::size_t>(value);
+        }
+
+        slot *acquire(const std::int64_t id, table **owner = nullptr) noexcept {
+            const std::size_t hashed = hash(id);
+            for (table *t = &head_; t; t = t->next.load(std::memory_order_acquire)) {
+                if (!t->may_contain(id)) {
+                    continue;
+                }
+                for (std::size_t probe = 0; probe <= t->max_probe.load(std::memory_order_acquire); ++probe) {
+                    slot &s = t->slots[(hashed + probe) & t->mask];
+                    std::uint64_t control = s.control.load(std::memory_order_acquire);
+                    if ((control & state_mask) == state_empty) {
+                        break;
+                    }
+                    // 代数不变时键不会变化，因此CAS成功即说明读到的键属于当前条目
+                    while ((control & state_mask) == state_live && s.key.load(std::memory_order_relaxed) == id) {
+                        if (s.control.compare_exchange_weak(control, control + ref_one, std::memory_order_acq_rel,
+                                                            std::memory_order_acquire)) {
+                            if (owner) {
+                                *owner = t;
+                            }
+                            return &s;
+                        }
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        void release(slot &s) noexcept {
+            const std::uint64_t previous = s.control.fetch_sub(ref_one, std::memory_order_acq_rel);
+            if ((previous & state_mask) == state_retiring && (previous & refs_mask) == ref_one) {
+                reclaim(s);
+            }
+        }
+
+        static void reclaim(slot &s) noexcept {
+            const std::uint64_t control = s.control.load(std::memory_order_acquire);
+            s.value().~Ty();
+            s.control.store(((control & generation_mask) + generation_one) | state_free, std::memory_order_release);
+        }
+
+        template <typename... Args>
+        static bool try_emplace(table &t, const std::int64_t id, Args &&...args) {
+            const std::size_t hashed = hash(id);
+            for (std::size_t probe = 0; probe <= max_insert_probe && probe <= t.mask; ++probe) {
+                slot &s = t.slots[(hashed + probe) & t.mask];
+                std::uint64_t control = s.control.load(std::memory_order_acquire);
+                const std::uint64_t state = control & state_mask;
+                if (state != state_empty && state != state_free) {
+                    continue;
+                }
+                if (!s.control.compare_exchange_strong(control, (control & generation_mask) | state_constructing,
+                                                       std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    continue;
+                }
+                s.key.store(id, std::memory_order_relaxed);
+                // 插入之间互斥，范围只会扩大；先于条目发布，查找在看到条目之前不会因范围而跳过它
+                if (id < t.min_key.load(std::memory_order_relaxed)) {
+                    t.min_key.store(id, std::memory_order_release);
+                }
+                if (id > t.max_key.load(std::memory_order_relaxed)) {
+                    t.max_key.store(id, std::memory_order_release);
+                }
+                try {
+                    ::new (static_cast<void *>(s.storage)) Ty(std::forward<Args>(args)...);
+                } catch (...) {
+                    s.control.store((control & generation_mask) | state_free, std::memory_order_release);
+                    throw;
+                }
+                std::size_t max_probe = t.max_probe.load(std::memory_order_relaxed);
+                while (max_probe < probe && !t.max_probe.compare_exchange_weak(max_probe, probe, std::memory_order_release)) {
+                }
+                t.live.fetch_add(1, std::memory_order_relaxed);
+                s.control.store((control & generation_mask) | state_live, std::memory_order_release);
+                return true;
+            }
+            return false;
+        }
+
+        void grow(table *full, const std::size_t capacity) {
+            std::lock_guard<std::mutex> guard(grow_lock_);
+            if (tail_.load(std::memory_order_acquire) != full) {
+                return; // 其他线程已完成扩容
+            }
+            auto *next = new table(round_up(capacity));
+            full->next.store(next, std::memory_order_release);
+            tail_.store(next, std::memory_order_release);
+        }
+
+        table head_;
+        std::atomic<table *> tail_;
+        std::mutex insert_lock_;
+        std::mutex grow_lock_;
+        std::atomic<std::size_t> size_{0};
+    };
+}
+
+namespace rainy::utility {
+    /**
+     * @brief 准入策略
+     */
+    struct admission_policy {
+        double rate{0.0};                               // 每秒补充的令牌数，为0时不限流
+        double burst{1.0};                              // 令牌桶容量，即允许的突发数量
+        bool per_key{false};                            // 为true时每个合并键使用独立的令牌桶，否则整个应用共享一个
+        std::chrono::milliseconds coalescing_window{0}; // 合并窗口，为0时不合并
+    };
+
+    /**
+     * @brief 位于show之前的准入控制：令牌桶限流与按键合并
+     * @brief 合并窗口内，具有相同合并键的第一条通知立即显示，其余通知只计数并保留最后一个模板。
+     * @brief 窗口结束时，若有被合并的通知，则以最后一个模板（第一行附加" (+N)"）替换最初显示的通知
+     */
+    class admission_controller {
+    public:
+        using clock_function = std::function<std::chrono::steady_clock::time_point()>;
+
+        enum class decision {
+            admit,   // 放行
+            open,    // 放行并开启合并窗口，调用者必须在显示后调用opened
+            merge,   // 已合并到窗口内的通知
+            suppress // 被限流
+        };
+
+        struct statistics {
+            std::uint64_t admitted{0};         // 放行的数量
+            std::uint64_t suppressed{0};       // 被限流的数量
+            std::uint64_t merged{0};           // 被合并的数量
+            std::uint64_t summaries{0};        // 窗口结束时显示的汇总通知数量
+            std::uint64_t summary_failures{0}; // 显示失败的汇总通知数量
+        };
+
+        struct summary {
+            notification_template notification;           // 已附加计数的模板
+            internals::inline_handler handler;             // 最后一个被合并的通知的处理器
+            std::int64_t replaced_id;                      // 需要被替换的通知ID
+        };
+
+        /**
+         * @brief 构造准入控制
+         * @param clock 时钟，为空时使用std::chrono::steady_clock::now
+         */
+        explicit admission_controller(clock_function clock = {});
+
+        admission_controller(const admission_controller &) = delete;
+        admission_controller &operator=(const admission_controller &) = delete;
+
+        /**
+         * @brief 设置准入策略，令牌桶与未结束的合并窗口会被重置
+         * @param policy 准入策略
+         */
+        void set_policy(const admission_policy &policy);
+
+        /**
+         * @brief 替换时钟，用于测试
+         * @param clock 时钟，为空时使用std::chrono::steady_clock::now
+         */
+        void set_clock(clock_function clock);
+
+        /**
+         * @brief 检查是否启用了限流或合并
+         * @return 未启用时调用者可以跳过准入检查
+         */
+        RAINY_NODISCARD bool is_enabled() const noexcept {
+            return enabled_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief 对一条通知做出准入决定
+         * @param notification 通知模板
+         * @param handler 通知处理器。合并时与窗口中保存的处理器交换，用于汇总通知；调用者取回被替换的处理器（第一次合并时为空），
+         * 该处理器不会再收到平台事件，应以application_hidden结束。其余情况下保持不变
+         * @param coalesced_id 合并时输出窗口内最初显示的通知ID
+         * @return 准入决定。窗口内最初的通知尚未显示完成时，同键通知不合并而是直接放行，因此merge总是带有有效的ID
+         */
+        decision admit(const notification_template &notification, internals::inline_handler &handler,
+                       std::int64_t &coalesced_id);
+
+        /**
+         * @brief 登记合并窗口内最初显示的通知
+         * @param key 合并键
+         * @param id 通知ID，显示失败时为-1，此时窗口被关闭
+         * @return 显示失败时窗口中保存的处理器（可能为空），不会再收到平台事件，调用者应以failed结束
+         */
+        RAINY_NODISCARD internals::inline_handler opened(std::wstring_view key, std::int64_t id);
+
+        /**
+         * @brief 关闭已结束的合并窗口，并输出需要显示的汇总通知
+         * @param summaries 输出的汇总通知，追加到末尾
+         */
+        void collect_expired(std::vector<summary> &summaries);
+
+        /**
+         * @brief 记录一次汇总通知显示失败
+         */
+        void summary_failed();
+
+        /**
+         * @brief 获取统计信息
+         * @return 放行、限流、合并与汇总的数量
+         */
+        RAINY_NODISCARD statistics stats() const;
+
+    private:
+        using time_point = std::chrono::steady_clock::time_point;
+
+        struct string_hash {
+            using is_transparent = void;
+
+            std::size_t operator()(std::wstring_view key) const noexcept {
+                return std::hash<std::wstring_view>{}(key);
+            }
+        };
+
+        struct bucket {
+            double tokens;
+            time_point last;
+        };
+
+        struct window {
+            time_point opened;
+            std::int64_t id{-1};
+            std::uint64_t merged{0};
+            std::optional<notification_template> latest{};
+            internals::inline_handler handler{};
+        };
+
+        time_point now() const;
+        bool take_token(std::wstring_view key, time_point now);
+
+        mutable std::mutex lock_;
+        clock_function clock_;
+        admission_policy policy_{};
+        std::atomic<bool> enabled_{false};
+        bucket app_bucket_{};
+        std::unordered_map<std::wstring, bucket, string_hash, std::equal_to<>> buckets_{};
+        std::unordered_map<std::wstring, window, string_hash, std::equal_to<>> windows_{};
+        statistics stats_{};
+    };
+
+    /**
+     * @brief 分层时间轮。4层、每层256个槽，覆盖2^32个tick，更远的定时器在最高层每转一圈时重新放置
+     * @brief 插入与取消都是O(1)：节点保存在连续的数组中，以下标组成的双向链表挂在槽上，取消时直接摘除。
+     * @brief advance跳过空槽，因此长时间未推进也不会逐tick遍历。不是线程安全的，由调用者加锁
+     */
+    class timer_wheel {
+    public:
+        using timer_id = std::uint64_t; // 低32位为节点下标加1，高32位为节点的代数，节点复用后旧ID失效
+
+        static constexpr timer_id invalid_timer = 0;
+
+        /**
+         * @brief 构造时间轮
+         * @param now 当前tick
+         */
+        explicit timer_wheel(std::uint64_t now = 0) noexcept;
+
+        /**
+         * @brief 插入定时器
+         * @param deadline 到期的tick，不晚于当前tick时在下一次推进时到期
+         * @param value 到期时输出的值
+         * @return 定时器ID，用于取消
+         */
+        timer_id insert(std::uint64_t deadline, std::int64_t value);
+
+        /**
+         * @brief 取消定时器
+         * @param timer 由insert返回的ID
+         * @return 定时器已到期、已取消或ID无效时返回false
+         */
+        bool cancel(timer_id timer) noexcept;
+
+        /**
+         * @brief 推进到指定的tick，并输出期间到期的全部定时器的值。同一tick内到期的定时器按插入顺序输出
+         * @param now 目标tick，早于当前tick时不做任何事
+         * @param expired 到期的值，追加到末尾
+         */
+        void advance(std::uint64_t now, std::vector<std::int64_t> &expired);
+
+        /**
+         * @brief 获取下一次需要推进的tick，可能早于实际最早的到期时间（需要降级较远的定时器时），但不会晚于它
+         * @return 没有定时器时返回std::nullopt
+         */
+        RAINY_NODISCARD std::optional<std::uint64_t> next_expiry() const noexcept;
+
+        /**
+         * @brief 移除全部定时器，已分配的节点保留以供复用
+         */
+        void clear() noexcept;
+
+        RAINY_NODISCARD std::size_t size() const noexcept {
+            return size_;
+        }
+
+        RAINY_NODISCARD std::uint64_t now() const noexcept {
+            return now_;
+        }
+
+    private:
+        static constexpr unsigned slot_bits = 8;
+        static constexpr unsigned slot_count = 1u << slot_bits;
+        static constexpr unsigned level_count = 4;
+        static constexpr std::uint32_t npos = 0xFFFFFFFF;
+
+        struct node {
+            std::uint64_t deadline{0};
+            std::int64_t value{0};
+            std::uint32_t prev{npos};
+            std::uint32_t next{npos};
+            std::uint32_t generation{1};
+            std::uint32_t slot{npos}; // 所在的槽（层号*256+槽号），空闲时为npos
+        };
+
+        void place(std::uint32_t index);
+        void link(std::uint32_t index, std::uint32_t slot) noexcept;
+        void unlink(std::uint32_t index) noexcept;
+        void release(std::uint32_t index) noexcept;
+        std::uint32_t take_slot(std::uint32_t slot) noexcept;
+        void process(std::uint64_t tick, std::vector<std::int64_t> &expired);
+        std::optional<std::uint64_t> next_slot_tick(unsigned level) const noexcept;
+
+        std::uint64_t now_;
+        std::size_t size_{0};
+        std::vector<node> nodes_{};
+        std::vector<std::uint32_t> free_{};
+        std::array<std::uint32_t, level_count * slot_count> heads_{};
+        std::array<std::uint32_t, level_count * slot_count> tails_{};
+        std::array<std::uint64_t, level_count * slot_count / 64> occupied_{}; // 非空槽的位图
+    };
+
+    /**
+     * @brief 按Tag/Group索引已显示的通知，使按组或按Tag移除时无需遍历全部通知
+     * @brief 仅登记设置了Tag或Group的通知。同一Group内Tag唯一，与平台的替换语义一致
+     */
+    class toast_group_index {
+    public:
+        /**
+         * @brief 登记通知
+         * @param id 通知ID
+         * @param tag Tag，可为空
+         * @param group Group，可为空
+         * @return 具有相同Tag与Group、因此被替换的通知ID，不存在时为-1
+         */
+        std::int64_t insert(std::int64_t id, std::wstring_view tag, std::wstring_view group);
+
+        /**
+         * @brief 移除通知的登记，未登记时不做任何事
+         * @param id 通知ID
+         */
+        void erase(std::int64_t id);
+
+        /**
+         * @brief 移除并返回指定组中的全部通知
+         * @param group 组
+         * @return 通知ID
+         */
+        std::vector<std::int64_t> take_group(std::wstring_view group);
+
+        /**
+         * @brief 移除并返回指定Tag与Group的通知
+         * @param tag Tag
+         * @param group 组，可为空
+         * @return 通知ID，不存在时为-1
+         */
+        std::int64_t take_tag(std::wstring_view tag, std::wstring_view group);
+
+        /**
+         * @brief 移除全部登记
+         */
+        void clear();
+
+        /**
+         * @brief 获取已登记的通知数量
+         * @return 已登记的通知数量
+         */
+        RAINY_NODISCARD std::size_t size() const;
+
+    private:
+        struct string_hash {
+            using is_transparent = void;
+
+            std::size_t operator()(std::wstring_view key) const noexcept {
+                return std::hash<std::wstring_view>{}(key);
+            }
+        };
+
+        struct entry {
+            std::wstring tag;
+            std::wstring group;
+        };
+
+        void make_tag_key(std::wstring_view tag, std::wstring_view group);
+        void unlink(std::int64_t id, const entry &value);
+
+        mutable std::mutex lock_;
+        std::unordered_map<std::int64_t, entry> entries_{};
+        std::unordered_map<std::wstring, std::unordered_set<std::int64_t>, string_hash, std::equal_to<>> groups_{};
+        std::unordered_map<std::wstring, std::int64_t, string_hash, std::equal_to<>> tags_{}; // 键由Group与Tag拼接而成
+        std::wstring key_buffer_{};
+    };
+
+    /**
+     * @brief 显示流程中被计时的阶段
+     */
+    enum class pipeline_phase : std::uint8_t {
+        validate,         // 校验Tag、Group与调用者指定的ID
+        render,           // 构建XML
+        registry_insert,  // 登记处理器并插入注册表
+        acquire_notifier, // 获取通知器，由后端回报，包含在show之内
+        show,             // 调用后端显示，show_batch的整批提交不计入
+        register_events,  // 注册事件回调，由后端回报，包含在show之内
+        total             // show()从调用到返回
+    };
+
+    inline constexpr std::size_t pipeline_phase_count = static_cast<std::size_t>(pipeline_phase::total) + 1;
+
+    // 新增事件类型时须保持failed为最后一项，metrics的计数数组按此定长
+    inline constexpr std::size_t notification_event_type_count = static_cast<std::size_t>(notification_event::event_type::failed) + 1;
+
+    /**
+     * @brief 无锁的对数-线性（HDR风格）延迟直方图，单位为纳秒。小于32的值逐一计数，
+     * @brief 其余每个2的幂区间再分为16个子桶，分位数的相对误差不超过1/16。记录只需几次relaxed原子操作，可以在任意线程上并发进行
+     */
+    class latency_histogram {
+    public:
+        struct summary {
+            std::uint64_t count{0};
+            std::uint64_t total_ns{0};
+            std::uint64_t max_ns{0};
+            std::uint64_t p50_ns{0};
+            std::uint64_t p90_ns{0};
+            std::uint64_t p99_ns{0};
+            std::uint64_t p999_ns{0};
+        };
+
+        void record(std::uint64_t nanoseconds) noexcept;
+
+        /**
+         * @brief 汇总当前的记录。并发记录时得到的是近似一致的结果
+         */
+        RAINY_NODISCARD summary summarize() const noexcept;
+
+    private:
+        static constexpr unsigned sub_bucket_bits = 4;
+        static constexpr std::uint64_t linear_limit = 2u << sub_bucket_bits;
+        static constexpr unsigned max_exponent = 40; // 约18分钟，更长的值计入最后一个桶
+        static constexpr std::size_t bucket_count = linear_limit + (max_exponent - sub_bucket_bits) * (1u << sub_bucket_bits);
+
+        static std::size_t bucket_of(std::uint64_t value) noexcept;
+        static std::uint64_t bucket_upper(std::size_t bucket) noexcept;
+
+        std::array<std::atomic<std::uint64_t>, bucket_count> buckets_{};
+        std::atomic<std::uint64_t> total_{0};
+        std::atomic<std::uint64_t> max_{0};
+    };
+
+    /**
+     * @brief notification::metrics()返回的快照。计数器自构造起单调递增，仪表为读取时的瞬时值
+     */
+    struct metrics_snapshot {
+        bool enabled{false}; // 定义了RAINY_NOTIFICATION_NO_METRICS时为false，此时直方图与计数器均为0，仪表仍然有效
+        std::array<latency_histogram::summary, pipeline_phase_count> phases{};
+        std::array<std::uint64_t, notification_event_type_count> events{}; // 按notification_event::event_type索引，只统计实际交给处理器的事件
+        std::uint64_t shown{0};
+        std::uint64_t show_failures{0};
+        std::uint64_t evicted{0};
+        std::uint64_t expired{0};
+        std::size_t live{0};            // 已显示或正在显示的通知
+        std::size_t registered{0};      // 注册表中尚未回收的条目
+        std::size_t scheduled{0};       // 进程内计划通知
+        std::size_t retired_backlog{0}; // 等待回收的条目
+        std::size_t pending_events{0};  // 等待投递的事件
+        std::array<std::size_t, notification_template::priority_levels> async_depth{}; // 按优先级索引的异步显示队列深度
+
+        RAINY_NODISCARD const latency_histogram::summary &phase(const pipeline_phase which) const noexcept {
+            return phases[static_cast<std::size_t>(which)];
+        }
+
+        RAINY_NODISCARD std::uint64_t event_count(const notification_event::event_type type) const noexcept {
+            return events[static_cast<std::size_t>(type)];
+        }
+    };
+
+    /**
+     * @brief 显示流程的计数器与各阶段的延迟直方图
+     */
+    class pipeline_metrics {
+    public:
+        enum class counter : std::uint8_t {
+            shown,
+            show_failures,
+            evicted,
+            expired // 新增计数器时须保持为最后一项
+        };
+
+        static constexpr std::size_t counter_count = static_cast<std::size_t>(counter::expired) + 1;
+
+        void record(const pipeline_phase phase, const std::chrono::nanoseconds elapsed) noexcept {
+            phases_[static_cast<std::size_t>(phase)].record(elapsed.count() > 0 ? static_cast<std::uint64_t>(elapsed.count()) : 0);
+        }
+
+        void count(const counter which) noexcept {
+            counters_[static_cast<std::size_t>(which)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void count(const notification_event::event_type type) noexcept {
+            events_[static_cast<std::size_t>(type)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 将直方图与计数器写入快照，不修改仪表
+         */
+        void fill(metrics_snapshot &snapshot) const noexcept;
+
+    private:
+        std::array<latency_histogram, pipeline_phase_count> phases_{};
+        std::array<std::atomic<std::uint64_t>, notification_event_type_count> events_{};
+        std::array<std::atomic<std::uint64_t>, counter_count> counters_{};
+    };
+}
+
+namespace rainy::utility {
+    /**
+     * @brief 比较绑定值的当前状态与新值，收集需要推送的项
+     * @param current 当前已推送的绑定值
+     * @param values 新值
+     * @param changed 输出与当前值不同的项，原有内容会被清空
+     * @return 若values中存在current未声明的键，返回false
+     */
+    bool diff_bindings(std::span<const notification_template::data_binding> current,
+                       std::span<const notification_template::data_binding> values,
+                       std::vector<notification_template::data_binding> &changed);
+
+    /**
+     * @brief 将已推送成功的项写回当前状态
+     * @param current 当前已推送的绑定值
+     * @param changed 由diff_bindings得到的变化项
+     */
+    void apply_bindings(std::span<notification_template::data_binding> current,
+                        std::span<const notification_template::data_binding> changed);
+}
+
+#ifdef _WIN32
+namespace rainy::utility {
+    class xml_notifcation_field {
+    public:
+        using context_bridge = utility::context_bridge;
+
+        xml_notifcation_field(context_bridge ctx_bridge,const notification_template& notifcation_template);
+
+        /**
+         * @brief 直接从已序列化的toast XML构造
+         * @param xml_view toast XML文本
+         */
+        explicit xml_notifcation_field(const std::wstring_view xml_view);
+
+        operator winrt::Windows::Data::Xml::Dom::XmlDocument &() noexcept {
+            return xml;
+        }
+
+        void load_xml(const std::wstring_view xml_view) {
+            if (!xml_view.empty()) {
+                xml.LoadXml(winrt::hstring{xml_view});
+            }
+        }
+
+        HRESULT set_image_field(std::wstring_view path, bool is_toast_generic, bool is_crop_hint_circle);
+        HRESULT set_hero_image(std::wstring_view path, bool is_inline_image);
+        HRESULT set_bind_toast_generic();
+        HRESULT set_audio_field(std::wstring_view path,
+                                notification_template::audio_option_t option = notification_template::audio_option_t::default_option);
+        HRESULT set_text_field(std::wstring_view text, std::uint32_t pos);
+        HRESULT set_attribution_text_field(std::wstring_view text);
+        HRESULT add_action(std::wstring_view action, std::wstring_view arguments);
+        HRESULT add_duration(std::wstring_view duration);
+        HRESULT add_scenario(std::wstring_view scenario);
+        HRESULT add_input();
+
+    private:
+        winrt::Windows::Data::Xml::Dom::XmlDocument xml;
+    };
+}
+#endif
+
+namespace rainy::utility {
+    enum class shortcut_result {
+        unchanged = 0,
+        was_changed = 1,
+        was_created = 2,
+        missing_parameters = -1,
+        inis_compatible_os = -2,
+        com_init_failure = -3,
+        create_failed = -4
+    };
+
+    enum class shortcut_policy {
+        ignore = 0,
+        require_no_create = 1,
+        require_create = 2,
+    };
+
+    /**
+     * @brief init()中快捷方式的校验方式
+     */
+    enum class shortcut_validation {
+        synchronous, // 每次init()都同步校验
+        cached       // 状态文件与当前状态一致时跳过校验，否则在后台校验。校验期间显示的通知排队，完成后依次提交
+    };
+
+    /**
+     * @brief 快捷方式状态缓存使用的最小文件系统接口，可替换为测试用的实现
+     */
+    class file_system {
+    public:
+        virtual ~file_system() = default;
+
+        /**
+         * @brief 获取文件的最后修改时间
+         * @param path 文件路径
+         * @return 文件不存在时返回std::nullopt
+         */
+        virtual std::optional<std::int64_t> last_write_time(std::wstring_view path) = 0;
+
+        /**
+         * @brief 读取整个文件
+         * @param path 文件路径
+         * @param contents 输出的文件内容
+         * @return 文件不存在或读取失败时返回false
+         */
+        virtual bool read_file(std::wstring_view path, std::string &contents) = 0;
+
+        /**
+         * @brief 写入整个文件，已存在时覆盖
+         * @param path 文件路径
+         * @param contents 文件内容
+         * @return 写入失败时返回false
+         */
+        virtual bool write_file(std::wstring_view path, std::string_view contents) = 0;
+    };
+
+    /**
+     * @brief 基于std::filesystem的实现，写入时创建缺失的目录
+     */
+    class std_file_system final : public file_system {
+    public:
+        std::optional<std::int64_t> last_write_time(std::wstring_view path) override;
+        bool read_file(std::wstring_view path, std::string &contents) override;
+        bool write_file(std::wstring_view path, std::string_view contents) override;
+    };
+
+    /**
+     * @brief 已校验的快捷方式状态。任意一项变化都需要重新校验
+     */
+    struct shortcut_state {
+        std::wstring appname{};
+        std::wstring aumi{};
+        std::wstring executable_path{};
+        std::int64_t link_write_time{0}; // 快捷方式文件的最后修改时间
+
+        friend bool operator==(const shortcut_state &, const shortcut_state &) = default;
+    };
+
+    /**
+     * @brief 在本地状态文件中记录最近一次校验通过的快捷方式状态，使init()在状态未变化时无需调用存储API
+     */
+    class shortcut_cache {
+    public:
+        /**
+         * @brief 构造缓存
+         * @param fs 文件系统
+         * @param state_path 状态文件路径
+         */
+        shortcut_cache(std::shared_ptr<file_system> fs, std::wstring state_path);
+
+        /**
+         * @brief 读取快捷方式当前的状态
+         * @param appname 应用名称
+         * @param aumi AppUserModelID
+         * @param executable_path 可执行文件路径
+         * @param link_path 快捷方式路径
+         * @return 快捷方式不存在时返回std::nullopt，此时必须校验（并按策略创建）
+         */
+        RAINY_NODISCARD std::optional<shortcut_state> probe(std::wstring_view appname, std::wstring_view aumi,
+                                                            std::wstring_view executable_path, std::wstring_view link_path) const;
+
+        /**
+         * @brief 检查状态文件记录的状态是否与current一致
+         * @param current 由probe得到的当前状态
+         * @return 一致时可以跳过校验。状态文件不存在或已损坏时返回false
+         */
+        RAINY_NODISCARD bool is_current(const shortcut_state &current) const;
+
+        /**
+         * @brief 记录校验通过的状态
+         * @param state 校验（及可能的修改）完成之后由probe得到的状态
+         * @return 写入失败时返回false，下次启动时会重新校验
+         */
+        bool store(const shortcut_state &state) const;
+
+        /**
+         * @brief 将状态编码为状态文件的内容
+         */
+        static std::string encode(const shortcut_state &state);
+
+        /**
+         * @brief 解码状态文件的内容
+         * @return 格式错误、版本或字符宽度不符时返回std::nullopt
+         */
+        static std::optional<shortcut_state> decode(std::string_view data);
+
+    private:
+        std::shared_ptr<file_system> fs_;
+        std::wstring state_path_;
+    };
+
+#ifdef _WIN32
+    HRESULT create_shelllink(shortcut_policy policy, std::wstring_view appname, std::wstring_view aumi);
+    HRESULT validate_shelllink(bool &was_changed, std::wstring_view appname, std::wstring_view aumi);
+
+    shortcut_result create_shortcut(shortcut_policy policy, std::wstring_view appname, std::wstring_view aumi, bool &winrt_init_flag);
+#endif
+}
+
+namespace rainy {
+    /**
+     * @brief 通知后端接口
+     * @brief notification只负责模板、ID与事件的管理，所有与平台通知器相关的操作都经由后端完成。后端按ID处理通知，并通过event_sink回报事件
+     */
+    class notification_backend {
+    public:
+        /**
+         * @brief 后端为每个已显示的通知创建的平台对象，由notification在通知的生命周期内持有
+         * @attention 析构时后端应注销与该通知相关的事件
+         */
+        class toast_handle {
+        public:
+            virtual ~toast_handle() = default;
+        };
+
+        /**
+         * @brief 接收后端事件的接口，事件可能在任意线程上回报
+         */
+        class event_sink {
+        public:
+            virtual ~event_sink() = default;
+
+            /**
+             * @brief 通知被激活
+             * @param id 通知ID
+             * @param args 激活参数与全部输入框的内容，仅在调用期间有效
+             */
+            virtual void on_activated(std::int64_t id, const activation &args) = 0;
+
+            /**
+             * @brief 通知被关闭
+             * @param id 通知ID
+             * @param reason 关闭原因
+             */
+            virtual void on_dismissed(std::int64_t id, notification_handler::dismissal_reason reason) = 0;
+
+            /**
+             * @brief 通知发送失败
+             * @param id 通知ID
+             */
+            virtual void on_failed(std::int64_t id) = 0;
+
+            /**
+             * @brief 后端回报内部阶段的耗时，用于notification::metrics()
+             * @param phase 阶段
+             * @param elapsed 耗时
+             */
+            virtual void on_phase(utility::pipeline_phase phase, std::chrono::nanoseconds elapsed) {
+                (void) phase;
+                (void) elapsed;
+            }
+        };
+
+        struct toast_request {
+            std::int64_t id;
+            std::wstring_view xml;
+            std::int64_t expiration;                                  // 相对过期时间，单位为毫秒，为0时不过期
+            std::span<const notification_template::data_binding> data{}; // 初始绑定数据，为空时不启用数据绑定
+            std::wstring_view tag{};                                  // 为空时不设置
+            std::wstring_view group{};                                // 为空时不设置
+            notification_template::priority_t priority{notification_template::priority_t::normal};
+        };
+
+        virtual ~notification_backend() = default;
+
+        /**
+         * @brief 创建（或重新创建）通知器，后续的show/hide都将使用该通知器
+         * @param aumi AppUserModelID
+         * @return 创建结果
+         */
+        virtual HRESULT create_notifier(std::wstring_view aumi) = 0;
+
+        /**
+         * @brief 释放通知器
+         */
+        virtual void release_notifier() noexcept = 0;
+
+        /**
+         * @brief 探测平台能力，notification::init()时调用一次
+         * @return 平台能力快照
+         */
+        virtual platform_capabilities query_capabilities() = 0;
+
+        /**
+         * @brief 显示通知
+         * @param request 通知请求
+         * @param sink 事件接收者，必须在handle的生命周期内有效
+         * @param handle 成功时输出该通知的平台对象
+         * @return 显示结果。若通知器已失效，应返回使is_stale_notifier_error成立的HRESULT
+         */
+        virtual HRESULT show(const toast_request &request, event_sink &sink, std::unique_ptr<toast_handle> &handle) = 0;
+
+        /**
+         * @brief 批量显示通知，默认实现逐个调用show
+         * @param requests 通知请求
+         * @param sink 事件接收者
+         * @param handles 与requests一一对应，成功的项输出该通知的平台对象
+         * @param results 与requests一一对应，输出每一项的显示结果
+         */
+        virtual void show_batch(std::span<const toast_request> requests, event_sink &sink,
+                                std::span<std::unique_ptr<toast_handle>> handles, std::span<HRESULT> results) {
+            for (std::size_t i = 0; i < requests.size(); ++i) {
+                results[i] = show(requests[i], sink, handles[i]);
+            }
+        }
+
+        /**
+         * @brief 隐藏通知
+         * @param handle 由show输出的平台对象
+         * @return 隐藏结果
+         */
+        virtual HRESULT hide(toast_handle &handle) = 0;
+
+        /**
+         * @brief 更新已显示通知的绑定数据，默认实现不支持数据绑定
+         * @param handle 由show输出的平台对象，对应的请求必须带有初始绑定数据
+         * @param values 发生变化的键值对
+         * @param sequence 序列号，平台会忽略序列号不大于当前值的更新
+         * @return 更新结果。通知已不存在时返回HRESULT_FROM_WIN32(ERROR_NOT_FOUND)
+         */
+        virtual HRESULT update(toast_handle &handle, std::span<const notification_template::data_binding> values, std::uint32_t sequence) {
+            (void) handle;
+            (void) values;
+            (void) sequence;
+            return E_NOTIMPL;
+        }
+
+        /**
+         * @brief 以一次平台调用移除指定组中的全部通知，包括操作中心中的
+         * @param group 组
+         * @return 移除结果。默认实现返回E_NOTIMPL，调用者会退化为逐个hide
+         */
+        virtual HRESULT remove_group(std::wstring_view group) {
+            (void) group;
+            return E_NOTIMPL;
+        }
+
+        /**
+         * @brief 以一次平台调用移除指定Tag与Group的通知，包括操作中心中的
+         * @param tag Tag
+         * @param group 组，可为空
+         * @return 移除结果。默认实现返回E_NOTIMPL，调用者会退化为hide
+         */
+        virtual HRESULT remove_tag(std::wstring_view tag, std::wstring_view group) {
+            (void) tag;
+            (void) group;
+            return E_NOTIMPL;
+        }
+
+        /**
+         * @brief 交给平台在指定时间显示通知，进程退出后仍然有效。计划中的通知不回报事件
+         * @param request 通知请求
+         * @param due 显示时间
+         * @param handle 成功时输出该通知的平台对象，以hide取消计划
+         * @return 计划结果。默认实现返回E_NOTIMPL，调用者会退化为进程内定时
+         */
+        virtual HRESULT schedule(const toast_request &request, std::chrono::system_clock::time_point due,
+                                 std::unique_ptr<toast_handle> &handle) {
+            (void) request;
+            (void) due;
+            (void) handle;
+            return E_NOTIMPL;
+        }
+    };
+
+#ifdef _WIN32
+    /**
+     * @brief 基于WinRT ToastNotifier的后端，通知器在create_notifier中创建一次并在此后复用
+     */
+    class winrt_notification_backend final : public notification_backend {
+    public:
+        HRESULT create_notifier(std::wstring_view aumi) override;
+        void release_notifier() noexcept override;
+        platform_capabilities query_capabilities() override;
+        HRESULT show(const toast_request &request, event_sink &sink, std::unique_ptr<toast_handle> &handle) override;
+        void show_batch(std::span<const toast_request> requests, event_sink &sink, std::span<std::unique_ptr<toast_handle>> handles,
+                        std::span<HRESULT> results) override;
+        HRESULT hide(toast_handle &handle) override;
+        HRESULT update(toast_handle &handle, std::span<const notification_template::data_binding> values, std::uint32_t sequence) override;
+        HRESULT remove_group(std::wstring_view group) override;
+        HRESULT remove_tag(std::wstring_view tag, std::wstring_view group) override;
+        HRESULT schedule(const toast_request &request, std::chrono::system_clock::time_point due,
+                         std::unique_ptr<toast_handle> &handle) override;
+
+    private:
+        winrt::Windows::UI::Notifications::ToastNotifier notifier() const;
+        static HRESULT show_with(const winrt::Windows::UI::Notifications::ToastNotifier &notifier, const toast_request &request,
+                                 event_sink &sink, std::unique_ptr<toast_handle> &handle);
+
+        mutable std::mutex lock_;
+        winrt::Windows::UI::Notifications::ToastNotifier notifier_{nullptr};
+        std::wstring aumi_{}; // 操作中心的历史记录按AUMI访问
+    };
+#endif
+
+    /**
+     * @brief 在内存中记录全部操作的后端，不依赖任何平台通知服务。非Windows平台上的默认后端，也用于测试与基准
+     * @brief 事件由simulate_*从调用者所在的线程回报，可以在任意多个线程上同时触发
+     */
+    class memory_notification_backend final : public notification_backend {
+    public:
+        struct record {
+            std::int64_t id{-1};
+            std::wstring xml{};
+            std::int64_t expiration{0};
+            std::wstring tag{};
+            std::wstring group{};
+            std::vector<notification_template::data_binding> data{};
+            std::uint32_t sequence{0}; // 最近一次成功更新使用的序列号，未启用数据绑定时为0
+            notification_template::priority_t priority{notification_template::priority_t::normal};
+            bool visible{true};        // 是否仍显示在屏幕上，计划通知为是否仍在计划中
+            std::optional<std::chrono::system_clock::time_point> due{}; // 由schedule登记的通知的显示时间
+        };
+
+        /**
+         * @brief 构造内存后端
+         * @param capabilities query_capabilities返回的平台能力
+         */
+        explicit memory_notification_backend(const platform_capabilities &capabilities = {true, true, true, true, true});
+
+        HRESULT create_notifier(std::wstring_view aumi) override;
+        void release_notifier() noexcept override;
+        platform_capabilities query_capabilities() override;
+        HRESULT show(const toast_request &request, event_sink &sink, std::unique_ptr<toast_handle> &handle) override;
+        HRESULT hide(toast_handle &handle) override;
+        HRESULT update(toast_handle &handle, std::span<const notification_template::data_binding> values, std::uint32_t sequence) override;
+        HRESULT remove_group(std::wstring_view group) override;
+        HRESULT remove_tag(std::wstring_view tag, std::wstring_view group) override;
+        HRESULT schedule(const toast_request &request, std::chrono::system_clock::time_point due,
+                         std::unique_ptr<toast_handle> &handle) override;
+
+        /**
+         * @brief 使之后的show依次返回指定的结果，用于模拟显示失败或通知器失效
+         * @param hr 下一次show的返回值，每次调用追加一个
+         */
+        void inject_show_result(HRESULT hr);
+
+        /**
+         * @brief 模拟通知被激活
+         * @param id 通知ID
+         * @param arguments 激活参数
+         * @param inputs 输入框的内容
+         * @return 通知不存在或其事件已被注销时返回false
+         */
+        bool simulate_activated(std::int64_t id, std::wstring_view arguments = {}, std::span<const user_input> inputs = {});
+
+        /**
+         * @brief 模拟通知被关闭
+         * @param id 通知ID
+         * @param reason 关闭原因
+         * @return 通知不存在或其事件已被注销时返回false
+         */
+        bool simulate_dismissed(std::int64_t id, notification_handler::dismissal_reason reason);
+
+        /**
+         * @brief 模拟通知发送失败
+         * @param id 通知ID
+         * @return 通知不存在或其事件已被注销时返回false
+         */
+        bool simulate_failed(std::int64_t id);
+
+        /**
+         * @brief 获取通知的记录
+         * @param id 通知ID
+         * @return 不存在时返回std::nullopt
+         */
+        RAINY_NODISCARD std::optional<record> find(std::int64_t id) const;
+
+        /**
+         * @brief 按显示顺序获取全部记录的副本
+         */
+        RAINY_NODISCARD std::vector<record> records() const;
+
+        /**
+         * @brief 获取仍显示在屏幕上的通知数量，不包括计划中的通知
+         */
+        RAINY_NODISCARD std::size_t visible_count() const;
+
+        /**
+         * @brief 获取最近一次create_notifier使用的AUMI
+         */
+        RAINY_NODISCARD std::wstring aumi() const;
 
-        HRESULT set_image_field(std::wstring_view path, bool is_toast_generic, bool is_crop_hint_circle);
-        HRESULT set_hero_image(std::wstring_view path, bool is_inline_image);
-        HRESULT set_bind_toast_generic();
-        HRESULT set_audio_field(std::wstring_view path,
-                                notification_template::audio_option_t option = notification_template::audio_option_t::default_option);
-        HRESULT set_text_field(std::wstring_view text, std::uint32_t pos);
-        HRESULT set_attribution_text_field(std::wstring_view text);
-        HRESULT add_action(std::wstring_view action, std::wstring_view arguments);
-        HRESULT add_duration(std::wstring_view duration);
-        HRESULT add_scenario(std::wstring_view scenario);
-        HRESULT add_input();
+        /**
+         * @brief 清除句柄已被释放的通知的记录，仍被notification持有的通知保留
+         */
+        void clear();
 
     private:
-        winrt::Windows::Data::Xml::Dom::XmlDocument xml;
-    };
-}
-
-namespace rainy::utility {
-    enum class shortcut_result {
-        unchanged = 0,
-        was_changed = 1,
-        was_created = 2,
-        missing_parameters = -1,
-        inis_compatible_os = -2,
-        com_init_failure = -3,
-        create_failed = -4
-    };
+        class memory_toast_handle;
 
-    enum class shortcut_policy {
-        ignore = 0,
-        require_no_create = 1,
-        require_create = 2,
-    };
+        struct entry {
+            record value;
+            event_sink *sink{nullptr}; // 句柄析构后为nullptr，不再回报事件
+        };
 
-    HRESULT create_shelllink(shortcut_policy policy, std::wstring_view appname, std::wstring_view aumi);
-    HRESULT validate_shelllink(bool &was_changed, std::wstring_view appname, std::wstring_view aumi);
+        HRESULT add(const toast_request &request, event_sink *sink, std::unique_ptr<toast_handle> &handle,
+                    std::optional<std::chrono::system_clock::time_point> due);
+        event_sink *close(std::int64_t id);
+        void detach(std::int64_t id) noexcept;
 
-    shortcut_result create_shortcut(shortcut_policy policy, std::wstring_view appname, std::wstring_view aumi, bool &winrt_init_flag);
+        mutable std::mutex lock_;
+        platform_capabilities capabilities_;
+        std::wstring aumi_{};
+        std::vector<std::int64_t> order_{};
+        std::unordered_map<std::int64_t, entry> entries_{};
+        std::unordered_map<std::wstring, std::int64_t> tags_{}; // 由Group与Tag拼接的键到最近显示的通知，替换时无需遍历全部记录
+        std::vector<HRESULT> injected_{};
+    };
 }
 
 namespace rainy {
@@ -753,10 +3600,40 @@ namespace rainy {
         invalid_parameters,
         invalid_handler,
         not_displayed,
+        duplicate_id,
+        queue_full,
+        rate_limited,
+        live_limit_reached,
         unknown_error
     };
 
-    class notification {
+    /**
+     * @brief 异步显示队列已满时的处理策略
+     */
+    enum class backpressure_policy {
+        block,       // 阻塞调用者直到队列有空位
+        drop_oldest, // 丢弃最早入队的请求，其完成回调以notification_error::queue_full调用
+        reject       // 拒绝新请求，其完成回调以notification_error::queue_full调用
+    };
+
+    /**
+     * @brief 通知事件的投递方式
+     */
+    enum class event_delivery {
+        inline_thread, // 在触发事件的线程上直接调用处理器
+        event_thread,  // 在notification持有的单个事件线程上按入队顺序调用处理器
+        submit         // 将批量投递任务交给用户提供的submit函数，由其决定在哪个线程或队列上执行
+    };
+
+    /**
+     * @brief 计划通知的定时方式
+     */
+    enum class schedule_mode {
+        in_process, // 由notification持有的单个定时线程在到期时显示，处理器照常收到事件；进程退出后不再显示
+        platform    // 交给后端的平台计划（Windows上为ScheduledToastNotification），进程退出后仍会显示，但处理器不会收到事件
+    };
+
+    class notification : private notification_backend::event_sink {
     public:
         notification();
         ~notification();
@@ -764,15 +3641,29 @@ namespace rainy {
         /**
          * @brief 检查是否支持Modern Toast
          * @return 如果支持Modern Toast，返回true，否则返回false
+         * @note 系统版本只探测一次
         */
         static bool is_supporting_modern_features();
 
         /**
          * @brief 检查是否为Win10 Anniversary Update或更高版本
          * @return 如果为Win10 Anniversary Update或更高版本，返回true，否则返回false
+         * @note 系统版本只探测一次
         */
         static bool is_win10_anniversary_or_higher();
 
+        /**
+         * @brief 获取平台能力快照
+         * @return 在init()中探测或由set_capabilities()注入的能力快照
+        */
+        const platform_capabilities &capabilities() const noexcept;
+
+        /**
+         * @brief 注入平台能力快照，此后init()不再向后端探测
+         * @param capabilities 平台能力快照
+        */
+        void set_capabilities(const platform_capabilities &capabilities) noexcept;
+
         /**
          * @brief 构建应用程序的AppUserModelID
          * @param company_name 公司名称
@@ -811,6 +3702,42 @@ namespace rainy {
         */
         bool hide(const std::int64_t id);
 
+        /**
+         * @brief 以一次平台调用隐藏指定组中的全部通知，包括此前会话中显示、仍留在操作中心中的
+         * @param group 组（由notification_template::group设置）
+         * @return 如果平台调用成功，返回true
+        */
+        bool hide_group(std::wstring_view group);
+
+        /**
+         * @brief 以一次平台调用隐藏指定Tag与Group的通知
+         * @param tag Tag（由notification_template::tag设置）
+         * @param group 组，可为空
+         * @return 如果平台调用成功，返回true
+        */
+        bool hide_tag(std::wstring_view tag, std::wstring_view group = {});
+
+        /**
+         * @brief 更新已显示通知的绑定数据。只推送与当前值不同的项，不会重新生成XML，也不会重新注册事件
+         * @param id 通知ID（由show()返回），对应的模板必须通过bind声明过绑定值
+         * @param values 新的键值对，键必须已在模板中声明
+         * @param error 错误码
+         * @return 如果推送成功或没有需要推送的变化，返回true
+        */
+        bool update(std::int64_t id, std::span<const notification_template::data_binding> values, notification_error *error = nullptr);
+
+        /**
+         * @brief 更新已显示通知的绑定数据
+         * @param id 通知ID（由show()返回）
+         * @param values 新的键值对
+         * @param error 错误码
+         * @return 如果推送成功或没有需要推送的变化，返回true
+        */
+        bool update(std::int64_t id, std::initializer_list<notification_template::data_binding> values,
+                    notification_error *error = nullptr) {
+            return update(id, std::span<const notification_template::data_binding>{values.begin(), values.size()}, error);
+        }
+
         /**
          * @brief 设置现代特性的状态
          * @param enable 是否启用
@@ -828,6 +3755,52 @@ namespace rainy {
          */        
         void clear();
 
+        /**
+         * @brief 设置每次清理已结束通知的数量上限
+         * @param batch_size 每次show()或maintenance()最多清理的通知数量，为0时show()不再顺带清理
+         * @note 已被激活、关闭或发送失败的通知先进入退役队列，随后分批清理，事件回调中只需一次入队
+        */
+        void set_cleanup_batch_size(std::size_t batch_size) noexcept;
+
+        /**
+         * @brief 清理一批已结束的通知，并显示已结束的合并窗口的汇总通知。适合在空闲时或定时器中调用
+         * @return 本次清理的通知数量
+        */
+        std::size_t maintenance();
+
+        /**
+         * @brief 设置准入策略（限流与合并），作用于show()与show_async()，不作用于show_batch()
+         * @param policy 准入策略
+         * @note 被限流的通知以notification_error::rate_limited失败；被合并的通知返回窗口内最初显示的通知ID，其处理器只在汇总通知中使用。
+         * @note 被后续合并替换的处理器、以及被汇总通知替换的最初通知的处理器，收到dismissed(application_hidden)；
+         * @note 汇总通知显示失败时，其处理器收到failed()，并计入admission_stats().summary_failures
+        */
+        void set_admission_policy(const utility::admission_policy &policy);
+
+        /**
+         * @brief 替换准入控制使用的时钟，用于测试
+         * @param clock 时钟，为空时使用std::chrono::steady_clock::now
+        */
+        void set_admission_clock(utility::admission_controller::clock_function clock);
+
+        /**
+         * @brief 获取准入控制的统计信息
+         * @return 放行、限流、合并与汇总的数量
+        */
+        utility::admission_controller::statistics admission_stats() const;
+
+        /**
+         * @brief 设置通知骨架缓存的容量
+         * @param capacity 最多缓存的骨架数量，为0时禁用缓存
+        */
+        void set_template_cache_capacity(std::size_t capacity);
+
+        /**
+         * @brief 获取通知骨架缓存的统计信息
+         * @return 命中、未命中、淘汰次数以及当前大小
+        */
+        utility::template_cache::statistics template_cache_stats() const;
+
         /**
          * @brief 获取通知的应用名称
          * @return 返回通知的应用名称
@@ -858,6 +3831,27 @@ namespace rainy {
         */
         void set_shortcut_policy(utility::shortcut_policy policy);
 
+        /**
+         * @brief 设置init()中快捷方式的校验方式，仅在Windows上生效
+         * @param validation 校验方式，默认为utility::shortcut_validation::synchronous
+         * @param state_path 状态文件路径，为空时使用%LOCALAPPDATA%\rainy-notification\<AUMI>.shortcut
+         * @param fs 文件系统，为空时使用utility::std_file_system
+        */
+        void set_shortcut_validation(utility::shortcut_validation validation, std::wstring state_path = {},
+                                     std::shared_ptr<utility::file_system> fs = nullptr);
+
+        /**
+         * @brief 替换通知后端。已显示的通知会被清除，且需要重新调用init()
+         * @param backend 通知后端，不能为nullptr
+        */
+        void set_backend(std::shared_ptr<notification_backend> backend);
+
+        /**
+         * @brief 获取当前使用的通知后端
+         * @return 通知后端
+        */
+        const std::shared_ptr<notification_backend> &backend() const noexcept;
+
         /**
          * @brief 显示通知，并返回通知ID
          * @tparam EventHandler 通知模板（必须继承自notification_handler，且必须实现相应的方法）。由show自动创建实例并管理生命周期
@@ -868,8 +3862,8 @@ namespace rainy {
         template <typename EventHandler, std::enable_if_t<std::is_base_of_v<notification_handler, EventHandler>, int> = 0>
         std::int64_t show(const notification_template &notification, notification_error *error = nullptr) {
             try {
-                return show_impl(notification, std::make_shared<EventHandler>(), error);
-            } catch (const winrt::hresult_error &) {
+                return show_impl(notification, internals::inline_handler::make<EventHandler>(), error);
+            } catch (const internals::platform_error &) {
                 return -1;
             }
         }
@@ -877,15 +3871,15 @@ namespace rainy {
         /**
          * @brief 显示通知，并返回通知ID
          * @param notification 通知模板
-         * @param handler 通知处理器（必须继承自notification_handler，且必须实现相应的方法）
+         * @param handler 通知处理器（必须继承自notification_handler，且必须实现相应的方法）。不获取所有权，调用者必须保证其在通知的生命周期内有效
          * @param error 错误码
          * @return 返回通知ID，如果失败，返回-1。如果error不为nullptr，errno还会附带错误信息。
         */
         template <typename EventHandler, std::enable_if_t<std::is_base_of_v<notification_handler, EventHandler>, int> = 0>
         std::int64_t show(const notification_template &notification, EventHandler &handler, notification_error *error = nullptr) {
             try {
-                return show_impl(notification, &handler, error);
-            } catch (const winrt::hresult_error &) {
+                return show_impl(notification, internals::inline_handler::borrow(handler), error);
+            } catch (const internals::platform_error &) {
                 return -1;
             }
         }
@@ -901,102 +3895,346 @@ namespace rainy {
         template <typename EventHandler,
                   typename = std::void_t<decltype(std::declval<EventHandler>()(std::declval<const rainy::notification_event &>()))>>
         std::int64_t show(const notification_template &notification, EventHandler handler, notification_error *error = nullptr) {
-            struct unnamed_handler final : EventHandler, notification_handler {
-                using event_t = notification_event;
+            try {
+                return show_impl(notification, internals::inline_handler::from_callable(std::move(handler)), error);
+            } catch (const internals::platform_error &) {
+                return -1;
+            }
+        }
 
-                unnamed_handler(EventHandler &&handler) : EventHandler(handler) {
-                }
+        /**
+         * @brief 显示编译期确定形状的通知，XML由对应类型的特化序列化路径生成，不经过运行时的骨架缓存
+         * @tparam Type 通知模板类型
+         * @param notification 通知模板
+         * @param handler 通知处理器，可以是一个仿函数或一个lambda表达式。必须支持const rainy::notification_event &这一参数的传入
+         * @param error 错误码
+         * @return 返回通知ID，如果失败，返回-1。如果error不为nullptr，errno还会附带错误信息。
+        */
+        template <notification_template_type Type, typename EventHandler,
+                  typename = std::void_t<decltype(std::declval<EventHandler>()(std::declval<const rainy::notification_event &>()))>>
+        std::int64_t show(const static_notification_template<Type> &notification, EventHandler handler, notification_error *error = nullptr) {
+            return show_static(notification, internals::inline_handler::from_callable(std::move(handler)), error);
+        }
 
-                void activated() const override {
-                    event_t event{event_t::event_type::activated, {}};
-                    call_handler(event);
-                }
+        /**
+         * @brief 显示编译期确定形状的通知，并使用已存在的处理器
+         * @tparam Type 通知模板类型
+         * @param notification 通知模板
+         * @param handler 通知处理器
+         * @param error 错误码
+         * @return 返回通知ID，如果失败，返回-1。如果error不为nullptr，errno还会附带错误信息。
+        */
+        template <notification_template_type Type>
+        std::int64_t show(const static_notification_template<Type> &notification, std::shared_ptr<notification_handler> handler,
+                          notification_error *error = nullptr) {
+            return show_static(notification, std::move(handler), error);
+        }
 
-                void activated(int action_idx) const override {
-                    event_t event{event_t::event_type::activated_with_action_idx, action_idx};
-                    call_handler(event);
-                }
+        struct show_result {
+            std::int64_t id;          // 通知ID，失败时为-1
+            notification_error error; // 错误码
+        };
 
-                void activated(const std::wstring_view response) const override {
-                    event_t event{event_t::event_type::activated_with_reply, response};
-                    call_handler(event);
-                }
+        using batch_result = show_result;
+        using completion_callback = std::function<void(const show_result &)>;
 
-                void dismissed(dismissal_reason state) const override {
-                    event_t event{event_t::event_type::dismissed, state};
-                    call_handler(event);
-                }
+        /**
+         * @brief 批量显示通知。所有通知先完成XML构建，再一次性提交给后端
+         * @param notifications 通知模板
+         * @param handler 通知处理器（必须继承自notification_handler），由所有通知共享
+         * @return 与notifications一一对应的结果
+        */
+        std::vector<batch_result> show_batch(std::span<const notification_template> notifications,
+                                             std::shared_ptr<notification_handler> handler) {
+            return show_batch_impl(notifications, std::move(handler));
+        }
 
-                void failed() const override {
-                    event_t event{event_t::event_type::failed, {}};
-                    call_handler(event);
-                }
+        /**
+         * @brief 批量显示通知。所有通知先完成XML构建，再一次性提交给后端
+         * @tparam EventHandler 仿函数类型
+         * @param notifications 通知模板
+         * @param handler 通知处理器，可以是一个仿函数或一个lambda表达式。必须支持const rainy::notification_event &这一参数的传入，由所有通知共享
+         * @return 与notifications一一对应的结果
+        */
+        template <typename EventHandler,
+                  typename = std::void_t<decltype(std::declval<EventHandler>()(std::declval<const rainy::notification_event &>()))>>
+        std::vector<batch_result> show_batch(std::span<const notification_template> notifications, EventHandler handler) {
+            return show_batch_impl(notifications, std::make_shared<internals::callable_handler<EventHandler>>(std::move(handler)));
+        }
 
-                void call_handler(const event_t &event) const {
-                    (*this)(event);
-                }
-            };
-            std::shared_ptr<notification_handler> ptr_handler = std::make_shared<unnamed_handler>(std::forward<EventHandler>(handler));
+        /**
+         * @brief 异步显示通知。模板被复制进有界队列，由专用的分发线程完成XML构建与显示
+         * @param notification 通知模板
+         * @param handler 通知处理器（必须继承自notification_handler）
+         * @return 显示结果。队列已满且策略为reject或drop_oldest时，结果的错误码为notification_error::queue_full
+        */
+        std::future<show_result> show_async(const notification_template &notification, std::shared_ptr<notification_handler> handler);
+
+        /**
+         * @brief 异步显示通知
+         * @tparam EventHandler 仿函数类型
+         * @param notification 通知模板
+         * @param handler 通知处理器，可以是一个仿函数或一个lambda表达式。必须支持const rainy::notification_event &这一参数的传入
+         * @return 显示结果
+        */
+        template <typename EventHandler,
+                  typename = std::void_t<decltype(std::declval<EventHandler>()(std::declval<const rainy::notification_event &>()))>>
+        std::future<show_result> show_async(const notification_template &notification, EventHandler handler) {
+            return show_async_impl(notification, internals::inline_handler::from_callable(std::move(handler)));
+        }
+
+        /**
+         * @brief 异步显示通知，完成后调用completion
+         * @param notification 通知模板
+         * @param handler 通知处理器（必须继承自notification_handler）
+         * @param completion 完成回调，恰好调用一次。通常在分发线程上调用，请求被拒绝时在调用者线程上调用。不能抛出异常
+        */
+        void show_async(const notification_template &notification, std::shared_ptr<notification_handler> handler,
+                        completion_callback completion);
+
+        /**
+         * @brief 设置异步显示队列已满时的处理策略
+         * @param policy 策略，默认为backpressure_policy::block
+        */
+        void set_backpressure_policy(backpressure_policy policy) noexcept;
+
+        /**
+         * @brief 设置异步显示队列的容量。每个优先级各有一个该容量的队列，分发线程总是先取出较高优先级的请求
+         * @param capacity 容量，会向上取整为2的幂
+         * @attention 仅在首次调用show_async()之前生效
+        */
+        void set_async_queue_capacity(std::size_t capacity) noexcept;
+
+        using event_submit_function = std::function<void(std::function<void()>)>;
+
+        /**
+         * @brief 设置通知事件的投递方式。除event_delivery::inline_thread外，事件先进入无锁队列，再由单个消费者批量取出并调用处理器，
+         * @brief 因此处理器之间不会并发执行，也不会与触发事件的线程竞争锁
+         * @param delivery 投递方式，默认为event_delivery::inline_thread
+         * @param submit 仅用于event_delivery::submit，接受一个投递任务并安排其执行。上一个任务执行完毕之前不会提交新的任务。不能抛出异常
+         * @attention 必须在init()之前调用。不能在处理器中析构notification
+         * @note 队列已满时，触发事件的线程短暂让出时间片后阻塞，直到消费者取出事件；在处理器内部触发的事件直接投递
+         * @throw std::invalid_argument delivery为event_delivery::submit而submit为空
+         * @throw std::logic_error 已调用init()
+        */
+        void set_event_delivery(event_delivery delivery, event_submit_function submit = {});
+
+        /**
+         * @brief 在指定时间显示通知，并返回通知ID。XML在调用时生成，到期时不经过准入控制
+         * @param notification 通知模板
+         * @param due 显示时间，不晚于当前时间时在定时线程的下一次唤醒时显示
+         * @param handler 通知处理器（必须继承自notification_handler）
+         * @param error 错误码
+         * @return 返回通知ID，如果失败，返回-1。到期前可以用hide()取消；到期后显示失败时处理器收到failed事件
+        */
+        std::int64_t schedule(const notification_template &notification, std::chrono::steady_clock::time_point due,
+                              std::shared_ptr<notification_handler> handler, notification_error *error = nullptr) {
+            return schedule_impl(notification, due, internals::inline_handler(std::move(handler)), error);
+        }
+
+        /**
+         * @brief 在指定时间显示通知，并返回通知ID
+         * @tparam EventHandler 仿函数类型
+         * @param notification 通知模板
+         * @param due 显示时间
+         * @param handler 通知处理器，可以是一个仿函数或一个lambda表达式。必须支持const rainy::notification_event &这一参数的传入
+         * @param error 错误码
+         * @return 返回通知ID，如果失败，返回-1
+        */
+        template <typename EventHandler,
+                  typename = std::void_t<decltype(std::declval<EventHandler>()(std::declval<const rainy::notification_event &>()))>>
+        std::int64_t schedule(const notification_template &notification, std::chrono::steady_clock::time_point due, EventHandler handler,
+                              notification_error *error = nullptr) {
+            return schedule_impl(notification, due, internals::inline_handler::from_callable(std::move(handler)), error);
+        }
+
+        /**
+         * @brief 在指定的日历时间显示通知，并返回通知ID。调用时换算为计划时钟上的时间点，此后系统时间的调整不影响到期时间
+         * @tparam EventHandler 仿函数类型或std::shared_ptr<notification_handler>
+         * @param notification 通知模板
+         * @param due 显示时间
+         * @param handler 通知处理器
+         * @param error 错误码
+         * @return 返回通知ID，如果失败，返回-1
+        */
+        template <typename EventHandler>
+        std::int64_t schedule(const notification_template &notification, std::chrono::system_clock::time_point due, EventHandler handler,
+                              notification_error *error = nullptr) {
+            const auto delay = std::chrono::duration_cast<std::chrono::steady_clock::duration>(due - std::chrono::system_clock::now());
+            return schedule(notification, schedule_now() + delay, std::move(handler), error);
+        }
+
+        /**
+         * @brief 设置计划通知的定时方式
+         * @param mode 定时方式，默认为schedule_mode::in_process。后端不支持平台计划时退化为in_process
+        */
+        void set_schedule_mode(schedule_mode mode) noexcept;
+
+        /**
+         * @brief 替换计划通知与过期跟踪使用的时钟，用于测试。替换后不再启动定时线程，由调用者通过run_due_schedules()推进
+         * @param clock 时钟，为空时使用std::chrono::steady_clock::now并恢复定时线程
+         * @attention 仅在首次显示或计划通知之前生效
+        */
+        void set_schedule_clock(utility::admission_controller::clock_function clock);
+
+        /**
+         * @brief 显示全部已到期的计划通知，并以dismissal_reason::timed_out结束已过期的通知。定时线程在到期时调用，替换时钟后由调用者调用
+         * @return 本次到期的计划通知与过期通知的数量
+        */
+        std::size_t run_due_schedules();
+
+        /**
+         * @brief 设置未指定过期时间的通知的保留时长。超过保留时长仍未结束的通知视为已过期，处理器收到timed_out，注册表中的条目被回收
+         * @param expiration 保留时长，默认为3天（与操作中心的默认保留时间一致），为0时不跟踪未指定过期时间的通知
+        */
+        void set_default_expiration(std::chrono::milliseconds expiration) noexcept;
+
+        /**
+         * @brief 获取注册表中尚未回收的通知数量，包括计划中的通知
+        */
+        std::size_t active_count() const noexcept;
+
+        /**
+         * @brief 设置同时存在的通知数量上限（操作中心对每个应用保留的通知数量有限）。达到上限时，
+         * @brief 按优先级从低到高、同一优先级内从旧到新驱逐不高于新通知优先级的通知，被驱逐的通知的处理器收到application_hidden
+         * @param limit 上限，为0时不限制。没有可驱逐的通知时，新通知以notification_error::live_limit_reached失败
+         * @note 仍在显示过程中的通知不会被驱逐，并发显示时新通知可能因此失败
+        */
+        void set_live_limit(std::size_t limit) noexcept;
+
+        /**
+         * @brief 获取已显示或正在显示且尚未结束的通知数量
+        */
+        std::size_t live_count() const;
+
+        /**
+         * @brief 获取尚未到期的进程内计划通知数量
+        */
+        std::size_t scheduled_count() const;
+
+        /**
+         * @brief 获取显示流程各阶段的延迟分布、事件计数与队列深度
+         * @return 快照，读取期间不会阻塞显示
+        */
+        utility::metrics_snapshot metrics() const;
+
+    protected:
+        struct async_request {
+            std::optional<notification_template> notification{};
+            internals::inline_handler handler{};
+            completion_callback completion{};
+        };
+
+        template <notification_template_type Type>
+        std::int64_t show_static(const static_notification_template<Type> &notification, internals::inline_handler event_handler,
+                                 notification_error *error) {
             try {
-                return show_impl(notification, ptr_handler, error);
-            } catch (const winrt::hresult_error &) {
+                std::wstring payload;
+                utility::toast_xml_serializer(utility::context_bridge(*this)).serialize(notification, payload);
+                return show_impl(notification.get(), std::move(event_handler), error, &payload);
+            } catch (const internals::platform_error &) {
                 return -1;
             }
         }
 
-    protected:
-        std::int64_t show_impl(notification_template const &notification, std::shared_ptr<notification_handler> event_handler,
-                               notification_error *error);
+        std::future<show_result> show_async_impl(const notification_template &notification, internals::inline_handler event_handler);
+        std::int64_t show_impl(notification_template const &notification, internals::inline_handler event_handler,
+                               notification_error *error, const std::wstring *payload = nullptr);
+        std::int64_t show_direct(notification_template const &notification, internals::inline_handler &event_handler,
+                                 notification_error *error, const std::wstring *payload = nullptr);
+        void retire_detached(internals::inline_handler event_handler, notification_event::event_type type);
+        std::int64_t schedule_impl(notification_template const &notification, std::chrono::steady_clock::time_point due,
+                                   internals::inline_handler event_handler, notification_error *error);
+        void flush_coalesced();
+        std::vector<batch_result> show_batch_impl(std::span<const notification_template> notifications,
+                                                  std::shared_ptr<notification_handler> event_handler);
         struct notify {
-            notify() {};
-            notify(const winrt::Windows::UI::Notifications::ToastNotification &notify, winrt::event_token activated_token,
-                   winrt::event_token dismissed_token, winrt::event_token failed_token) :
-                _notify(notify), _activated_token(activated_token), _dismissed_token(dismissed_token), _failed_token(failed_token) {
+            explicit notify(internals::inline_handler &&handler,
+                            std::span<const notification_template::data_binding> data = {}, const bool indexed = false)
+                : handler(std::move(handler)), indexed(indexed), data(data.begin(), data.end()) {
             }
 
-            ~notify() {
-                remove_tokens();
-            }
-
-            void remove_tokens() {
-                if (!_ready_for_deletion) {
-                    return;
-                }
+            internals::inline_handler handler;
+            std::unique_ptr<notification_backend::toast_handle> handle{};
+            std::atomic<bool> retired{false};
+            const bool indexed;                                    // 是否登记在group_index_中
+            std::mutex data_lock{};                               // 保证绑定值的比较、推送与序列号递增的顺序一致
+            std::vector<notification_template::data_binding> data{}; // 已推送的绑定值
+            std::uint32_t sequence{1};                             // 最近一次推送使用的序列号
+        };
 
-                if (_previously_token_removed) {
-                    return;
-                }
+        struct pending_event {
+            enum class kind : unsigned char {
+                activated,
+                dismissed,
+                failed
+            };
 
-                if (!_notify) {
-                    return;
-                }
-                _notify.Activated(_activated_token);
-                _notify.Dismissed(_dismissed_token);
-                _notify.Failed(_failed_token);
+            std::int64_t id{-1};
+            kind type{kind::failed};
+            notification_handler::dismissal_reason reason{};
+            std::uint8_t inputs_count{0};
+            std::array<std::uint32_t, 1 + 2 * notification_template::max_inputs> lengths{}; // 激活参数及各输入框的id与内容在text中的长度
+            std::wstring text{};
+        };
 
-                _previously_token_removed = true;
+        /**
+         * @brief 事件队列及其消费者的共享状态。提交给用户的投递任务共享其所有权，因此可以在notification析构之后执行
+         */
+        struct event_channel {
+            explicit event_channel(const std::size_t capacity) : queue(capacity) {
             }
 
-            void mark_as_ready_for_deletion() {
-                _ready_for_deletion = true;
-            }
+            utility::bounded_queue<pending_event> queue;
+            std::atomic<bool> stopping{false};
+            std::atomic<bool> scheduled{false};    // submit方式下，是否有尚未执行完毕的投递任务
+            std::atomic<bool> sleeping{false};     // event_thread方式下，事件线程是否即将等待
+            std::atomic<std::uint32_t> signal{0}; // 每次入队递增，事件线程在其上等待
+            std::atomic<std::uint32_t> space{0};  // 有生产者阻塞时，消费者每取出事件便递增，生产者在其上等待
+            std::atomic<std::uint32_t> blocked{0}; // 因队列已满而阻塞的生产者数
+            std::mutex delivery_lock;              // 串行化投递，并与notification的析构同步
+            notification *owner{nullptr};          // 在delivery_lock下读写，析构后为nullptr
+            event_submit_function submit{};
+        };
 
-            bool is_ready_for_deletion() const {
-                return _ready_for_deletion;
-            }
+        /**
+         * @brief 后台校验期间排队的通知，持有请求中全部视图的副本
+         */
+        struct deferred_toast {
+            std::int64_t id;
+            std::wstring xml;
+            std::int64_t expiration;
+            std::vector<notification_template::data_binding> data;
+            std::wstring tag;
+            std::wstring group;
+            notification_template::priority_t priority;
+            std::int64_t replaced{-1}; // 具有相同Tag与Group、将被本通知替换的通知，显示成功后才结束
+        };
 
-            const winrt::Windows::UI::Notifications::ToastNotification &notification() {
-                return _notify;
-            }
+        /**
+         * @brief 在后台线程上执行启动校验。完成之前显示的通知排队，完成后按显示顺序提交；校验失败时排队的通知以failed事件结束
+         * @param validate 校验函数，返回是否成功
+         */
+        void start_background_validation(std::function<bool()> validate);
 
-        private:
-            const winrt::Windows::UI::Notifications::ToastNotification &_notify{nullptr};
-            winrt::event_token _activated_token{};
-            winrt::event_token _dismissed_token{};
-            winrt::event_token _failed_token{};
-            bool _ready_for_deletion{false};
-            bool _previously_token_removed{false};
+        /**
+         * @brief 已显示且尚未结束的通知，用于过期回收与数量上限
+         */
+        struct live_toast {
+            utility::timer_wheel::timer_id timer;
+            notification_template::priority_t priority;
+            bool shown; // 显示完成之前不会被驱逐
+            std::list<std::int64_t>::iterator order;
+        };
+
+        /**
+         * @brief 尚未到期的进程内计划通知
+         */
+        struct scheduled_toast {
+            deferred_toast toast;
+            utility::timer_wheel::timer_id timer;
         };
+
         enum class notification_status {
             is_initialized,
             has_winrt_initialized,
@@ -1005,14 +4243,120 @@ namespace rainy {
         };
 
         std::array<bool, static_cast<int>(notification_status::size)> status{false, false, true};
+        platform_capabilities capabilities_{};
+        bool has_injected_capabilities_{false};
         utility::shortcut_policy shortcut_policy_{utility::shortcut_policy::require_create};
+        utility::shortcut_validation shortcut_validation_{utility::shortcut_validation::synchronous};
+        std::wstring shortcut_state_path_{};
+        std::shared_ptr<utility::file_system> file_system_{};
+        std::atomic<bool> startup_pending_{false}; // 后台校验尚未完成，新的通知排队
+        std::atomic<bool> startup_failed_{false};  // 后台校验失败，之后的通知以shell_link_not_created失败
+        std::mutex startup_lock_;
+        std::vector<deferred_toast> deferred_{};
+        std::thread startup_validator_;
         std::wstring appname_{};
         std::wstring aumi_{};
-        std::map<std::int64_t, notify> notifys{};
+        utility::notification_registry<notify> notifys{};
+        utility::id_generator id_generator_{};
+        utility::bounded_queue<std::int64_t> retired_{4096};
+        std::atomic<std::size_t> cleanup_batch_size_{64};
+        std::array<std::unique_ptr<utility::bounded_queue<async_request>>, notification_template::priority_levels> async_queues_{};
+        std::size_t async_queue_capacity_{1024};
+        std::atomic<backpressure_policy> backpressure_{backpressure_policy::block};
+        std::atomic<std::uint32_t> async_signal_{0};  // 每次入队递增，分发线程在其上等待
+        std::atomic<std::uint32_t> async_space_{0};   // 每次出队递增，阻塞的调用者在其上等待
+        std::atomic<std::uint32_t> blocked_producers_{0};
+        std::atomic<bool> async_stopping_{false};
+        std::atomic<bool> async_started_{false}; // 队列已创建且分发线程已启动，之后入队不再加锁
+        mutable std::mutex async_lock_;
+        std::thread dispatcher_;
+        event_delivery event_delivery_{event_delivery::inline_thread};
+        std::shared_ptr<event_channel> events_;
+        std::thread event_thread_;
+        utility::template_cache template_cache_{};
+        utility::admission_controller admission_{};
+        utility::toast_group_index group_index_{};
+        std::atomic<schedule_mode> schedule_mode_{schedule_mode::in_process};
+        utility::admission_controller::clock_function schedule_clock_{};
+        std::chrono::steady_clock::time_point schedule_epoch_{std::chrono::steady_clock::now()}; // 时间轮的第0个tick，每个tick为1毫秒
+        mutable std::mutex schedule_lock_;
+        std::condition_variable schedule_signal_;
+        utility::timer_wheel schedule_wheel_{};
+        std::unordered_map<std::int64_t, scheduled_toast> scheduled_{};
+        utility::timer_wheel expiry_wheel_{}; // 已显示通知的过期时间，与计划通知共用定时线程
+        std::unordered_map<std::int64_t, live_toast> live_{};
+        std::array<std::list<std::int64_t>, notification_template::priority_levels> live_order_{}; // 每个优先级内按显示顺序排列
+        std::atomic<std::int64_t> default_expiration_{3 * 24 * 60 * 60 * 1000}; // 毫秒
+        std::atomic<std::size_t> live_limit_{0};
+        std::unique_ptr<utility::pipeline_metrics> metrics_; // 编译时关闭统计时为空
+        bool schedule_stopping_{false};
+        std::thread scheduler_;
+        std::shared_ptr<notification_backend> backend_;
 
         void mark_as_ready_for_deletion(const std::int64_t id);
+        bool defer_show(const notification_backend::toast_request &request, std::int64_t replaced = -1);
+        void finish_startup(bool succeeded);
+        void submit_deferred(const deferred_toast &toast, bool validated, std::int64_t replaced);
+        void join_startup_validation();
+        std::chrono::steady_clock::time_point schedule_now() const;
+        std::uint64_t schedule_tick(std::chrono::steady_clock::time_point time, bool round_up) const;
+        std::optional<std::uint64_t> next_timer_tick() const;
+        bool start_timer_thread();
+        bool cancel_scheduled(std::int64_t id);
+        bool reserve_live(std::int64_t id, notification_template::priority_t priority, std::int64_t replacing = -1);
+        void track_live(std::int64_t id, std::int64_t expiration, std::chrono::steady_clock::time_point shown);
+        void untrack_live(std::int64_t id);
+        void erase_live(std::unordered_map<std::int64_t, live_toast>::iterator iter);
+        void expire(std::int64_t id);
+        void evict(std::int64_t id);
+        void dismiss_hidden(std::int64_t id);
+        std::int64_t index_toast(std::int64_t id, std::wstring_view tag, std::wstring_view group);
+        void settle_replaced(std::int64_t replaced, bool shown, std::wstring_view tag, std::wstring_view group);
+        void submit_scheduled(const deferred_toast &toast);
+        void stop_scheduler();
+        void schedule_loop();
+        std::size_t drain_retired(std::size_t limit);
+        void attach_handle(const std::int64_t id, std::unique_ptr<notification_backend::toast_handle> handle);
+        void enqueue_async(async_request request);
+        void start_dispatcher();
+        void stop_dispatcher();
+        bool pop_async(async_request& request);
+        void dispatch_loop();
+        static void complete_async(async_request &request, const show_result &result);
+        bool defers_events() const noexcept;
+        void post_event(pending_event &&event);
+        void deliver_event(const pending_event &event);
+        void stop_event_delivery();
+        void event_loop();
+        static std::size_t drain_events(event_channel &channel);
+        static void wake_producers(event_channel &channel);
+        static void run_submitted(event_channel &channel);
+        notification_error register_handler(const notification_template &notification, internals::inline_handler &handler,
+                                            std::int64_t &id, std::int64_t *replaced);
+
+        /**
+         * @brief 调用后端，若通知器已失效则重新创建并重试一次
+         */
+        template <typename Fx>
+        HRESULT invoke_backend(Fx &&fx) {
+            HRESULT hr = fx(*backend_);
+            if (internals::is_stale_notifier_error(hr) && SUCCEEDED(backend_->create_notifier(aumi_))) {
+                hr = fx(*backend_);
+            }
+            return hr;
+        }
+
+        void on_activated(std::int64_t id, const activation &args) override;
+        void on_dismissed(std::int64_t id, notification_handler::dismissal_reason reason) override;
+        void on_failed(std::int64_t id) override;
+        void on_phase(utility::pipeline_phase phase, std::chrono::nanoseconds elapsed) override;
+        void count_show(HRESULT hr) noexcept;
+        void count_event(notification_event::event_type type) noexcept;
+        void count_event(const activation &args) noexcept;
+        void dispatch_activated(std::int64_t id, const activation &args);
+        void dispatch_dismissed(std::int64_t id, notification_handler::dismissal_reason reason);
+        void dispatch_failed(std::int64_t id);
 
-        std::optional<winrt::Windows::UI::Notifications::ToastNotifier> create_notifier() const;
         void set_error(notification_error *error, notification_error value);
     };
 }
@@ -20,12 +20,31 @@
 #include <unordered_map>
 #include <array>
 #include <functional>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
 
+#ifdef _MSC_VER
 #pragma comment(lib, "shlwapi")
 #pragma comment(lib, "user32")
+#endif
 
 using namespace rainy;
 
+#ifdef _WIN32
+static_assert(static_cast<int>(notification_template_type::image_and_text01) ==
+                  static_cast<int>(winrt::Windows::UI::Notifications::ToastTemplateType::ToastImageAndText01) &&
+              static_cast<int>(notification_template_type::text04) ==
+                  static_cast<int>(winrt::Windows::UI::Notifications::ToastTemplateType::ToastText04));
+static_assert(static_cast<int>(notification_handler::dismissal_reason::user_canceled) ==
+                  static_cast<int>(winrt::Windows::UI::Notifications::ToastDismissalReason::UserCanceled) &&
+              static_cast<int>(notification_handler::dismissal_reason::application_hidden) ==
+                  static_cast<int>(winrt::Windows::UI::Notifications::ToastDismissalReason::ApplicationHidden) &&
+              static_cast<int>(notification_handler::dismissal_reason::timed_out) ==
+                  static_cast<int>(winrt::Windows::UI::Notifications::ToastDismissalReason::TimedOut));
+
 #define DEFAULT_SHELL_LINKS_PATH L"\\Microsoft\\Windows\\Start Menu\\Programs\\"
 #define DEFAULT_LINK_FORMAT      L".lnk"
 
@@ -341,8 +360,10 @@ namespace rainy {
         return fp(app_id.data());
     }
 }
+#endif
 
 namespace util {
+#ifdef _WIN32
     inline RTL_OSVERSIONINFOW get_real_os_version() {
         static rainy::function_pointer<NTSTATUS(*)(PRTL_OSVERSIONINFOW)> fx_ptr;
         RTL_OSVERSIONINFOW rovi = { 0 };
@@ -362,6 +383,94 @@ namespace util {
         return rovi;
     }
 
+    /**
+     * @brief 获取系统能力，系统版本只在首次调用时探测（线程安全）
+     */
+    inline const platform_capabilities& os_capabilities() {
+        static const platform_capabilities capabilities = [] {
+            constexpr auto MinimumSupportedVersion = 6;
+            const RTL_OSVERSIONINFOW version = get_real_os_version();
+            platform_capabilities result;
+            result.modern_features = version.dwMajorVersion > MinimumSupportedVersion;
+            result.win10_anniversary = version.dwBuildNumber >= 14393;
+            result.hero_image = result.win10_anniversary;
+            result.crop_circle = result.win10_anniversary;
+            result.input_support = result.modern_features;
+            return result;
+        }();
+        return capabilities;
+    }
+#else
+    /**
+     * @brief 非Windows平台上没有系统通知服务
+     */
+    inline const platform_capabilities& os_capabilities() {
+        static const platform_capabilities capabilities{};
+        return capabilities;
+    }
+#endif
+
+    /**
+     * @brief 进程内的实例标签池。标签在id_generator析构时归还，按轮转顺序分配，推迟刚归还的标签被再次使用
+     */
+    class instance_tag_pool {
+    public:
+        static constexpr std::size_t capacity = std::size_t{1} << 15;
+
+        static instance_tag_pool& instance() noexcept {
+            static instance_tag_pool pool;
+            return pool;
+        }
+
+        std::uint64_t acquire() noexcept {
+            std::lock_guard<std::mutex> guard(lock_);
+            for (std::size_t i = 0; i < capacity; ++i) {
+                const std::size_t tag = (cursor_ + i) % capacity;
+                if (!used_[tag]) {
+                    used_[tag] = true;
+                    cursor_ = tag + 1;
+                    return tag;
+                }
+            }
+            // 同时存在的实例超过标签数量，此后的实例与已有实例共享标签，不再保证ID不冲突
+            return cursor_++ % capacity;
+        }
+
+        void release(const std::uint64_t tag) noexcept {
+            std::lock_guard<std::mutex> guard(lock_);
+            used_[static_cast<std::size_t>(tag)] = false;
+        }
+
+    private:
+        std::mutex lock_;
+        std::vector<bool> used_ = std::vector<bool>(capacity);
+        std::size_t cursor_{0};
+    };
+
+    /**
+     * @brief 为库创建的线程进入多线程套间
+     * @return 是否需要在线程退出前调用leave_apartment
+     */
+    inline bool enter_apartment() noexcept {
+#ifdef _WIN32
+        try {
+            winrt::init_apartment(winrt::apartment_type::multi_threaded);
+            return true;
+        } catch (const winrt::hresult_error&) {
+            return false;
+        }
+#else
+        return false;
+#endif
+    }
+
+    inline void leave_apartment() noexcept {
+#ifdef _WIN32
+        winrt::uninit_apartment();
+#endif
+    }
+
+#ifdef _WIN32
     inline HRESULT get_default_executable_path(WCHAR* path, DWORD n_size = MAX_PATH) {
         DWORD written = ::GetModuleFileNameExW(GetCurrentProcess(), nullptr, path, n_size);
         return (written > 0) ? S_OK : E_FAIL;
@@ -388,6 +497,18 @@ namespace util {
         return hr;
     }
 
+    inline std::wstring default_shortcut_state_path(std::wstring_view aumi) {
+        WCHAR path[MAX_PATH]{L'\0'};
+        if (GetEnvironmentVariableW(L"LOCALAPPDATA", path, MAX_PATH) == 0) {
+            return {};
+        }
+        std::wstring result(path);
+        result += L"\\rainy-notification\\";
+        result += aumi;
+        result += L".shortcut";
+        return result;
+    }
+
 	inline PCWSTR as_string(winrt::Windows::Data::Xml::Dom::XmlDocument const& xml_document) {
 	    try {
 	        winrt::hstring xml = xml_document.GetXml();
@@ -412,50 +533,48 @@ namespace util {
         }
     }
 
-    template<typename FunctorT>
     inline winrt::hresult set_event_handlers(winrt::Windows::UI::Notifications::ToastNotification& notification,
-        std::shared_ptr<notification_handler> event_handler,
-        INT64 expiration_time,
+        notification_backend::event_sink& sink,
+        std::int64_t id,
+        winrt::Windows::Foundation::DateTime expiration_time,
         winrt::event_token& activated_token,
         winrt::event_token& dismissed_token,
-        winrt::event_token& failed_token,
-        FunctorT&& mark_as_ready_for_deletion_func) {
+        winrt::event_token& failed_token) {
 
-        activated_token = notification.Activated([event_handler, mark_as_ready_for_deletion_func](auto&& sender, auto&& args) {
+        activated_token = notification.Activated([&sink, id](auto&& sender, auto&& args) {
             if (auto activated_args = args.try_as<winrt::Windows::UI::Notifications::ToastActivatedEventArgs>()) {
-                winrt::hstring arguments = activated_args.Arguments();
-                if (arguments == L"action=reply") {
-                    auto user_input = activated_args.UserInput();  // Already have activated_args, no need to check again
-                    if (winrt::Windows::Foundation::IPropertyValue reply_value = user_input.Lookup(L"textBox").try_as<winrt::Windows::Foundation::IPropertyValue>()) {
-                        auto input = reply_value.GetString();
-                        event_handler->activated(input);
-                        return;
+                // hstring持有字符串的引用计数，回调期间直接以视图传递，不做复制
+                const winrt::hstring arguments = activated_args.Arguments();
+                std::array<winrt::hstring, notification_template::max_inputs * 2> storage;
+                std::array<user_input, notification_template::max_inputs> inputs;
+                std::size_t count = 0;
+                for (auto&& pair : activated_args.UserInput()) {
+                    if (count == inputs.size()) {
+                        break;
+                    }
+                    if (auto value = pair.Value().template try_as<winrt::Windows::Foundation::IPropertyValue>()) {
+                        storage[count * 2] = pair.Key();
+                        storage[count * 2 + 1] = value.GetString();
+                        inputs[count] = {storage[count * 2], storage[count * 2 + 1]};
+                        ++count;
                     }
                 }
-                if (!arguments.empty()) {
-                    event_handler->activated(std::stoi(arguments.c_str()));
-                }
-                else {
-                    event_handler->activated();
-                }
+                sink.on_activated(id, activation{arguments, {inputs.data(), count}});
             }
-            mark_as_ready_for_deletion_func();
             });
 
-        dismissed_token = notification.Dismissed([event_handler, expiration_time, mark_as_ready_for_deletion_func](auto&& sender, auto&& args) {
+        dismissed_token = notification.Dismissed([&sink, id, expiration_time](auto&& sender, auto&& args) {
             auto reason = args.Reason();
-            winrt::clock::time_point expiration_time_point(winrt::clock::from_time_t(expiration_time));
-            if (reason == winrt::Windows::UI::Notifications::ToastDismissalReason::UserCanceled && expiration_time &&
-                winrt::clock::now() >= expiration_time_point) {
+            // 平台在过期后回报的UserCanceled修正为TimedOut
+            if (reason == winrt::Windows::UI::Notifications::ToastDismissalReason::UserCanceled &&
+                expiration_time != winrt::Windows::Foundation::DateTime{} && winrt::clock::now() >= expiration_time) {
                 reason = winrt::Windows::UI::Notifications::ToastDismissalReason::TimedOut;
             }
-            event_handler->dismissed(static_cast<notification_handler::dismissal_reason>(reason));
-            mark_as_ready_for_deletion_func();
+            sink.on_dismissed(id, static_cast<notification_handler::dismissal_reason>(reason));
             });
 
-        failed_token = notification.Failed([event_handler, mark_as_ready_for_deletion_func](auto&& sender, auto&& args) {
-            event_handler->failed();
-            mark_as_ready_for_deletion_func();
+        failed_token = notification.Failed([&sink, id](auto&& sender, auto&& args) {
+            sink.on_failed(id);
             });
 
         return S_OK;
@@ -500,15 +619,99 @@ namespace util {
             return e.code();
         }
     }
+#endif
+}
+
+utility::id_generator::id_generator() noexcept : tag_(util::instance_tag_pool::instance().acquire() << counter_bits) {}
+
+utility::id_generator::~id_generator() {
+    util::instance_tag_pool::instance().release(tag_ >> counter_bits);
+}
+
+namespace util {
+    /**
+     * @brief 析构时向event_sink回报一个阶段的耗时。编译时关闭统计时不读取时钟
+     */
+    class phase_timer {
+    public:
+        phase_timer(notification_backend::event_sink &sink, const utility::pipeline_phase phase) noexcept
+#if RAINY_NOTIFICATION_METRICS
+            : sink_(&sink), phase_(phase), start_(std::chrono::steady_clock::now())
+#endif
+        {
+#if !RAINY_NOTIFICATION_METRICS
+            (void) sink;
+            (void) phase;
+#endif
+        }
+
+        phase_timer(const phase_timer &) = delete;
+        phase_timer &operator=(const phase_timer &) = delete;
+
+        ~phase_timer() {
+            stop();
+        }
+
+        /**
+         * @brief 结束当前阶段并立即开始下一个阶段，两者共用一次时钟读取
+         */
+        void next(const utility::pipeline_phase phase) noexcept {
+#if RAINY_NOTIFICATION_METRICS
+            if (sink_) {
+                const auto now = std::chrono::steady_clock::now();
+                sink_->on_phase(phase_, now - start_);
+                phase_ = phase;
+                start_ = now;
+            }
+#else
+            (void) phase;
+#endif
+        }
+
+        void stop() noexcept {
+#if RAINY_NOTIFICATION_METRICS
+            if (sink_) {
+                sink_->on_phase(phase_, std::chrono::steady_clock::now() - start_);
+                sink_ = nullptr;
+            }
+#endif
+        }
+
+    private:
+#if RAINY_NOTIFICATION_METRICS
+        notification_backend::event_sink *sink_;
+        utility::pipeline_phase phase_;
+        std::chrono::steady_clock::time_point start_;
+#endif
+    };
 }
 
-notification::notification() {}
+#ifdef _WIN32
+notification::notification() : backend_(std::make_shared<winrt_notification_backend>()) {
+#if RAINY_NOTIFICATION_METRICS
+    metrics_ = std::make_unique<utility::pipeline_metrics>();
+#endif
+}
+#else
+notification::notification() : backend_(std::make_shared<memory_notification_backend>()) {
+#if RAINY_NOTIFICATION_METRICS
+    metrics_ = std::make_unique<utility::pipeline_metrics>();
+#endif
+}
+#endif
 
 notification::~notification() {
+    join_startup_validation();
+    stop_scheduler();
+    stop_dispatcher();
+    stop_event_delivery();
     clear();
+    backend_->release_notifier();
+#ifdef _WIN32
     if (status[static_cast<int>(notification_status::has_winrt_initialized)]) {
         CoUninitialize();
     }
+#endif
 }
 
 void notification::set_app_name(std::wstring const& app_name) {
@@ -523,13 +726,35 @@ void notification::set_shortcut_policy(utility::shortcut_policy shortcut_policy)
     shortcut_policy_ = shortcut_policy;
 }
 
+void notification::set_backend(std::shared_ptr<notification_backend> backend) {
+    if (!backend) {
+        throw std::invalid_argument("The notification backend cannot be null.");
+    }
+    clear();
+    backend_->release_notifier();
+    backend_ = std::move(backend);
+    status[static_cast<int>(notification_status::is_initialized)] = false;
+}
+
+const std::shared_ptr<notification_backend>& notification::backend() const noexcept {
+    return backend_;
+}
+
 bool notification::is_supporting_modern_features() {
-    constexpr auto MinimumSupportedVersion = 6;
-    return util::get_real_os_version().dwMajorVersion > MinimumSupportedVersion;
+    return util::os_capabilities().modern_features;
 }
 
 bool notification::is_win10_anniversary_or_higher() {
-    return util::get_real_os_version().dwBuildNumber >= 14393;
+    return util::os_capabilities().win10_anniversary;
+}
+
+const platform_capabilities& notification::capabilities() const noexcept {
+    return capabilities_;
+}
+
+void notification::set_capabilities(const platform_capabilities& capabilities) noexcept {
+    capabilities_ = capabilities;
+    has_injected_capabilities_ = true;
 }
 
 std::wstring notification::make_aumi(std::wstring const& company_name, std::wstring const& product_name,
@@ -553,7 +778,12 @@ std::wstring const& notification::strerror(notification_error error) {
         {notification_error::shell_link_not_created,       L"The library was not able to create a Shell Link for the app"                   },
         {notification_error::invalid_app_user_model_id,    L"The AUMI is not a valid one"                                                   },
         {notification_error::invalid_parameters,           L"Invalid parameters, please double-check the AUMI or App Name"                  },
+        {notification_error::invalid_handler,              L"The event handler is invalid"                                                  },
         {notification_error::not_displayed,                L"The toast was created correctly but notification was not able to display the toast"},
+        {notification_error::duplicate_id,                 L"The toast ID is already used by a toast that is still displayed"               },
+        {notification_error::queue_full,                   L"The asynchronous show queue is full and the request was dropped"               },
+        {notification_error::rate_limited,                 L"The toast was suppressed by the rate limiter"                                  },
+        {notification_error::live_limit_reached,           L"The live toast limit was reached and no older toast could be evicted"         },
         {notification_error::unknown_error,                L"Unknown error"                                                                 }
     };
 
@@ -562,6 +792,7 @@ std::wstring const& notification::strerror(notification_error error) {
     return iter->second;
 }
 
+#ifdef _WIN32
 utility::shortcut_result utility::create_shortcut(shortcut_policy policy,std::wstring_view appname, std::wstring_view aumi, bool& winrt_init_flag) {
     if (aumi.empty() || appname.empty()) {
         return utility::shortcut_result::missing_parameters;
@@ -583,23 +814,59 @@ utility::shortcut_result utility::create_shortcut(shortcut_policy policy,std::ws
     hr = create_shelllink(policy, appname, aumi);
     return SUCCEEDED(hr) ? utility::shortcut_result::was_created : utility::shortcut_result::create_failed;
 }
+#endif
 
 bool notification::init(notification_error* error) {
     status[static_cast<int>(notification_status::is_initialized)] = false;
+#ifdef _WIN32
     if (shortcut_policy_ == utility::shortcut_policy::ignore) {
         if (is_enable_modern_features()) {
             set_error(error, notification_error::shell_link_not_created);
             return false;
         }
     }
+#endif
     set_error(error, notification_error::no_error);
     if (aumi_.empty() || appname_.empty()) {
         set_error(error, notification_error::invalid_parameters);
         throw std::runtime_error("Error while initializing, did you set up a valid AUMI and App name?");
         return false;
     }
-    if (static_cast<int>(utility::create_shortcut(shortcut_policy_, appname_, aumi_,
-                                                  status[static_cast<int>(notification_status::has_winrt_initialized)])) < 0) {
+    join_startup_validation();
+    std::function<bool()> background_validation;
+#ifdef _WIN32
+    bool& has_winrt_initialized = status[static_cast<int>(notification_status::has_winrt_initialized)];
+    if (shortcut_validation_ == utility::shortcut_validation::cached) {
+        if (!has_winrt_initialized) {
+            has_winrt_initialized = util::enter_apartment();
+        }
+        if (!has_winrt_initialized) {
+            set_error(error, notification_error::shell_link_not_created);
+            return false;
+        }
+        // 只读取快捷方式的修改时间，状态未变化时不调用任何存储API
+        WCHAR executable_path[MAX_PATH]{L'\0'};
+        WCHAR link_path[MAX_PATH]{L'\0'};
+        util::get_default_executable_path(executable_path);
+        util::get_default_shell_link_path(appname_, link_path);
+        auto cache = std::make_shared<utility::shortcut_cache>(file_system_ ? file_system_ : std::make_shared<utility::std_file_system>(),
+                                                               shortcut_state_path_.empty() ? util::default_shortcut_state_path(aumi_)
+                                                                                            : shortcut_state_path_);
+        const auto current = cache->probe(appname_, aumi_, executable_path, link_path);
+        if (!current || !cache->is_current(*current)) {
+            background_validation = [cache, policy = shortcut_policy_, appname = appname_, aumi = aumi_,
+                                     executable = std::wstring{executable_path}, link = std::wstring{link_path}] {
+                bool has_apartment = true; // 后台线程已进入套间
+                if (static_cast<int>(utility::create_shortcut(policy, appname, aumi, has_apartment)) < 0) {
+                    return false;
+                }
+                if (const auto validated = cache->probe(appname, aumi, executable, link)) {
+                    cache->store(*validated);
+                }
+                return true;
+            };
+        }
+    } else if (static_cast<int>(utility::create_shortcut(shortcut_policy_, appname_, aumi_, has_winrt_initialized)) < 0) {
         set_error(error, notification_error::shell_link_not_created);
         return false;
     }
@@ -608,10 +875,109 @@ bool notification::init(notification_error* error) {
         throw std::runtime_error("Error while attaching the AUMI to the current proccess.");
         return false;
     }
+#endif
+    if (!has_injected_capabilities_) {
+        capabilities_ = backend_->query_capabilities();
+    }
+    if (FAILED(backend_->create_notifier(aumi_))) {
+        set_error(error, notification_error::invalid_app_user_model_id);
+        return false;
+    }
+    startup_failed_.store(false, std::memory_order_release);
+    if (background_validation) {
+        start_background_validation(std::move(background_validation));
+    }
     status[static_cast<int>(notification_status::is_initialized)] = true;
     return true;
 }
 
+void notification::set_shortcut_validation(const utility::shortcut_validation validation, std::wstring state_path,
+                                           std::shared_ptr<utility::file_system> fs) {
+    shortcut_validation_ = validation;
+    shortcut_state_path_ = std::move(state_path);
+    file_system_ = std::move(fs);
+}
+
+void notification::start_background_validation(std::function<bool()> validate) {
+    join_startup_validation();
+    startup_pending_.store(true, std::memory_order_release);
+    startup_validator_ = std::thread([this, validate = std::move(validate)] {
+        const bool has_apartment = util::enter_apartment();
+        bool succeeded = false;
+        try {
+            succeeded = validate();
+        } catch (...) {
+        }
+        finish_startup(succeeded);
+        if (has_apartment) {
+            util::leave_apartment();
+        }
+    });
+}
+
+bool notification::defer_show(const notification_backend::toast_request& request, const std::int64_t replaced) {
+    if (!startup_pending_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(startup_lock_);
+    if (!startup_pending_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    deferred_.push_back({request.id, std::wstring{request.xml}, request.expiration, {request.data.begin(), request.data.end()},
+                         std::wstring{request.tag}, std::wstring{request.group}, request.priority, replaced});
+    return true;
+}
+
+void notification::finish_startup(const bool succeeded) {
+    if (!succeeded) {
+        startup_failed_.store(true, std::memory_order_release);
+    }
+    // 提交期间仍保持排队状态，保证排队的通知先于之后显示的通知提交
+    for (;;) {
+        std::vector<deferred_toast> batch;
+        {
+            std::lock_guard<std::mutex> guard(startup_lock_);
+            if (deferred_.empty()) {
+                startup_pending_.store(false, std::memory_order_release);
+                return;
+            }
+            batch.swap(deferred_);
+        }
+        for (const auto& toast : batch) {
+            submit_deferred(toast, succeeded, toast.replaced);
+        }
+    }
+}
+
+void notification::submit_deferred(const deferred_toast& toast, const bool validated, const std::int64_t replaced) {
+    // 排队期间被hide的通知已不在注册表中，不再显示
+    if (validated && notifys.visit(toast.id, [](notify&) {}) && reserve_live(toast.id, toast.priority, replaced)) {
+        const notification_backend::toast_request request{toast.id,  toast.xml,   toast.expiration, toast.data,
+                                                          toast.tag, toast.group, toast.priority};
+        std::unique_ptr<notification_backend::toast_handle> handle;
+        util::phase_timer timing(*this, utility::pipeline_phase::show);
+        const HRESULT hr = invoke_backend([&](notification_backend& backend) { return backend.show(request, *this, handle); });
+        timing.stop();
+        count_show(hr);
+        if (SUCCEEDED(hr)) {
+            attach_handle(toast.id, std::move(handle));
+            track_live(toast.id, toast.expiration, schedule_now());
+            settle_replaced(replaced, true, toast.tag, toast.group);
+            return;
+        }
+        untrack_live(toast.id);
+    }
+    settle_replaced(replaced, false, toast.tag, toast.group);
+    // show已经返回了ID，失败只能经由处理器报告
+    on_failed(toast.id);
+}
+
+void notification::join_startup_validation() {
+    if (startup_validator_.joinable()) {
+        startup_validator_.join();
+    }
+}
+
 bool notification::is_initialized() const {
     return status[static_cast<int>(notification_status::is_initialized)];
 }
@@ -624,6 +990,133 @@ const std::wstring& notification::app_user_model_id() const {
     return aumi_;
 }
 
+std::optional<std::int64_t> utility::std_file_system::last_write_time(std::wstring_view path) {
+    std::error_code ec;
+    const auto time = std::filesystem::last_write_time(std::filesystem::path(path), ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return static_cast<std::int64_t>(time.time_since_epoch().count());
+}
+
+bool utility::std_file_system::read_file(std::wstring_view path, std::string& contents) {
+    std::ifstream stream(std::filesystem::path(path), std::ios::binary);
+    if (!stream) {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    return !stream.bad();
+}
+
+bool utility::std_file_system::write_file(std::wstring_view path, std::string_view contents) {
+    const std::filesystem::path target(path);
+    std::error_code ec;
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), ec);
+    }
+    std::ofstream stream(target, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        return false;
+    }
+    stream.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    return static_cast<bool>(stream);
+}
+
+utility::shortcut_cache::shortcut_cache(std::shared_ptr<file_system> fs, std::wstring state_path) :
+    fs_(std::move(fs)), state_path_(std::move(state_path)) {
+}
+
+std::optional<utility::shortcut_state> utility::shortcut_cache::probe(std::wstring_view appname, std::wstring_view aumi,
+                                                                      std::wstring_view executable_path,
+                                                                      std::wstring_view link_path) const {
+    const auto time = fs_ ? fs_->last_write_time(link_path) : std::nullopt;
+    if (!time) {
+        return std::nullopt;
+    }
+    return shortcut_state{std::wstring{appname}, std::wstring{aumi}, std::wstring{executable_path}, *time};
+}
+
+bool utility::shortcut_cache::is_current(const shortcut_state& state) const {
+    std::string contents;
+    if (!fs_ || state_path_.empty() || !fs_->read_file(state_path_, contents)) {
+        return false;
+    }
+    const auto stored = decode(contents);
+    return stored && *stored == state;
+}
+
+bool utility::shortcut_cache::store(const shortcut_state& state) const {
+    return fs_ && !state_path_.empty() && fs_->write_file(state_path_, encode(state));
+}
+
+namespace util {
+    constexpr char shortcut_state_magic[4] = {'R', 'N', 'S', 'C'};
+    constexpr std::uint8_t shortcut_state_version = 1;
+
+    template <typename Ty>
+    void append_raw(std::string& out, const Ty& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(Ty));
+    }
+
+    template <typename Ty>
+    bool read_raw(std::string_view& in, Ty& value) {
+        if (in.size() < sizeof(Ty)) {
+            return false;
+        }
+        std::memcpy(&value, in.data(), sizeof(Ty));
+        in.remove_prefix(sizeof(Ty));
+        return true;
+    }
+
+    inline void append_wide(std::string& out, const std::wstring& value) {
+        append_raw(out, static_cast<std::uint32_t>(value.size()));
+        out.append(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(wchar_t));
+    }
+
+    inline bool read_wide(std::string_view& in, std::wstring& value) {
+        std::uint32_t length = 0;
+        if (!read_raw(in, length) || in.size() / sizeof(wchar_t) < length) {
+            return false;
+        }
+        value.resize(length);
+        std::memcpy(value.data(), in.data(), static_cast<std::size_t>(length) * sizeof(wchar_t));
+        in.remove_prefix(static_cast<std::size_t>(length) * sizeof(wchar_t));
+        return true;
+    }
+}
+
+std::string utility::shortcut_cache::encode(const shortcut_state& state) {
+    std::string out(util::shortcut_state_magic, sizeof(util::shortcut_state_magic));
+    util::append_raw(out, util::shortcut_state_version);
+    util::append_raw(out, static_cast<std::uint8_t>(sizeof(wchar_t)));
+    util::append_wide(out, state.appname);
+    util::append_wide(out, state.aumi);
+    util::append_wide(out, state.executable_path);
+    util::append_raw(out, state.link_write_time);
+    return out;
+}
+
+std::optional<utility::shortcut_state> utility::shortcut_cache::decode(std::string_view data) {
+    if (data.size() < sizeof(util::shortcut_state_magic) ||
+        std::memcmp(data.data(), util::shortcut_state_magic, sizeof(util::shortcut_state_magic)) != 0) {
+        return std::nullopt;
+    }
+    data.remove_prefix(sizeof(util::shortcut_state_magic));
+    std::uint8_t version = 0;
+    std::uint8_t char_size = 0;
+    if (!util::read_raw(data, version) || version != util::shortcut_state_version || !util::read_raw(data, char_size) ||
+        char_size != sizeof(wchar_t)) {
+        return std::nullopt;
+    }
+    shortcut_state state;
+    if (!util::read_wide(data, state.appname) || !util::read_wide(data, state.aumi) || !util::read_wide(data, state.executable_path) ||
+        !util::read_raw(data, state.link_write_time) || !data.empty()) {
+        return std::nullopt;
+    }
+    return state;
+}
+
+#ifdef _WIN32
 HRESULT utility::validate_shelllink(bool& was_changed,std::wstring_view appname,std::wstring_view aumi) {
     try {
         using namespace winrt::Windows::Storage;
@@ -703,13 +1196,13 @@ HRESULT utility::create_shelllink(shortcut_policy policy, std::wstring_view appn
 	PropVariantClear(&appIdPropVar);
     return hr;
 }
+#endif
 
-static std::map<std::int64_t, std::shared_ptr<winrt::Windows::UI::Notifications::ToastNotification>> toast_mapper;
-
-std::int64_t notification::show_impl(const notification_template& toast, std::shared_ptr<notification_handler> handler, notification_error* error) {
+std::int64_t notification::show_impl(const notification_template& toast, internals::inline_handler handler, notification_error* error,
+                                     const std::wstring* payload) {
+    const util::phase_timer timing(*this, utility::pipeline_phase::total);
     set_error(error, notification_error::no_error);
     std::int64_t id = -1;
-    HRESULT hr{ 0 };
     if (!is_initialized()) {
         set_error(error, notification_error::not_initialized);
         return id;
@@ -718,124 +1211,1879 @@ std::int64_t notification::show_impl(const notification_template& toast, std::sh
         set_error(error, notification_error::invalid_handler);
         return id;
     }
-    using namespace winrt::Windows::UI::Notifications;
-    using namespace winrt::Windows::Data::Xml::Dom;
-    auto notifier = ToastNotificationManager::CreateToastNotifier(winrt::hstring{ aumi_ });
-    utility::xml_notifcation_field xml(utility::xml_notifcation_field::context_bridge(*this), toast);
-    auto notification = std::make_shared<ToastNotification>(xml);
-    std::int64_t expiration = 0, relative_expiration = toast.expiration();
-    if (relative_expiration > 0) {
-        winrt::Windows::Foundation::DateTime now = winrt::clock::now(); // 将相对过期时间转换为时间点
-        winrt::Windows::Foundation::DateTime expiration_time = now + std::chrono::milliseconds(relative_expiration);
-        notification->ExpirationTime(expiration_time);
-    }
-    GUID guid;
-    HRESULT hr_guid = CoCreateGuid(&guid);
-    id = guid.Data1;
-    winrt::event_token activated_token, dismissed_token, failed_token;
-    winrt::check_hresult(hr);
-    hr = util::set_event_handlers(*notification, handler, expiration, activated_token, dismissed_token, failed_token, [this, id]() { mark_as_ready_for_deletion(id); });
-    if (FAILED(hr)) {
-        set_error(error, notification_error::invalid_handler);
+    drain_retired(cleanup_batch_size_.load(std::memory_order_relaxed));
+    if (!admission_.is_enabled()) {
+        return show_direct(toast, handler, error, payload);
     }
-    winrt::check_hresult(hr);
-    notifier.Show(*notification);
-    toast_mapper.insert({ id, notification });
-    notifys.emplace(id, notify(*toast_mapper[id], activated_token, dismissed_token, failed_token));
-    return FAILED(hr) ? -1 : id;
+    flush_coalesced();
+    std::int64_t coalesced_id = -1;
+    switch (admission_.admit(toast, handler, coalesced_id)) {
+        case utility::admission_controller::decision::suppress:
+            set_error(error, notification_error::rate_limited);
+            return -1;
+        case utility::admission_controller::decision::merge:
+            if (handler) {
+                retire_detached(std::move(handler), notification_event::event_type::dismissed);
+            }
+            return coalesced_id;
+        case utility::admission_controller::decision::admit:
+            return show_direct(toast, handler, error, payload);
+        case utility::admission_controller::decision::open:
+            break;
+    }
+    id = show_direct(toast, handler, error, payload);
+    if (auto orphan = admission_.opened(toast.coalescing_key(), id)) {
+        retire_detached(std::move(orphan), notification_event::event_type::failed);
+    }
+    return id;
 }
 
-void notification::mark_as_ready_for_deletion(const std::int64_t id) {
-    for (auto it = notifys.begin(); it != notifys.end();) {
-        if (it->second.is_ready_for_deletion()) {
-            it->second.remove_tokens();
-            it = notifys.erase(it);
-        } else {
-            ++it;
-        }
+std::int64_t notification::show_direct(const notification_template& toast, internals::inline_handler& handler,
+                                       notification_error* error, const std::wstring* payload) {
+    std::int64_t id = -1;
+    if (startup_failed_.load(std::memory_order_acquire)) {
+        set_error(error, notification_error::shell_link_not_created);
+        return -1;
+    }
+    std::wstring rendered;
+    if (!payload) {
+        const util::phase_timer timing(*this, utility::pipeline_phase::render);
+        template_cache_.render(utility::context_bridge(*this), toast, rendered);
+        payload = &rendered;
+    }
+    // 先登记处理器，确保在Show返回前就触发的事件也能找到它
+    std::int64_t replaced = -1;
+    if (const auto result = register_handler(toast, handler, id, &replaced); result != notification_error::no_error) {
+        set_error(error, result);
+        return -1;
+    }
+    // 显示失败时把处理器交还给调用者；已被事件取走的处理器保留在条目中，随条目析构
+    const auto unregister = [&] {
+        notifys.visit(id, [&](notify& entry) {
+            if (!entry.retired.exchange(true, std::memory_order_acq_rel)) {
+                handler = std::move(entry.handler);
+            }
+        });
+        notifys.erase(id);
+        group_index_.erase(id);
+        settle_replaced(replaced, false, toast.tag(), toast.group());
+    };
+    const notification_backend::toast_request request{id,          *payload,     toast.expiration(), toast.bindings(),
+                                                      toast.tag(), toast.group(), toast.priority()};
+    // 快捷方式仍在后台校验时先排队，校验完成后按顺序提交
+    if (defer_show(request, replaced)) {
+        return id;
     }
-    auto const iter = notifys.find(id);
-    if (iter != notifys.end()) {
-        notifys[id].mark_as_ready_for_deletion();
+    if (!reserve_live(id, toast.priority(), replaced)) {
+        unregister();
+        set_error(error, notification_error::live_limit_reached);
+        return -1;
+    }
+    std::unique_ptr<notification_backend::toast_handle> handle;
+    util::phase_timer timing(*this, utility::pipeline_phase::show);
+    const HRESULT hr = invoke_backend([&](notification_backend& backend) { return backend.show(request, *this, handle); });
+    timing.stop();
+    count_show(hr);
+    if (FAILED(hr)) {
+        unregister();
+        untrack_live(id);
+        set_error(error, notification_error::not_displayed);
+        return -1;
     }
+    attach_handle(id, std::move(handle));
+    track_live(id, toast.expiration(), schedule_now());
+    settle_replaced(replaced, true, toast.tag(), toast.group());
+    return id;
 }
 
-bool notification::hide(const std::int64_t id) {
-    if (!is_initialized()) {
-        throw std::runtime_error("Error when hiding the toast. notification is not initialized.");
+std::vector<notification::batch_result> notification::show_batch_impl(std::span<const notification_template> notifications,
+                                                                     std::shared_ptr<notification_handler> handler) {
+    const std::size_t count = notifications.size();
+    std::vector<batch_result> results(count, batch_result{ -1, notification_error::no_error });
+    if (!is_initialized() || !handler || startup_failed_.load(std::memory_order_acquire)) {
+        const auto error = !is_initialized() ? notification_error::not_initialized
+                           : !handler        ? notification_error::invalid_handler
+                                             : notification_error::shell_link_not_created;
+        for (auto& result : results) {
+            result.error = error;
+        }
+        return results;
     }
-    auto iter = notifys.find(id);
-    if (iter == notifys.end()) {
-        return false;
+    drain_retired(cleanup_batch_size_.load(std::memory_order_relaxed));
+    // 先构建全部XML
+    const utility::context_bridge ctx_bridge(*this);
+    std::vector<std::wstring> payloads(count);
+    std::vector<notification_backend::toast_request> requests;
+    requests.reserve(count);
+    std::vector<std::size_t> indices;
+    indices.reserve(count);
+    std::vector<std::int64_t> replaced;
+    replaced.reserve(count);
+    notifys.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        {
+            const util::phase_timer timing(*this, utility::pipeline_phase::render);
+            template_cache_.render(ctx_bridge, notifications[i], payloads[i]);
+        }
+        std::int64_t id = -1;
+        std::int64_t previous = -1;
+        internals::inline_handler shared_handler(handler);
+        if (const auto result = register_handler(notifications[i], shared_handler, id, &previous); result != notification_error::no_error) {
+            results[i].error = result;
+            continue;
+        }
+        requests.push_back({ id, payloads[i], notifications[i].expiration(), notifications[i].bindings(), notifications[i].tag(),
+                             notifications[i].group(), notifications[i].priority() });
+        if (defer_show(requests.back(), previous)) {
+            requests.pop_back();
+            results[i].id = id;
+            continue;
+        }
+        if (!reserve_live(id, notifications[i].priority(), previous)) {
+            requests.pop_back();
+            notifys.erase(id);
+            group_index_.erase(id);
+            settle_replaced(previous, false, notifications[i].tag(), notifications[i].group());
+            results[i].error = notification_error::live_limit_reached;
+            continue;
+        }
+        indices.push_back(i);
+        replaced.push_back(previous);
     }
-    auto notifier = create_notifier();
-    if (!notifier) {
-        return false;
+    // 一次性提交，通知器失效时只重试受影响的项
+    const std::size_t submitted = requests.size();
+    std::vector<std::unique_ptr<notification_backend::toast_handle>> handles(submitted);
+    std::vector<HRESULT> hrs(submitted, S_OK);
+    backend_->show_batch(requests, *this, handles, hrs);
+    if (std::any_of(hrs.begin(), hrs.end(), internals::is_stale_notifier_error) && SUCCEEDED(backend_->create_notifier(aumi_))) {
+        for (std::size_t i = 0; i < submitted; ++i) {
+            if (internals::is_stale_notifier_error(hrs[i])) {
+                hrs[i] = backend_->show(requests[i], *this, handles[i]);
+            }
+        }
     }
-    auto& notify = iter->second;
-    notifier.value().Hide(notify.notification());
-    notify.remove_tokens();
-    notifys.erase(iter);
-    const auto it = toast_mapper.find(id);
-    if (it != toast_mapper.end()) {
-        toast_mapper.erase(it);
+    for (std::size_t i = 0; i < submitted; ++i) {
+        auto& result = results[indices[i]];
+        count_show(hrs[i]);
+        if (FAILED(hrs[i])) {
+            notifys.erase(requests[i].id);
+            group_index_.erase(requests[i].id);
+            untrack_live(requests[i].id);
+            settle_replaced(replaced[i], false, requests[i].tag, requests[i].group);
+            result.error = notification_error::not_displayed;
+            continue;
+        }
+        attach_handle(requests[i].id, std::move(handles[i]));
+        track_live(requests[i].id, requests[i].expiration, schedule_now());
+        settle_replaced(replaced[i], true, requests[i].tag, requests[i].group);
+        result.id = requests[i].id;
     }
-    return true;
+    return results;
 }
 
-void rainy::notification::set_modern_status(const bool enable) noexcept {
-    status[static_cast<int>(notification_status::enable_modern_features)] = enable;
+std::future<notification::show_result> notification::show_async(const notification_template& notification,
+                                                                std::shared_ptr<notification_handler> handler) {
+    auto promise = std::make_shared<std::promise<show_result>>();
+    auto future = promise->get_future();
+    show_async(notification, std::move(handler), [promise](const show_result& result) { promise->set_value(result); });
+    return future;
 }
 
-bool rainy::notification::is_enable_modern_features() const noexcept {
-    return status[static_cast<int>(notification_status::enable_modern_features)];
+std::future<notification::show_result> notification::show_async_impl(const notification_template& notification,
+                                                                     internals::inline_handler handler) {
+    auto promise = std::make_shared<std::promise<show_result>>();
+    auto future = promise->get_future();
+    async_request request;
+    request.notification.emplace(notification);
+    request.handler = std::move(handler);
+    request.completion = [promise](const show_result& result) { promise->set_value(result); };
+    enqueue_async(std::move(request));
+    return future;
 }
 
-void notification::clear() {
-    auto notify = create_notifier();
-    if (!notify) {
+void notification::show_async(const notification_template& notification, std::shared_ptr<notification_handler> handler,
+                              completion_callback completion) {
+    async_request request;
+    request.notification.emplace(notification);
+    request.handler = std::move(handler);
+    request.completion = std::move(completion);
+    enqueue_async(std::move(request));
+}
+
+void notification::set_backpressure_policy(const backpressure_policy policy) noexcept {
+    backpressure_.store(policy, std::memory_order_relaxed);
+}
+
+void notification::set_async_queue_capacity(const std::size_t capacity) noexcept {
+    std::lock_guard<std::mutex> guard(async_lock_);
+    async_queue_capacity_ = capacity;
+}
+
+void notification::complete_async(async_request& request, const show_result& result) {
+    if (request.completion) {
+        request.completion(result);
+    }
+    request = async_request{};
+}
+
+void notification::enqueue_async(async_request request) {
+    if (!is_initialized()) {
+        complete_async(request, { -1, notification_error::not_initialized });
+        return;
+    }
+    if (!request.handler) {
+        complete_async(request, { -1, notification_error::invalid_handler });
+        return;
+    }
+    start_dispatcher();
+    if (!async_started_.load(std::memory_order_acquire)) {
+        complete_async(request, { -1, notification_error::not_displayed }); // 启动前已停止
         return;
     }
-    for (auto& data : notifys) {
-        auto& notifyData = data.second;
-        notify.value().Hide(notifyData.notification());
-        notifyData.remove_tokens();
+    // 各优先级的队列相互独立，低优先级的积压不会挤占高优先级请求的空间
+    auto& queue = *async_queues_[static_cast<std::size_t>(request.notification->priority())];
+    while (!queue.try_push(std::move(request))) {
+        if (async_stopping_.load(std::memory_order_acquire)) {
+            complete_async(request, { -1, notification_error::not_displayed });
+            return;
+        }
+        switch (backpressure_.load(std::memory_order_relaxed)) {
+            case backpressure_policy::reject:
+                complete_async(request, { -1, notification_error::queue_full });
+                return;
+            case backpressure_policy::drop_oldest: {
+                async_request victim;
+                if (queue.try_pop(victim)) {
+                    complete_async(victim, { -1, notification_error::queue_full });
+                }
+                break;
+            }
+            case backpressure_policy::block: {
+                const std::uint32_t observed = async_space_.load(std::memory_order_acquire);
+                if (queue.size_approx() < queue.capacity()) {
+                    break; // 读取observed之前已有空位，直接重试
+                }
+                blocked_producers_.fetch_add(1, std::memory_order_acq_rel);
+                async_space_.wait(observed, std::memory_order_acquire);
+                blocked_producers_.fetch_sub(1, std::memory_order_acq_rel);
+                break;
+            }
+        }
     }
-    notifys.clear();
+    async_signal_.fetch_add(1, std::memory_order_release);
+    async_signal_.notify_one();
 }
 
-HRESULT utility::xml_notifcation_field::set_attribution_text_field( std::wstring_view text) {
-    util::create_element(xml, L"binding", L"text", { L"placement" });
-    try {
-        auto node_list = xml.GetElementsByTagName(L"text"); // 获取 text 节点列表
-        for (uint32_t i = 0; i < node_list.Size(); ++i) {
-            auto text_node = node_list.GetAt(i);
-            auto attributes = text_node.Attributes();
-            // 获取 "placement" 属性
-            auto edited_node = attributes.GetNamedItem(L"placement");
-            if (edited_node) {
-                // 设置 attribution 字段
-                util::set_node_string_value(L"attribution", &edited_node, xml);
-                // 设置文本字段
-                return set_text_field(text, i);
-            }
+void notification::start_dispatcher() {
+    if (async_started_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(async_lock_);
+    if (dispatcher_.joinable() || async_stopping_.load(std::memory_order_acquire)) {
+        return;
+    }
+    for (auto& queue : async_queues_) {
+        if (!queue) {
+            queue = std::make_unique<utility::bounded_queue<async_request>>(async_queue_capacity_);
         }
-        return S_OK;
     }
-    catch (const winrt::hresult_error& e) {
-        return e.code();
+    dispatcher_ = std::thread(&notification::dispatch_loop, this);
+    async_started_.store(true, std::memory_order_release);
+}
+
+void notification::stop_dispatcher() {
+    std::lock_guard<std::mutex> guard(async_lock_);
+    async_stopping_.store(true, std::memory_order_release);
+    if (!dispatcher_.joinable()) {
+        return;
+    }
+    async_signal_.fetch_add(1, std::memory_order_release);
+    async_signal_.notify_one();
+    dispatcher_.join();
+    async_space_.fetch_add(1, std::memory_order_release);
+    async_space_.notify_all();
+    // 分发线程退出后仍留在队列中的请求不再显示
+    async_request request;
+    for (auto& queue : async_queues_) {
+        while (queue->try_pop(request)) {
+            complete_async(request, { -1, notification_error::not_displayed });
+        }
+    }
+}
+
+bool notification::pop_async(async_request& request) {
+    // 每取出一个请求后都从最高优先级重新检查
+    for (auto queue = async_queues_.rbegin(); queue != async_queues_.rend(); ++queue) {
+        if ((*queue)->try_pop(request)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void notification::dispatch_loop() {
+    // 分发线程拥有独立的套间，WinRT对象在该线程上创建和使用
+    const bool has_apartment = util::enter_apartment();
+    async_request request;
+    for (;;) {
+        const std::uint32_t observed = async_signal_.load(std::memory_order_acquire);
+        while (pop_async(request)) {
+            async_space_.fetch_add(1, std::memory_order_release);
+            if (blocked_producers_.load(std::memory_order_acquire) != 0) {
+                async_space_.notify_all();
+            }
+            notification_error error = notification_error::no_error;
+            std::int64_t id = -1;
+            try {
+                id = show_impl(*request.notification, std::move(request.handler), &error);
+            } catch (const internals::platform_error&) {
+                error = notification_error::unknown_error;
+            }
+            complete_async(request, { id, error });
+        }
+        if (async_stopping_.load(std::memory_order_acquire)) {
+            break;
+        }
+        async_signal_.wait(observed, std::memory_order_acquire);
+    }
+    if (has_apartment) {
+        util::leave_apartment();
+    }
+}
+
+notification_error notification::register_handler(const notification_template& notification,
+                                                  internals::inline_handler& handler, std::int64_t& id, std::int64_t* replaced) {
+    constexpr std::size_t max_tag_length = 64;
+    util::phase_timer timing(*this, utility::pipeline_phase::validate);
+    if (notification.tag().size() > max_tag_length || notification.group().size() > max_tag_length) {
+        return notification_error::invalid_parameters;
+    }
+    const bool indexed = !notification.tag().empty() || !notification.group().empty();
+    if (notification.id() < -1) {
+        return notification_error::invalid_parameters;
+    }
+    timing.next(utility::pipeline_phase::registry_insert);
+    if (notification.id() != -1) {
+        id = notification.id();
+        if (!notifys.emplace(id, std::move(handler), notification.bindings(), indexed)) {
+            return notification_error::duplicate_id;
+        }
+    } else {
+        // 调用者指定的ID可能恰好占用了生成的ID，此时继续生成下一个
+        do {
+            id = id_generator_.next();
+        } while (!notifys.emplace(id, std::move(handler), notification.bindings(), indexed));
+    }
+    if (replaced) {
+        // 在显示之前登记，保证随后到达的事件能够撤销登记；被替换的旧通知在显示成功后才结束
+        *replaced = index_toast(id, notification.tag(), notification.group());
+    }
+    return notification_error::no_error;
+}
+
+void notification::attach_handle(const std::int64_t id, std::unique_ptr<notification_backend::toast_handle> handle) {
+    // 若事件已在此之前移除了条目，handle在此处析构并注销事件
+    notifys.visit(id, [&](notify& entry) { entry.handle = std::move(handle); });
+}
+
+void notification::on_activated(std::int64_t id, const activation& args) {
+    if (!defers_events()) {
+        dispatch_activated(id, args);
+        return;
+    }
+    // 激活参数与输入框内容仅在回调期间有效，复制到同一个缓冲区中
+    pending_event event;
+    event.id = id;
+    event.type = pending_event::kind::activated;
+    const std::size_t count = (std::min)(args.inputs.size(), notification_template::max_inputs);
+    std::size_t total = args.arguments.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        total += args.inputs[i].id.size() + args.inputs[i].value.size();
+    }
+    event.text.reserve(total);
+    const auto append = [&event](const std::size_t slot, const std::wstring_view text) {
+        event.lengths[slot] = static_cast<std::uint32_t>(text.size());
+        event.text.append(text);
+    };
+    append(0, args.arguments);
+    for (std::size_t i = 0; i < count; ++i) {
+        append(1 + 2 * i, args.inputs[i].id);
+        append(2 + 2 * i, args.inputs[i].value);
+    }
+    event.inputs_count = static_cast<std::uint8_t>(count);
+    post_event(std::move(event));
+}
+
+void notification::on_dismissed(std::int64_t id, notification_handler::dismissal_reason reason) {
+    if (!defers_events()) {
+        dispatch_dismissed(id, reason);
+        return;
+    }
+    pending_event event;
+    event.id = id;
+    event.type = pending_event::kind::dismissed;
+    event.reason = reason;
+    post_event(std::move(event));
+}
+
+void notification::on_failed(std::int64_t id) {
+    if (!defers_events()) {
+        dispatch_failed(id);
+        return;
+    }
+    pending_event event;
+    event.id = id;
+    event.type = pending_event::kind::failed;
+    post_event(std::move(event));
+}
+
+void notification::dispatch_activated(std::int64_t id, const activation& args) {
+    // 驱逐、过期回收与平台事件可能先后到达同一个通知，只回报第一个
+    bool first = false;
+    notifys.visit(id, [&](notify& entry) {
+        first = !entry.retired.exchange(true, std::memory_order_acq_rel);
+        if (first) {
+            count_event(args);
+            entry.handler.activated(args);
+        }
+    });
+    if (first) {
+        mark_as_ready_for_deletion(id);
+    }
+}
+
+void notification::dispatch_dismissed(std::int64_t id, notification_handler::dismissal_reason reason) {
+    bool first = false;
+    notifys.visit(id, [&](notify& entry) {
+        first = !entry.retired.exchange(true, std::memory_order_acq_rel);
+        if (first) {
+            count_event(notification_event::event_type::dismissed);
+            entry.handler.dismissed(reason);
+        }
+    });
+    if (first) {
+        mark_as_ready_for_deletion(id);
+    }
+}
+
+void notification::dispatch_failed(std::int64_t id) {
+    bool first = false;
+    notifys.visit(id, [&](notify& entry) {
+        first = !entry.retired.exchange(true, std::memory_order_acq_rel);
+        if (first) {
+            count_event(notification_event::event_type::failed);
+            entry.handler.failed();
+        }
+    });
+    if (first) {
+        mark_as_ready_for_deletion(id);
+    }
+}
+
+namespace util {
+    // 当前线程正在投递的事件通道，用于识别处理器内部触发的事件
+    thread_local const void* draining_channel = nullptr;
+}
+
+void notification::set_event_delivery(const event_delivery delivery, event_submit_function submit) {
+    if (delivery == event_delivery::submit && !submit) {
+        throw std::invalid_argument("The event submit function cannot be empty.");
+    }
+    if (is_initialized()) {
+        throw std::logic_error("The event delivery must be set before init().");
+    }
+    stop_event_delivery();
+    events_.reset();
+    event_delivery_ = delivery;
+    if (delivery == event_delivery::inline_thread) {
+        return;
+    }
+    constexpr std::size_t event_queue_capacity = 1024;
+    events_ = std::make_shared<event_channel>(event_queue_capacity);
+    events_->owner = this;
+    events_->submit = std::move(submit);
+    if (delivery == event_delivery::event_thread) {
+        event_thread_ = std::thread(&notification::event_loop, this);
+    }
+}
+
+bool notification::defers_events() const noexcept {
+    // 投递停止之后（notification析构期间）触发的事件直接在当前线程上调用
+    return event_delivery_ != event_delivery::inline_thread && !events_->stopping.load(std::memory_order_acquire);
+}
+
+void notification::post_event(pending_event&& event) {
+    constexpr std::size_t spin_limit = 64;
+    auto& channel = *events_;
+    for (std::size_t attempt = 0; !channel.queue.try_push(std::move(event)); ++attempt) {
+        if (util::draining_channel == &channel || channel.stopping.load(std::memory_order_acquire)) {
+            // 队列已满而当前线程就是消费者（由处理器内部的操作触发），等待只会自锁，因此直接投递
+            deliver_event(event);
+            return;
+        }
+        if (attempt < spin_limit) {
+            std::this_thread::yield();
+            continue;
+        }
+        // 消费者持续落后时不再空转，阻塞到其取出事件或投递停止
+        channel.blocked.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::uint32_t observed = channel.space.load(std::memory_order_seq_cst);
+        if (channel.queue.try_push(std::move(event))) {
+            channel.blocked.fetch_sub(1, std::memory_order_relaxed);
+            break;
+        }
+        if (!channel.stopping.load(std::memory_order_seq_cst)) {
+            channel.space.wait(observed, std::memory_order_acquire);
+        }
+        channel.blocked.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (event_delivery_ == event_delivery::event_thread) {
+        channel.signal.fetch_add(1, std::memory_order_seq_cst);
+        if (channel.sleeping.load(std::memory_order_seq_cst)) {
+            channel.signal.notify_one();
+        }
+    } else if (!channel.scheduled.exchange(true, std::memory_order_seq_cst)) {
+        channel.submit([events = events_] { run_submitted(*events); });
+    }
+}
+
+void notification::deliver_event(const pending_event& event) {
+    switch (event.type) {
+        case pending_event::kind::activated: {
+            std::array<user_input, notification_template::max_inputs> inputs{};
+            const std::wstring_view text = event.text;
+            std::size_t offset = 0;
+            const auto next = [&](const std::size_t slot) {
+                const std::wstring_view field = text.substr(offset, event.lengths[slot]);
+                offset += field.size();
+                return field;
+            };
+            const std::wstring_view arguments = next(0);
+            for (std::size_t i = 0; i < event.inputs_count; ++i) {
+                inputs[i].id = next(1 + 2 * i);
+                inputs[i].value = next(2 + 2 * i);
+            }
+            dispatch_activated(event.id, activation{arguments, {inputs.data(), event.inputs_count}});
+            break;
+        }
+        case pending_event::kind::dismissed:
+            dispatch_dismissed(event.id, event.reason);
+            break;
+        case pending_event::kind::failed:
+            dispatch_failed(event.id);
+            break;
+    }
+}
+
+std::size_t notification::drain_events(event_channel& channel) {
+    std::lock_guard<std::mutex> guard(channel.delivery_lock);
+    const void* const previous = std::exchange(util::draining_channel, &channel);
+    std::size_t delivered = 0;
+    pending_event event;
+    while (channel.queue.try_pop(event)) {
+        if (channel.blocked.load(std::memory_order_relaxed) != 0) {
+            wake_producers(channel);
+        }
+        if (!channel.owner) {
+            continue; // notification已析构，丢弃剩余事件
+        }
+        try {
+            channel.owner->deliver_event(event);
+        } catch (...) {
+            // 与WinRT事件回调一致，处理器抛出的异常不会影响其余事件的投递
+        }
+        ++delivered;
+    }
+    // 上面的检查可能错过刚刚开始阻塞的生产者，队列取空后再确认一次
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (channel.blocked.load(std::memory_order_relaxed) != 0) {
+        wake_producers(channel);
+    }
+    util::draining_channel = previous;
+    return delivered;
+}
+
+void notification::wake_producers(event_channel& channel) {
+    channel.space.fetch_add(1, std::memory_order_seq_cst);
+    channel.space.notify_all();
+}
+
+void notification::run_submitted(event_channel& channel) {
+    for (;;) {
+        drain_events(channel);
+        channel.scheduled.store(false, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // 清除标志之前入队的事件不会再提交新任务，由当前任务继续投递
+        if (channel.queue.size_approx() == 0 || channel.scheduled.exchange(true, std::memory_order_seq_cst)) {
+            return;
+        }
+    }
+}
+
+void notification::event_loop() {
+    const bool has_apartment = util::enter_apartment();
+    auto& channel = *events_;
+    for (;;) {
+        const std::uint32_t observed = channel.signal.load(std::memory_order_acquire);
+        drain_events(channel);
+        if (channel.stopping.load(std::memory_order_acquire)) {
+            break;
+        }
+        // 仅在事件线程即将等待时才需要唤醒，繁忙时入队不产生系统调用
+        channel.sleeping.store(true, std::memory_order_seq_cst);
+        if (channel.signal.load(std::memory_order_seq_cst) == observed) {
+            channel.signal.wait(observed, std::memory_order_acquire);
+        }
+        channel.sleeping.store(false, std::memory_order_relaxed);
+    }
+    if (has_apartment) {
+        util::leave_apartment();
+    }
+}
+
+void notification::stop_event_delivery() {
+    if (!events_) {
+        return;
+    }
+    events_->stopping.store(true, std::memory_order_seq_cst);
+    wake_producers(*events_);
+    if (event_thread_.joinable()) {
+        events_->signal.fetch_add(1, std::memory_order_seq_cst);
+        events_->signal.notify_one();
+        event_thread_.join();
+    }
+    // 投递停止之前已入队的事件在此处投递，处理器在随后的clear()之前仍然有效
+    drain_events(*events_);
+    std::lock_guard<std::mutex> guard(events_->delivery_lock);
+    events_->owner = nullptr;
+}
+
+void notification::mark_as_ready_for_deletion(const std::int64_t id) {
+    bool indexed = false;
+    if (!notifys.visit(id, [&indexed](notify& entry) {
+            entry.retired.store(true, std::memory_order_release);
+            indexed = entry.indexed;
+        })) {
+        return;
+    }
+    untrack_live(id);
+    if (indexed) {
+        group_index_.erase(id);
+    }
+    // 退役队列已满时退化为直接移除
+    if (!retired_.try_push(id)) {
+        notifys.erase_if(id, [](notify& entry) { return entry.retired.load(std::memory_order_acquire); });
+    }
+}
+
+std::size_t notification::drain_retired(const std::size_t limit) {
+    std::size_t drained = 0;
+    std::int64_t id;
+    while (drained < limit && retired_.try_pop(id)) {
+        // 同一ID可能已被hide()移除并重新显示，只移除确实已退役的条目
+        notifys.erase_if(id, [](notify& entry) { return entry.retired.load(std::memory_order_acquire); });
+        ++drained;
+    }
+    return drained;
+}
+
+void notification::set_cleanup_batch_size(const std::size_t batch_size) noexcept {
+    cleanup_batch_size_.store(batch_size, std::memory_order_relaxed);
+}
+
+std::size_t notification::maintenance() {
+    if (admission_.is_enabled() && is_initialized()) {
+        flush_coalesced();
+    }
+    return drain_retired(std::max<std::size_t>(cleanup_batch_size_.load(std::memory_order_relaxed), 1));
+}
+
+void notification::flush_coalesced() {
+    std::vector<utility::admission_controller::summary> summaries;
+    admission_.collect_expired(summaries);
+    for (auto& summary : summaries) {
+        if (summary.replaced_id != -1) {
+            // 最初通知的处理器就此结束，之后的事件由汇总通知的处理器接收
+            dismiss_hidden(summary.replaced_id);
+        }
+        if (show_direct(summary.notification, summary.handler, nullptr) == -1) {
+            admission_.summary_failed();
+            if (summary.handler) {
+                retire_detached(std::move(summary.handler), notification_event::event_type::failed);
+            }
+        }
+    }
+}
+
+void notification::retire_detached(internals::inline_handler handler, const notification_event::event_type type) {
+    // 以生成的ID登记没有对应通知的处理器，结束事件按当前的投递方式送达，之后与其他通知一起回收
+    std::int64_t id;
+    do {
+        id = id_generator_.next();
+    } while (!notifys.emplace(id, std::move(handler)));
+    if (type == notification_event::event_type::failed) {
+        on_failed(id);
+    } else {
+        on_dismissed(id, notification_handler::dismissal_reason::application_hidden);
+    }
+}
+
+void notification::set_admission_policy(const utility::admission_policy& policy) {
+    admission_.set_policy(policy);
+}
+
+void notification::set_admission_clock(utility::admission_controller::clock_function clock) {
+    admission_.set_clock(std::move(clock));
+}
+
+utility::admission_controller::statistics notification::admission_stats() const {
+    return admission_.stats();
+}
+
+std::int64_t notification::schedule_impl(const notification_template& toast, const std::chrono::steady_clock::time_point due,
+                                         internals::inline_handler handler, notification_error* error) {
+    set_error(error, notification_error::no_error);
+    if (!is_initialized()) {
+        set_error(error, notification_error::not_initialized);
+        return -1;
+    }
+    if (!handler) {
+        set_error(error, notification_error::invalid_handler);
+        return -1;
+    }
+    if (startup_failed_.load(std::memory_order_acquire)) {
+        set_error(error, notification_error::shell_link_not_created);
+        return -1;
+    }
+    std::wstring payload;
+    {
+        const util::phase_timer timing(*this, utility::pipeline_phase::render);
+        template_cache_.render(utility::context_bridge(*this), toast, payload);
+    }
+    // 组索引推迟到显示时登记，计划中的通知不能提前替换相同Tag的通知
+    std::int64_t id = -1;
+    if (const auto result = register_handler(toast, handler, id, nullptr); result != notification_error::no_error) {
+        set_error(error, result);
+        return -1;
+    }
+    if (schedule_mode_.load(std::memory_order_relaxed) == schedule_mode::platform) {
+        const notification_backend::toast_request request{id,          payload,      toast.expiration(), toast.bindings(),
+                                                          toast.tag(), toast.group(), toast.priority()};
+        const auto when = std::chrono::system_clock::now() +
+                          std::chrono::duration_cast<std::chrono::system_clock::duration>(due - schedule_now());
+        // 交给平台计划的通知到期时不会经过本进程，只能在计划时占用名额
+        if (!reserve_live(id, toast.priority())) {
+            notifys.erase(id);
+            set_error(error, notification_error::live_limit_reached);
+            return -1;
+        }
+        std::unique_ptr<notification_backend::toast_handle> handle;
+        const HRESULT hr = invoke_backend([&](notification_backend& backend) { return backend.schedule(request, when, handle); });
+        if (SUCCEEDED(hr)) {
+            settle_replaced(index_toast(id, toast.tag(), toast.group()), true, toast.tag(), toast.group());
+            attach_handle(id, std::move(handle));
+            track_live(id, toast.expiration(), due); // 平台计划的通知不回报事件，只能依靠过期回收
+            return id;
+        }
+        untrack_live(id);
+        if (hr != E_NOTIMPL) {
+            notifys.erase(id);
+            set_error(error, notification_error::not_displayed);
+            return -1;
+        }
+    }
+    const std::uint64_t tick = schedule_tick(due, true); // 向上取整，保证不早于到期时间显示
+    bool earlier = false;
+    {
+        std::lock_guard<std::mutex> guard(schedule_lock_);
+        const auto next = next_timer_tick();
+        earlier = !next || tick < *next;
+        const auto timer = schedule_wheel_.insert(tick, id);
+        deferred_toast pending{id,
+                               std::move(payload),
+                               toast.expiration(),
+                               {toast.bindings().begin(), toast.bindings().end()},
+                               std::wstring{toast.tag()},
+                               std::wstring{toast.group()},
+                               toast.priority()};
+        scheduled_.insert_or_assign(id, scheduled_toast{std::move(pending), timer});
+        if (start_timer_thread()) {
+            earlier = false;
+        }
+    }
+    // 只有最早的到期时间提前时才唤醒定时线程
+    if (earlier) {
+        schedule_signal_.notify_one();
+    }
+    return id;
+}
+
+void notification::set_schedule_mode(const schedule_mode mode) noexcept {
+    schedule_mode_.store(mode, std::memory_order_relaxed);
+}
+
+void notification::set_schedule_clock(utility::admission_controller::clock_function clock) {
+    std::lock_guard<std::mutex> guard(schedule_lock_);
+    if (schedule_wheel_.size() != 0 || expiry_wheel_.size() != 0 || scheduler_.joinable()) {
+        return;
+    }
+    schedule_clock_ = std::move(clock);
+    schedule_epoch_ = schedule_clock_ ? schedule_clock_() : std::chrono::steady_clock::now();
+    schedule_wheel_ = utility::timer_wheel{}; // tick以新的时钟重新计数
+    expiry_wheel_ = utility::timer_wheel{};
+}
+
+std::chrono::steady_clock::time_point notification::schedule_now() const {
+    return schedule_clock_ ? schedule_clock_() : std::chrono::steady_clock::now();
+}
+
+std::size_t notification::run_due_schedules() {
+    std::vector<std::int64_t> fired;
+    std::vector<deferred_toast> due;
+    std::vector<std::int64_t> expired;
+    {
+        std::lock_guard<std::mutex> guard(schedule_lock_);
+        const std::uint64_t tick = schedule_tick(schedule_now(), false);
+        schedule_wheel_.advance(tick, fired);
+        due.reserve(fired.size());
+        for (const std::int64_t id : fired) {
+            if (auto node = scheduled_.extract(id)) {
+                due.push_back(std::move(node.mapped().toast));
+            }
+        }
+        expiry_wheel_.advance(tick, expired);
+        for (const std::int64_t id : expired) {
+            if (const auto iter = live_.find(id); iter != live_.end()) {
+                iter->second.timer = utility::timer_wheel::invalid_timer; // 已经触发
+                erase_live(iter);
+            }
+        }
+    }
+    // 显示与回报时不持有锁，处理器可以在回调中继续计划或取消通知
+    for (const auto& toast : due) {
+        submit_scheduled(toast);
+    }
+    for (const std::int64_t id : expired) {
+        expire(id);
+    }
+    if (!expired.empty()) {
+        drain_retired(expired.size()); // 主动回收，不等待下一次show()
+    }
+    return due.size() + expired.size();
+}
+
+void notification::set_default_expiration(const std::chrono::milliseconds expiration) noexcept {
+    default_expiration_.store(expiration.count(), std::memory_order_relaxed);
+}
+
+std::size_t notification::active_count() const noexcept {
+    return notifys.size();
+}
+
+void notification::set_live_limit(const std::size_t limit) noexcept {
+    live_limit_.store(limit, std::memory_order_relaxed);
+}
+
+std::size_t notification::live_count() const {
+    std::lock_guard<std::mutex> guard(schedule_lock_);
+    return live_.size();
+}
+
+std::uint64_t notification::schedule_tick(const std::chrono::steady_clock::time_point time, const bool round_up) const {
+    if (time <= schedule_epoch_) {
+        return 0;
+    }
+    const auto elapsed = time - schedule_epoch_;
+    return static_cast<std::uint64_t>(round_up ? std::chrono::ceil<std::chrono::milliseconds>(elapsed).count()
+                                               : std::chrono::floor<std::chrono::milliseconds>(elapsed).count());
+}
+
+std::optional<std::uint64_t> notification::next_timer_tick() const {
+    const auto scheduled = schedule_wheel_.next_expiry();
+    const auto expiry = expiry_wheel_.next_expiry();
+    if (scheduled && expiry) {
+        return (std::min)(*scheduled, *expiry);
+    }
+    return scheduled ? scheduled : expiry;
+}
+
+bool notification::start_timer_thread() {
+    if (schedule_clock_ || scheduler_.joinable() || schedule_stopping_) {
+        return false;
+    }
+    scheduler_ = std::thread(&notification::schedule_loop, this);
+    return true;
+}
+
+bool notification::reserve_live(const std::int64_t id, const notification_template::priority_t priority, const std::int64_t replacing) {
+    std::vector<std::int64_t> victims;
+    {
+        std::lock_guard<std::mutex> guard(schedule_lock_);
+        if (const auto iter = live_.find(id); iter != live_.end()) {
+            erase_live(iter); // 同一ID被重新显示
+        }
+        const std::size_t limit = live_limit_.load(std::memory_order_relaxed);
+        // 即将被新通知替换的旧通知让出名额，也不作为驱逐对象
+        const std::size_t yielded = replacing != -1 && live_.contains(replacing) ? 1 : 0;
+        // 从最低优先级开始，驱逐不高于新通知优先级的最旧的通知；正在显示的通知不参与驱逐
+        auto level = live_order_.begin();
+        const auto last = live_order_.begin() + static_cast<std::ptrdiff_t>(priority) + 1;
+        auto candidate = level->begin();
+        while (limit != 0 && live_.size() - victims.size() - yielded >= limit) {
+            while (level != last && candidate == level->end()) {
+                if (++level != last) {
+                    candidate = level->begin();
+                }
+            }
+            if (level == last) {
+                return false; // 尚未驱逐任何通知
+            }
+            if (*candidate != replacing && live_.find(*candidate)->second.shown) {
+                victims.push_back(*candidate);
+            }
+            ++candidate;
+        }
+        for (const std::int64_t victim : victims) {
+            erase_live(live_.find(victim));
+        }
+        auto& order = live_order_[static_cast<std::size_t>(priority)];
+        order.push_back(id);
+        live_.emplace(id, live_toast{utility::timer_wheel::invalid_timer, priority, false, std::prev(order.end())});
+    }
+    for (const std::int64_t victim : victims) {
+        evict(victim);
+    }
+    return true;
+}
+
+void notification::track_live(const std::int64_t id, const std::int64_t expiration, const std::chrono::steady_clock::time_point shown) {
+    const std::int64_t lifetime = expiration > 0 ? expiration : default_expiration_.load(std::memory_order_relaxed);
+    const std::uint64_t tick = lifetime > 0 ? schedule_tick(shown + std::chrono::milliseconds(lifetime), true) : 0;
+    bool earlier = false;
+    {
+        std::lock_guard<std::mutex> guard(schedule_lock_);
+        const auto iter = live_.find(id);
+        if (iter == live_.end()) {
+            return; // 显示期间已被移除
+        }
+        iter->second.shown = true;
+        if (lifetime <= 0) {
+            return;
+        }
+        const auto next = next_timer_tick();
+        earlier = !next || tick < *next;
+        iter->second.timer = expiry_wheel_.insert(tick, id);
+        if (start_timer_thread()) {
+            earlier = false;
+        }
+    }
+    if (earlier) {
+        schedule_signal_.notify_one();
+    }
+}
+
+void notification::untrack_live(const std::int64_t id) {
+    std::lock_guard<std::mutex> guard(schedule_lock_);
+    if (const auto iter = live_.find(id); iter != live_.end()) {
+        erase_live(iter);
+    }
+}
+
+void notification::erase_live(const std::unordered_map<std::int64_t, live_toast>::iterator iter) {
+    expiry_wheel_.cancel(iter->second.timer);
+    live_order_[static_cast<std::size_t>(iter->second.priority)].erase(iter->second.order);
+    live_.erase(iter);
+}
+
+void notification::expire(const std::int64_t id) {
+    bool live = false;
+    notifys.visit(id, [&live](notify& entry) { live = !entry.retired.load(std::memory_order_acquire); });
+    if (live) {
+#if RAINY_NOTIFICATION_METRICS
+        metrics_->count(utility::pipeline_metrics::counter::expired);
+#endif
+        // 平台在过期时静默移除通知，不会回报事件
+        on_dismissed(id, notification_handler::dismissal_reason::timed_out);
+    }
+}
+
+void notification::evict(const std::int64_t id) {
+#if RAINY_NOTIFICATION_METRICS
+    metrics_->count(utility::pipeline_metrics::counter::evicted);
+#endif
+    dismiss_hidden(id);
+}
+
+void notification::dismiss_hidden(const std::int64_t id) {
+    notifys.visit(id, [&](notify& entry) {
+        if (entry.handle) {
+            invoke_backend([&](notification_backend& backend) { return backend.hide(*entry.handle); });
+        }
+    });
+    // 平台随后回报的ApplicationHidden事件会被忽略，处理器只收到一次
+    on_dismissed(id, notification_handler::dismissal_reason::application_hidden);
+}
+
+void notification::on_phase(const utility::pipeline_phase phase, const std::chrono::nanoseconds elapsed) {
+#if RAINY_NOTIFICATION_METRICS
+    metrics_->record(phase, elapsed);
+#else
+    (void) phase;
+    (void) elapsed;
+#endif
+}
+
+void notification::count_show(const HRESULT hr) noexcept {
+#if RAINY_NOTIFICATION_METRICS
+    metrics_->count(SUCCEEDED(hr) ? utility::pipeline_metrics::counter::shown : utility::pipeline_metrics::counter::show_failures);
+#else
+    (void) hr;
+#endif
+}
+
+void notification::count_event(const notification_event::event_type type) noexcept {
+#if RAINY_NOTIFICATION_METRICS
+    metrics_->count(type);
+#else
+    (void) type;
+#endif
+}
+
+void notification::count_event(const activation& args) noexcept {
+#if RAINY_NOTIFICATION_METRICS
+    // 与callable_handler相同的分类方式
+    std::optional<int> action_index;
+    std::optional<std::wstring_view> reply;
+    args.resolve(action_index, reply);
+    metrics_->count(reply          ? notification_event::event_type::activated_with_reply
+                    : action_index ? notification_event::event_type::activated_with_action_idx
+                                   : notification_event::event_type::activated);
+#else
+    (void) args;
+#endif
+}
+
+utility::metrics_snapshot notification::metrics() const {
+    utility::metrics_snapshot snapshot;
+#if RAINY_NOTIFICATION_METRICS
+    snapshot.enabled = true;
+    metrics_->fill(snapshot);
+#endif
+    snapshot.registered = notifys.size();
+    snapshot.retired_backlog = retired_.size_approx();
+    if (const auto events = events_) {
+        snapshot.pending_events = events->queue.size_approx();
+    }
+    {
+        std::lock_guard<std::mutex> guard(schedule_lock_);
+        snapshot.live = live_.size();
+        snapshot.scheduled = scheduled_.size();
+    }
+    // 队列在启动后不再替换或释放，读取深度无需持有async_lock_
+    if (async_started_.load(std::memory_order_acquire)) {
+        for (std::size_t level = 0; level < async_queues_.size(); ++level) {
+            snapshot.async_depth[level] = async_queues_[level]->size_approx();
+        }
+    }
+    return snapshot;
+}
+
+std::size_t notification::scheduled_count() const {
+    std::lock_guard<std::mutex> guard(schedule_lock_);
+    return scheduled_.size();
+}
+
+bool notification::cancel_scheduled(const std::int64_t id) {
+    std::lock_guard<std::mutex> guard(schedule_lock_);
+    const auto iter = scheduled_.find(id);
+    if (iter == scheduled_.end()) {
+        return false;
+    }
+    schedule_wheel_.cancel(iter->second.timer);
+    scheduled_.erase(iter);
+    return true;
+}
+
+std::int64_t notification::index_toast(const std::int64_t id, std::wstring_view tag, std::wstring_view group) {
+    if (tag.empty() && group.empty()) {
+        return -1;
+    }
+    return group_index_.insert(id, tag, group);
+}
+
+void notification::settle_replaced(const std::int64_t replaced, const bool shown, std::wstring_view tag, std::wstring_view group) {
+    if (replaced == -1) {
+        return;
+    }
+    if (shown) {
+        // 平台已以新通知替换旧通知，旧通知不会再有事件，与驱逐一样以application_hidden结束
+        untrack_live(replaced);
+        on_dismissed(replaced, notification_handler::dismissal_reason::application_hidden);
+        return;
+    }
+    // 新通知未能显示，旧通知仍在屏幕上，恢复其登记
+    bool live = false;
+    notifys.visit(replaced, [&live](notify& entry) { live = !entry.retired.load(std::memory_order_acquire); });
+    if (live) {
+        group_index_.insert(replaced, tag, group);
+    }
+}
+
+void notification::submit_scheduled(const deferred_toast& toast) {
+    if (!notifys.visit(toast.id, [](notify&) {})) {
+        return; // 到期前已被hide
+    }
+    const std::int64_t replaced = index_toast(toast.id, toast.tag, toast.group);
+    const notification_backend::toast_request request{toast.id,  toast.xml,   toast.expiration, toast.data,
+                                                      toast.tag, toast.group, toast.priority};
+    if (defer_show(request, replaced)) {
+        return;
+    }
+    submit_deferred(toast, !startup_failed_.load(std::memory_order_acquire), replaced);
+}
+
+void notification::stop_scheduler() {
+    {
+        std::lock_guard<std::mutex> guard(schedule_lock_);
+        schedule_stopping_ = true;
+    }
+    schedule_signal_.notify_all();
+    if (scheduler_.joinable()) {
+        scheduler_.join();
+    }
+}
+
+void notification::schedule_loop() {
+    // 与分发线程相同，定时线程拥有独立的套间
+    const bool has_apartment = util::enter_apartment();
+    std::unique_lock<std::mutex> guard(schedule_lock_);
+    while (!schedule_stopping_) {
+        const auto next = next_timer_tick();
+        if (!next) {
+            schedule_signal_.wait(guard);
+            continue;
+        }
+        const auto wake = schedule_epoch_ + std::chrono::milliseconds(static_cast<std::int64_t>(*next));
+        if (std::chrono::steady_clock::now() < wake) {
+            schedule_signal_.wait_until(guard, wake);
+            continue;
+        }
+        guard.unlock();
+        run_due_schedules();
+        guard.lock();
+    }
+    guard.unlock();
+    if (has_apartment) {
+        util::leave_apartment();
+    }
+}
+
+bool notification::hide(const std::int64_t id) {
+    if (!is_initialized()) {
+        throw std::runtime_error("Error when hiding the toast. notification is not initialized.");
+    }
+    HRESULT hr = E_FAIL;
+    bool indexed = false;
+    const bool cancelled = cancel_scheduled(id);
+    const bool found = notifys.visit(id, [&](notify& entry) {
+        if (entry.handle) {
+            hr = invoke_backend([&](notification_backend& backend) { return backend.hide(*entry.handle); });
+        } else if (cancelled || startup_pending_.load(std::memory_order_acquire)) {
+            hr = S_OK; // 尚未到期或仍在排队，移出注册表后不会再显示
+        }
+        indexed = entry.indexed;
+    });
+    if (!found) {
+        return false;
+    }
+    notifys.erase(id);
+    untrack_live(id);
+    if (indexed) {
+        group_index_.erase(id);
+    }
+    return SUCCEEDED(hr);
+}
+
+bool notification::hide_group(std::wstring_view group) {
+    if (!is_initialized()) {
+        throw std::runtime_error("Error when hiding the toasts. notification is not initialized.");
+    }
+    if (group.empty()) {
+        return false;
+    }
+    const std::vector<std::int64_t> ids = group_index_.take_group(group);
+    HRESULT hr = invoke_backend([&](notification_backend& backend) { return backend.remove_group(group); });
+    if (hr == E_NOTIMPL) {
+        // 后端不支持按组移除时，退化为逐个隐藏已登记的通知
+        hr = S_OK;
+        for (const std::int64_t id: ids) {
+            notifys.visit(id, [&](notify& entry) {
+                if (entry.handle) {
+                    if (const HRESULT result = invoke_backend([&](notification_backend& backend) { return backend.hide(*entry.handle); });
+                        FAILED(result)) {
+                        hr = result;
+                    }
+                }
+            });
+        }
+    }
+    for (const std::int64_t id: ids) {
+        notifys.erase(id);
+        untrack_live(id);
+    }
+    return SUCCEEDED(hr);
+}
+
+bool notification::hide_tag(std::wstring_view tag, std::wstring_view group) {
+    if (!is_initialized()) {
+        throw std::runtime_error("Error when hiding the toast. notification is not initialized.");
+    }
+    if (tag.empty()) {
+        return false;
+    }
+    const std::int64_t id = group_index_.take_tag(tag, group);
+    HRESULT hr = invoke_backend([&](notification_backend& backend) { return backend.remove_tag(tag, group); });
+    if (hr == E_NOTIMPL) {
+        hr = E_FAIL;
+        notifys.visit(id, [&](notify& entry) {
+            if (entry.handle) {
+                hr = invoke_backend([&](notification_backend& backend) { return backend.hide(*entry.handle); });
+            }
+        });
+    }
+    if (id != -1) {
+        notifys.erase(id);
+        untrack_live(id);
+    }
+    return SUCCEEDED(hr);
+}
+
+bool notification::update(const std::int64_t id, std::span<const notification_template::data_binding> values, notification_error* error) {
+    set_error(error, notification_error::no_error);
+    if (!is_initialized()) {
+        set_error(error, notification_error::not_initialized);
+        return false;
+    }
+    notification_error result = notification_error::not_displayed;
+    const bool found = notifys.visit(id, [&](notify& entry) {
+        std::lock_guard<std::mutex> guard(entry.data_lock);
+        std::vector<notification_template::data_binding> changed;
+        if (entry.data.empty() || !utility::diff_bindings(entry.data, values, changed)) {
+            result = notification_error::invalid_parameters;
+            return;
+        }
+        if (changed.empty()) {
+            result = notification_error::no_error;
+            return;
+        }
+        if (!entry.handle) {
+            return; // 仍在显示过程中
+        }
+        const std::uint32_t sequence = entry.sequence + 1;
+        const HRESULT hr =
+            invoke_backend([&](notification_backend& backend) { return backend.update(*entry.handle, changed, sequence); });
+        if (SUCCEEDED(hr)) {
+            entry.sequence = sequence;
+            utility::apply_bindings(entry.data, changed);
+            result = notification_error::no_error;
+        }
+    });
+    if (!found) {
+        set_error(error, notification_error::not_displayed);
+        return false;
+    }
+    set_error(error, result);
+    return result == notification_error::no_error;
+}
+
+bool utility::diff_bindings(std::span<const notification_template::data_binding> current,
+                            std::span<const notification_template::data_binding> values,
+                            std::vector<notification_template::data_binding>& changed) {
+    changed.clear();
+    for (const auto& value: values) {
+        const auto iter = std::find_if(current.begin(), current.end(), [&](const auto& binding) { return binding.key == value.key; });
+        if (iter == current.end()) {
+            changed.clear();
+            return false;
+        }
+        // 同一个键出现多次时以最后一次为准
+        const auto pending =
+            std::find_if(changed.begin(), changed.end(), [&](const auto& binding) { return binding.key == value.key; });
+        if (pending != changed.end()) {
+            if (iter->value == value.value) {
+                changed.erase(pending);
+            } else {
+                pending->value = value.value;
+            }
+        } else if (iter->value != value.value) {
+            changed.push_back(value);
+        }
+    }
+    return true;
+}
+
+void utility::apply_bindings(std::span<notification_template::data_binding> current,
+                             std::span<const notification_template::data_binding> changed) {
+    for (const auto& value: changed) {
+        for (auto& binding: current) {
+            if (binding.key == value.key) {
+                binding.value = value.value; // 容量足够时不会分配
+                break;
+            }
+        }
+    }
+}
+
+void utility::toast_group_index::make_tag_key(std::wstring_view tag, std::wstring_view group) {
+    // Group以长度作为前缀，避免不同的Tag与Group拼接出相同的键
+    key_buffer_.clear();
+    key_buffer_.push_back(static_cast<wchar_t>(group.size()));
+    key_buffer_.append(group);
+    key_buffer_.append(tag);
+}
+
+void utility::toast_group_index::unlink(const std::int64_t id, const entry& value) {
+    if (!value.group.empty()) {
+        if (const auto iter = groups_.find(value.group); iter != groups_.end()) {
+            iter->second.erase(id);
+            if (iter->second.empty()) {
+                groups_.erase(iter);
+            }
+        }
+    }
+    if (!value.tag.empty()) {
+        make_tag_key(value.tag, value.group);
+        if (const auto iter = tags_.find(key_buffer_); iter != tags_.end() && iter->second == id) {
+            tags_.erase(iter);
+        }
+    }
+}
+
+std::int64_t utility::toast_group_index::insert(const std::int64_t id, std::wstring_view tag, std::wstring_view group) {
+    std::lock_guard<std::mutex> guard(lock_);
+    std::int64_t replaced = -1;
+    if (!tag.empty()) {
+        make_tag_key(tag, group);
+        const auto [iter, inserted] = tags_.try_emplace(key_buffer_, id);
+        if (!inserted) {
+            replaced = iter->second;
+            iter->second = id;
+            if (const auto old = entries_.find(replaced); old != entries_.end()) {
+                unlink(replaced, old->second); // Tag已指向新通知，此处只会将旧通知移出所属的组
+                entries_.erase(old);
+            }
+        }
+    }
+    if (!group.empty()) {
+        if (const auto iter = groups_.find(group); iter != groups_.end()) {
+            iter->second.insert(id);
+        } else {
+            groups_.emplace(std::wstring{group}, std::unordered_set<std::int64_t>{id});
+        }
+    }
+    entries_.insert_or_assign(id, entry{std::wstring{tag}, std::wstring{group}});
+    return replaced;
+}
+
+void utility::toast_group_index::erase(const std::int64_t id) {
+    std::lock_guard<std::mutex> guard(lock_);
+    const auto iter = entries_.find(id);
+    if (iter == entries_.end()) {
+        return;
+    }
+    unlink(id, iter->second);
+    entries_.erase(iter);
+}
+
+std::vector<std::int64_t> utility::toast_group_index::take_group(std::wstring_view group) {
+    std::lock_guard<std::mutex> guard(lock_);
+    const auto iter = groups_.find(group);
+    if (iter == groups_.end()) {
+        return {};
+    }
+    std::vector<std::int64_t> ids(iter->second.begin(), iter->second.end());
+    groups_.erase(iter);
+    for (const std::int64_t id: ids) {
+        if (const auto found = entries_.find(id); found != entries_.end()) {
+            unlink(id, found->second); // 所属的组已被移除，此处只会移除Tag
+            entries_.erase(found);
+        }
+    }
+    return ids;
+}
+
+std::int64_t utility::toast_group_index::take_tag(std::wstring_view tag, std::wstring_view group) {
+    std::lock_guard<std::mutex> guard(lock_);
+    make_tag_key(tag, group);
+    const auto iter = tags_.find(key_buffer_);
+    if (iter == tags_.end()) {
+        return -1;
+    }
+    const std::int64_t id = iter->second;
+    if (const auto found = entries_.find(id); found != entries_.end()) {
+        unlink(id, found->second);
+        entries_.erase(found);
+    }
+    return id;
+}
+
+void utility::toast_group_index::clear() {
+    std::lock_guard<std::mutex> guard(lock_);
+    entries_.clear();
+    groups_.clear();
+    tags_.clear();
+}
+
+std::size_t utility::toast_group_index::size() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return entries_.size();
+}
+
+void rainy::notification::set_modern_status(const bool enable) noexcept {
+    status[static_cast<int>(notification_status::enable_modern_features)] = enable;
+}
+
+bool rainy::notification::is_enable_modern_features() const noexcept {
+    return status[static_cast<int>(notification_status::enable_modern_features)];
+}
+
+void notification::set_template_cache_capacity(std::size_t capacity) {
+    template_cache_.set_capacity(capacity);
+}
+
+utility::template_cache::statistics notification::template_cache_stats() const {
+    return template_cache_.stats();
+}
+
+void notification::clear() {
+    {
+        std::lock_guard<std::mutex> guard(schedule_lock_);
+        schedule_wheel_.clear();
+        scheduled_.clear();
+        expiry_wheel_.clear();
+        live_.clear();
+        for (auto& order : live_order_) {
+            order.clear();
+        }
+    }
+    notifys.for_each([&](const std::int64_t id, notify& entry) {
+        if (entry.handle) {
+            invoke_backend([&](notification_backend& backend) { return backend.hide(*entry.handle); });
+        }
+        notifys.erase(id);
+    });
+    group_index_.clear();
+}
+
+#ifdef _WIN32
+HRESULT utility::xml_notifcation_field::set_attribution_text_field( std::wstring_view text) {
+    util::create_element(xml, L"binding", L"text", { L"placement" });
+    try {
+        auto node_list = xml.GetElementsByTagName(L"text"); // 获取 text 节点列表
+        for (uint32_t i = 0; i < node_list.Size(); ++i) {
+            auto text_node = node_list.GetAt(i);
+            auto attributes = text_node.Attributes();
+            // 获取 "placement" 属性
+            auto edited_node = attributes.GetNamedItem(L"placement");
+            if (edited_node) {
+                // 设置 attribution 字段
+                util::set_node_string_value(L"attribution", &edited_node, xml);
+                // 设置文本字段
+                return set_text_field(text, i);
+            }
+        }
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
     }
 }
 
 HRESULT utility::xml_notifcation_field::add_duration( std::wstring_view duration) {
     try {
-        // 获取 toast 节点列表
-        auto node_list = xml.GetElementsByTagName(L"toast");
-        if (node_list.Size() > 0) {
-            auto toast_node = node_list.GetAt(0);
-            auto toast_element = toast_node.as<winrt::Windows::Data::Xml::Dom::XmlElement>();
-            // 设置 duration 属性
-            toast_element.SetAttribute(L"duration", duration);
+        // 获取 toast 节点列表
+        auto node_list = xml.GetElementsByTagName(L"toast");
+        if (node_list.Size() > 0) {
+            auto toast_node = node_list.GetAt(0);
+            auto toast_element = toast_node.as<winrt::Windows::Data::Xml::Dom::XmlElement>();
+            // 设置 duration 属性
+            toast_element.SetAttribute(L"duration", duration);
+        }
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT utility::xml_notifcation_field::add_scenario( std::wstring_view scenario) {
+    try {
+        // 获取 toast 节点列表
+        auto node_list = xml.GetElementsByTagName(L"toast");
+        if (node_list.Size() > 0) {
+            auto toast_node = node_list.GetAt(0);
+            auto toast_element = toast_node.as<winrt::Windows::Data::Xml::Dom::XmlElement>();
+
+            // 设置 scenario 属性
+            toast_element.SetAttribute(L"scenario", scenario);
+        }
+
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT utility::xml_notifcation_field::add_input() {
+    try {
+        // 定义属性列表
+        std::vector<std::wstring> attrbs = { L"id", L"type", L"placeHolderContent" };
+        std::vector<std::wstring> attrbs2 = { L"content", L"arguments" };
+        // 创建元素
+        util::create_element(xml, L"toast", L"actions", {});
+        util::create_element(xml, L"actions", L"input", attrbs);
+        util::create_element(xml, L"actions", L"action", attrbs2);
+        // 获取 "input" 节点列表
+        auto node_list = xml.GetElementsByTagName(L"input");
+        if (node_list.Size() > 0) {
+            // 获取指定位置的节点
+            auto input_node = node_list.GetAt(0);
+            auto toast_element = input_node.as<winrt::Windows::Data::Xml::Dom::XmlElement>();
+            // 设置属性
+            toast_element.SetAttribute(L"id", L"textBox");
+            toast_element.SetAttribute(L"type", L"text");
+            toast_element.SetAttribute(L"placeHolderContent", L"...");
+        }
+        // 获取 "action" 节点列表
+        auto node_list2 = xml.GetElementsByTagName(L"action");
+        if (node_list2.Size() > 0) {
+            // 获取指定位置的节点
+            auto action_node = node_list2.GetAt(0);
+            auto action_element = action_node.as<winrt::Windows::Data::Xml::Dom::XmlElement>();
+            // 设置属性
+            action_element.SetAttribute(L"content", L"Reply");
+            action_element.SetAttribute(L"arguments", L"action=reply");
+            action_element.SetAttribute(L"hint-inputId", L"textBox");
+        }
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT utility::xml_notifcation_field::set_text_field( std::wstring_view text, std::uint32_t pos) {
+    try {
+        // 获取 "text" 节点列表
+        auto node_list = xml.GetElementsByTagName(L"text");
+        if (node_list.Size() > pos) {
+            // 获取指定位置的节点
+            auto node = node_list.GetAt(pos);
+            return util::set_node_string_value(text, &node, xml); // 设置节点的字符串值
+        }
+        return E_FAIL;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT utility::xml_notifcation_field::set_bind_toast_generic() {
+    try {
+        // 获取 "binding" 节点列表
+        auto nodeList = xml.GetElementsByTagName(L"binding");
+        if (nodeList.Size() > 0) {
+            // 获取第一个节点
+            auto toastNode = nodeList.GetAt(0);
+            // 获取节点并设置模板属性
+            if (auto toastElement = toastNode.as<winrt::Windows::Data::Xml::Dom::XmlElement>()) {
+                toastElement.SetAttribute(L"template", L"ToastGeneric");
+            }
+            return S_OK;
+        }
+        return E_FAIL;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+namespace util {
+    /* 进程级的随机盐，由进程ID、启动时间与随机设备混合而成 */
+    std::uint64_t process_tag_salt() noexcept {
+        static const std::uint64_t salt = [] {
+            std::uint64_t value = static_cast<std::uint64_t>(GetCurrentProcessId()) << 32 ^
+                                  static_cast<std::uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+            try {
+                value ^= static_cast<std::uint64_t>(std::random_device{}()) << 16;
+            } catch (const std::exception&) {
+                // 没有可用的随机设备时只使用进程ID与启动时间
+            }
+            value += 0x9E3779B97F4A7C15ull;
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        }();
+        return salt;
+    }
+
+    /*
+     * 以通知ID生成Tag，不超过旧版系统16个字符的限制。不同进程的ID生成器相互独立，同一AUMI下的多个会话会生成相同的ID，
+     * 因此在非负ID的63位之外再混入17位进程盐，共80位，以16个不区分大小写的32进制字符表示
+     */
+    std::wstring binding_tag(const std::int64_t id) {
+        constexpr wchar_t digits[] = L"0123456789abcdefghijklmnopqrstuv";
+        const std::uint64_t salt = process_tag_salt();
+        const std::uint64_t low = static_cast<std::uint64_t>(id) | salt << 63;
+        std::uint64_t high = low >> 60 | (salt >> 1 & 0xFFFF) << 4; // 最高的20位
+        std::uint64_t value = low & ((std::uint64_t{1} << 60) - 1);
+        std::wstring tag(16, L'0');
+        for (std::size_t i = tag.size(); i-- > 4; value >>= 5) {
+            tag[i] = digits[value & 0x1F];
+        }
+        for (std::size_t i = 4; i-- > 0; high >>= 5) {
+            tag[i] = digits[high & 0x1F];
+        }
+        return tag;
+    }
+
+    struct winrt_toast_handle final : notification_backend::toast_handle {
+        explicit winrt_toast_handle(winrt::Windows::UI::Notifications::ToastNotification toast) : toast(std::move(toast)) {
+        }
+
+        explicit winrt_toast_handle(winrt::Windows::UI::Notifications::ScheduledToastNotification scheduled) :
+            toast(nullptr), scheduled(std::move(scheduled)) {
+        }
+
+        ~winrt_toast_handle() override {
+            if (!toast) {
+                return; // 计划通知没有注册事件
+            }
+            try {
+                toast.Activated(activated_token);
+                toast.Dismissed(dismissed_token);
+                toast.Failed(failed_token);
+            } catch (const winrt::hresult_error&) {
+            }
+        }
+
+        winrt::Windows::UI::Notifications::ToastNotification toast;
+        winrt::Windows::UI::Notifications::ScheduledToastNotification scheduled{nullptr};
+        winrt::event_token activated_token{};
+        winrt::event_token dismissed_token{};
+        winrt::event_token failed_token{};
+    };
+}
+
+HRESULT winrt_notification_backend::create_notifier(std::wstring_view aumi) {
+    try {
+        auto notifier = winrt::Windows::UI::Notifications::ToastNotificationManager::CreateToastNotifier(winrt::hstring{ aumi });
+        std::lock_guard<std::mutex> guard(lock_);
+        notifier_ = std::move(notifier);
+        aumi_ = aumi;
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+platform_capabilities winrt_notification_backend::query_capabilities() {
+    return util::os_capabilities();
+}
+
+void winrt_notification_backend::release_notifier() noexcept {
+    std::lock_guard<std::mutex> guard(lock_);
+    notifier_ = nullptr;
+}
+
+winrt::Windows::UI::Notifications::ToastNotifier winrt_notification_backend::notifier() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return notifier_;
+}
+
+HRESULT winrt_notification_backend::show_with(const winrt::Windows::UI::Notifications::ToastNotifier& notifier,
+                                              const toast_request& request, event_sink& sink, std::unique_ptr<toast_handle>& handle) {
+    using namespace winrt::Windows::UI::Notifications;
+    try {
+        if (!notifier) {
+            return E_UNEXPECTED;
+        }
+        utility::xml_notifcation_field xml(request.xml);
+        auto toast = std::make_unique<util::winrt_toast_handle>(ToastNotification(xml));
+        if (!request.data.empty()) {
+            NotificationData data;
+            for (const auto &binding: request.data) {
+                data.Values().Insert(winrt::hstring{binding.key}, winrt::hstring{binding.value});
+            }
+            data.SequenceNumber(1);
+            toast->toast.Data(data);
+        }
+        // 数据绑定与按组移除都只能通过Tag定位到已显示的通知，调用者未指定时以通知ID生成
+        if (!request.tag.empty()) {
+            toast->toast.Tag(winrt::hstring{request.tag});
+        } else if (!request.data.empty() || !request.group.empty()) {
+            toast->toast.Tag(winrt::hstring{util::binding_tag(request.id)});
+        }
+        if (!request.group.empty()) {
+            toast->toast.Group(winrt::hstring{request.group});
+        }
+        if (request.priority == notification_template::priority_t::high) {
+            try {
+                toast->toast.Priority(ToastNotificationPriority::High);
+            } catch (const winrt::hresult_error&) {
+                // 15063之前的系统不支持优先级，按普通优先级显示
+            }
+        }
+        winrt::Windows::Foundation::DateTime expiration_time{};
+        if (request.expiration > 0) {
+            expiration_time = winrt::clock::now() + std::chrono::milliseconds(request.expiration); // 将相对过期时间转换为时间点
+            toast->toast.ExpirationTime(expiration_time);
+        }
+        util::phase_timer timing(sink, utility::pipeline_phase::register_events);
+        winrt::check_hresult(util::set_event_handlers(toast->toast, sink, request.id, expiration_time, toast->activated_token,
+                                                      toast->dismissed_token, toast->failed_token));
+        timing.stop();
+        notifier.Show(toast->toast);
+        handle = std::move(toast);
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT winrt_notification_backend::show(const toast_request& request, event_sink& sink, std::unique_ptr<toast_handle>& handle) {
+    util::phase_timer timing(sink, utility::pipeline_phase::acquire_notifier);
+    auto const notifier = this->notifier();
+    timing.stop();
+    return show_with(notifier, request, sink, handle);
+}
+
+void winrt_notification_backend::show_batch(std::span<const toast_request> requests, event_sink& sink,
+                                            std::span<std::unique_ptr<toast_handle>> handles, std::span<HRESULT> results) {
+    util::phase_timer timing(sink, utility::pipeline_phase::acquire_notifier);
+    auto const notifier = this->notifier(); // 整批只获取一次通知器
+    timing.stop();
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        results[i] = show_with(notifier, requests[i], sink, handles[i]);
+    }
+}
+
+HRESULT winrt_notification_backend::update(toast_handle& handle, std::span<const notification_template::data_binding> values,
+                                           std::uint32_t sequence) {
+    using namespace winrt::Windows::UI::Notifications;
+    try {
+        auto const notifier = this->notifier();
+        if (!notifier) {
+            return E_UNEXPECTED;
+        }
+        NotificationData data;
+        for (const auto &binding: values) {
+            data.Values().Insert(winrt::hstring{binding.key}, winrt::hstring{binding.value});
+        }
+        data.SequenceNumber(sequence);
+        const auto &toast = static_cast<util::winrt_toast_handle&>(handle).toast;
+        if (!toast) {
+            return E_NOTIMPL; // 计划通知不支持数据绑定
+        }
+        const winrt::hstring group = toast.Group();
+        const NotificationUpdateResult result = group.empty() ? notifier.Update(data, toast.Tag()) : notifier.Update(data, toast.Tag(), group);
+        switch (result) {
+            case NotificationUpdateResult::Succeeded:
+                return S_OK;
+            case NotificationUpdateResult::NotificationNotFound:
+                return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+            default:
+                return E_FAIL;
+        }
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT winrt_notification_backend::remove_group(std::wstring_view group) {
+    try {
+        std::wstring aumi;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!notifier_) {
+                return E_UNEXPECTED;
+            }
+            aumi = aumi_;
+        }
+        winrt::Windows::UI::Notifications::ToastNotificationManager::History().RemoveGroup(winrt::hstring{group}, winrt::hstring{aumi});
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT winrt_notification_backend::remove_tag(std::wstring_view tag, std::wstring_view group) {
+    try {
+        std::wstring aumi;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!notifier_) {
+                return E_UNEXPECTED;
+            }
+            aumi = aumi_;
+        }
+        winrt::Windows::UI::Notifications::ToastNotificationManager::History().Remove(winrt::hstring{tag}, winrt::hstring{group},
+                                                                                       winrt::hstring{aumi});
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT winrt_notification_backend::schedule(const toast_request& request, const std::chrono::system_clock::time_point due,
+                                             std::unique_ptr<toast_handle>& handle) {
+    using namespace winrt::Windows::UI::Notifications;
+    try {
+        auto const notifier = this->notifier();
+        if (!notifier) {
+            return E_UNEXPECTED;
+        }
+        utility::xml_notifcation_field xml(request.xml);
+        const winrt::Windows::Foundation::DateTime delivery = winrt::clock::from_sys(due);
+        ScheduledToastNotification scheduled(xml, delivery);
+        if (!request.tag.empty()) {
+            scheduled.Tag(winrt::hstring{request.tag});
+        } else if (!request.group.empty()) {
+            scheduled.Tag(winrt::hstring{util::binding_tag(request.id)});
+        }
+        if (!request.group.empty()) {
+            scheduled.Group(winrt::hstring{request.group});
+        }
+        if (request.expiration > 0) {
+            scheduled.ExpirationTime(delivery + std::chrono::milliseconds(request.expiration));
+        }
+        notifier.AddToSchedule(scheduled);
+        handle = std::make_unique<util::winrt_toast_handle>(std::move(scheduled));
+        return S_OK;
+    }
+    catch (const winrt::hresult_error& e) {
+        return e.code();
+    }
+}
+
+HRESULT winrt_notification_backend::hide(toast_handle& handle) {
+    try {
+        auto const notifier = this->notifier();
+        if (!notifier) {
+            return E_UNEXPECTED;
+        }
+        const auto &target = static_cast<util::winrt_toast_handle&>(handle);
+        if (target.scheduled) {
+            notifier.RemoveFromSchedule(target.scheduled); // 已经显示的计划通知无法再通过此对象隐藏
+        } else {
+            notifier.Hide(target.toast);
         }
         return S_OK;
     }
@@ -844,166 +3092,775 @@ HRESULT utility::xml_notifcation_field::add_duration( std::wstring_view duration
     }
 }
 
-HRESULT utility::xml_notifcation_field::add_scenario( std::wstring_view scenario) {
-    try {
-        // 获取 toast 节点列表
-        auto node_list = xml.GetElementsByTagName(L"toast");
-        if (node_list.Size() > 0) {
-            auto toast_node = node_list.GetAt(0);
-            auto toast_element = toast_node.as<winrt::Windows::Data::Xml::Dom::XmlElement>();
+rainy::utility::xml_notifcation_field::xml_notifcation_field(context_bridge ctx_bridge,
+                                                             const notification_template &notifcation_template) {
+    std::wstring buffer;
+    toast_xml_serializer(ctx_bridge).serialize(notifcation_template, buffer);
+    xml.LoadXml(winrt::hstring{buffer}); // 唯一一次跨越ABI的DOM构建
+}
+
+rainy::utility::xml_notifcation_field::xml_notifcation_field(const std::wstring_view xml_view) {
+    load_xml(xml_view);
+}
+#endif
+
+class memory_notification_backend::memory_toast_handle final : public notification_backend::toast_handle {
+public:
+    memory_toast_handle(memory_notification_backend& backend, const std::int64_t id) noexcept : backend_(backend), id_(id) {
+    }
+
+    ~memory_toast_handle() override {
+        backend_.detach(id_);
+    }
+
+    std::int64_t id() const noexcept {
+        return id_;
+    }
+
+private:
+    memory_notification_backend& backend_;
+    std::int64_t id_;
+};
+
+memory_notification_backend::memory_notification_backend(const platform_capabilities& capabilities) : capabilities_(capabilities) {
+}
+
+HRESULT memory_notification_backend::create_notifier(std::wstring_view aumi) {
+    std::lock_guard<std::mutex> guard(lock_);
+    aumi_ = aumi;
+    return S_OK;
+}
+
+void memory_notification_backend::release_notifier() noexcept {
+}
+
+platform_capabilities memory_notification_backend::query_capabilities() {
+    return capabilities_;
+}
+
+HRESULT memory_notification_backend::show(const toast_request& request, event_sink& sink, std::unique_ptr<toast_handle>& handle) {
+    return add(request, &sink, handle, std::nullopt);
+}
+
+HRESULT memory_notification_backend::schedule(const toast_request& request, const std::chrono::system_clock::time_point due,
+                                              std::unique_ptr<toast_handle>& handle) {
+    return add(request, nullptr, handle, due); // 计划中的通知不回报事件
+}
+
+namespace util {
+    // 与toast_group_index相同，Group以长度作为前缀
+    inline std::wstring memory_tag_key(std::wstring_view tag, std::wstring_view group) {
+        std::wstring key(1, static_cast<wchar_t>(group.size()));
+        key.append(group);
+        key.append(tag);
+        return key;
+    }
+}
+
+HRESULT memory_notification_backend::add(const toast_request& request, event_sink* sink, std::unique_ptr<toast_handle>& handle,
+                                         const std::optional<std::chrono::system_clock::time_point> due) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!injected_.empty()) {
+        const HRESULT hr = injected_.front();
+        injected_.erase(injected_.begin());
+        if (FAILED(hr)) {
+            return hr;
+        }
+    }
+    if (!request.tag.empty() && !due) {
+        // 与平台一致，相同Tag与Group的通知替换旧的通知
+        const auto [slot, inserted] = tags_.try_emplace(util::memory_tag_key(request.tag, request.group), request.id);
+        if (!inserted) {
+            if (const auto iter = entries_.find(slot->second); iter != entries_.end()) {
+                iter->second.value.visible = false;
+            }
+            slot->second = request.id;
+        }
+    }
+    record value;
+    value.id = request.id;
+    value.xml = request.xml;
+    value.expiration = request.expiration;
+    value.tag = request.tag;
+    value.group = request.group;
+    value.priority = request.priority;
+    value.data.assign(request.data.begin(), request.data.end());
+    value.sequence = request.data.empty() ? 0 : 1;
+    value.due = due;
+    const auto [iter, inserted] = entries_.try_emplace(request.id);
+    if (inserted) {
+        order_.push_back(request.id);
+    }
+    iter->second = {std::move(value), sink};
+    handle = std::make_unique<memory_toast_handle>(*this, request.id);
+    return S_OK;
+}
+
+HRESULT memory_notification_backend::hide(toast_handle& handle) {
+    const std::int64_t id = static_cast<memory_toast_handle&>(handle).id();
+    std::lock_guard<std::mutex> guard(lock_);
+    if (const auto iter = entries_.find(id); iter != entries_.end()) {
+        iter->second.value.visible = false;
+    }
+    return S_OK;
+}
+
+HRESULT memory_notification_backend::update(toast_handle& handle, std::span<const notification_template::data_binding> values,
+                                            const std::uint32_t sequence) {
+    const std::int64_t id = static_cast<memory_toast_handle&>(handle).id();
+    std::lock_guard<std::mutex> guard(lock_);
+    const auto iter = entries_.find(id);
+    if (iter == entries_.end() || !iter->second.value.visible) {
+        return HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
+    }
+    auto& target = iter->second.value;
+    if (target.sequence == 0) {
+        return E_FAIL; // 未启用数据绑定的通知不能更新
+    }
+    if (sequence <= target.sequence) {
+        return S_OK; // 平台忽略序列号未递增的更新
+    }
+    for (const auto& value : values) {
+        const auto found = std::find_if(target.data.begin(), target.data.end(),
+                                        [&value](const notification_template::data_binding& item) { return item.key == value.key; });
+        if (found != target.data.end()) {
+            found->value = value.value;
+        } else {
+            target.data.push_back(value);
+        }
+    }
+    target.sequence = sequence;
+    return S_OK;
+}
+
+HRESULT memory_notification_backend::remove_group(std::wstring_view group) {
+    std::lock_guard<std::mutex> guard(lock_);
+    for (auto& [id, target] : entries_) {
+        if (target.value.group == group) {
+            target.value.visible = false;
+        }
+    }
+    return S_OK;
+}
+
+HRESULT memory_notification_backend::remove_tag(std::wstring_view tag, std::wstring_view group) {
+    std::lock_guard<std::mutex> guard(lock_);
+    for (auto& [id, target] : entries_) {
+        if (target.value.tag == tag && target.value.group == group) {
+            target.value.visible = false;
+        }
+    }
+    return S_OK;
+}
+
+void memory_notification_backend::inject_show_result(const HRESULT hr) {
+    std::lock_guard<std::mutex> guard(lock_);
+    injected_.push_back(hr);
+}
+
+notification_backend::event_sink* memory_notification_backend::close(const std::int64_t id) {
+    std::lock_guard<std::mutex> guard(lock_);
+    const auto iter = entries_.find(id);
+    if (iter == entries_.end() || !iter->second.sink) {
+        return nullptr;
+    }
+    // 激活、关闭与失败都会使通知离开屏幕
+    iter->second.value.visible = false;
+    return iter->second.sink;
+}
+
+void memory_notification_backend::detach(const std::int64_t id) noexcept {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (const auto iter = entries_.find(id); iter != entries_.end()) {
+        iter->second.sink = nullptr;
+    }
+}
+
+bool memory_notification_backend::simulate_activated(const std::int64_t id, std::wstring_view arguments,
+                                                     std::span<const user_input> inputs) {
+    // 回报事件时不持有锁，处理器可以在回调中调用hide等操作
+    event_sink* sink = close(id);
+    if (!sink) {
+        return false;
+    }
+    sink->on_activated(id, activation{arguments, inputs});
+    return true;
+}
+
+bool memory_notification_backend::simulate_dismissed(const std::int64_t id, const notification_handler::dismissal_reason reason) {
+    event_sink* sink = close(id);
+    if (!sink) {
+        return false;
+    }
+    sink->on_dismissed(id, reason);
+    return true;
+}
+
+bool memory_notification_backend::simulate_failed(const std::int64_t id) {
+    event_sink* sink = close(id);
+    if (!sink) {
+        return false;
+    }
+    sink->on_failed(id);
+    return true;
+}
+
+std::optional<memory_notification_backend::record> memory_notification_backend::find(const std::int64_t id) const {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (const auto iter = entries_.find(id); iter != entries_.end()) {
+        return iter->second.value;
+    }
+    return std::nullopt;
+}
+
+std::vector<memory_notification_backend::record> memory_notification_backend::records() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    std::vector<record> result;
+    result.reserve(order_.size());
+    for (const std::int64_t id : order_) {
+        result.push_back(entries_.at(id).value);
+    }
+    return result;
+}
+
+std::size_t memory_notification_backend::visible_count() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return static_cast<std::size_t>(
+        std::count_if(entries_.begin(), entries_.end(), [](const auto& item) { return item.second.value.visible && !item.second.value.due; }));
+}
+
+std::wstring memory_notification_backend::aumi() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return aumi_;
+}
+
+void memory_notification_backend::clear() {
+    std::lock_guard<std::mutex> guard(lock_);
+    // 仍被notification持有句柄的条目保留其事件回报，只清除记录
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+        if (iter->second.sink) {
+            ++iter;
+        } else {
+            iter = entries_.erase(iter);
+        }
+    }
+    order_.erase(std::remove_if(order_.begin(), order_.end(), [this](const std::int64_t id) { return !entries_.count(id); }),
+                 order_.end());
+    std::erase_if(tags_, [this](const auto& item) { return !entries_.count(item.second); });
+}
+
+void utility::toast_xml_serializer::append_escaped(std::wstring &buffer, std::wstring_view text) {
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        std::wstring_view entity;
+        switch (text[i]) {
+            case L'&':
+                entity = L"&amp;";
+                break;
+            case L'<':
+                entity = L"&lt;";
+                break;
+            case L'>':
+                entity = L"&gt;";
+                break;
+            case L'"':
+                entity = L"&quot;";
+                break;
+            case L'\'':
+                entity = L"&apos;";
+                break;
+            default:
+                continue;
+        }
+        buffer.append(text.substr(begin, i - begin));
+        buffer.append(entity);
+        begin = i + 1;
+    }
+    buffer.append(text.substr(begin));
+}
+
+std::size_t utility::toast_xml_serializer::estimate_size(const notification_template &notifcation_template) const noexcept {
+    std::size_t size = 128; // toast/visual/binding骨架以及toast上的属性
+    for (std::size_t i = 0, fields_count = notifcation_template.text_fields_count(); i < fields_count; ++i) {
+        size += 24 + notifcation_template.text_field(notification_template::textfield(i)).size();
+    }
+    size += notifcation_template.has_image() ? 96 + notifcation_template.image_path().size() : 0;
+    size += notifcation_template.has_hero_image() ? 48 + notifcation_template.hero_image_path().size() : 0;
+    size += notifcation_template.attribution_text().empty() ? 0 : 40 + notifcation_template.attribution_text().size();
+    if (notifcation_template.has_progress_bar()) {
+        const auto &progress_bar = notifcation_template.progress_bar();
+        size += 80 + progress_bar.title.size() + progress_bar.value.size() + progress_bar.value_string.size() + progress_bar.status.size();
+    }
+    size += notifcation_template.audio_path().size() + 40;
+    size += notifcation_template.scenario().size();
+    for (const auto &input: notifcation_template.inputs()) {
+        size += 160 + input.id.size() * 3 + input.placeholder.size();
+    }
+    for (std::size_t i = 0, actions_count = notifcation_template.actions.count(); i < actions_count; ++i) {
+        size += 48 + notifcation_template.actions.action_label(i).size();
+    }
+    return size;
+}
+
+std::wstring utility::toast_xml_serializer::serialize(const notification_template &notifcation_template) const {
+    std::wstring buffer;
+    serialize(notifcation_template, buffer);
+    return buffer;
+}
+
+/* 直接输出完整XML，插槽内容就地填充 */
+struct utility::toast_xml_serializer::direct_writer {
+    std::wstring &buffer;
+    const notification_template &notifcation_template;
+
+    void literal(std::wstring_view text) {
+        buffer.append(text);
+    }
+
+    void escaped(std::wstring_view text) {
+        append_escaped(buffer, text);
+    }
+
+    void slot(compiled_toast_template::slot_kind kind) {
+        compiled_toast_template::fill_slot(buffer, kind, notifcation_template);
+    }
+};
+
+namespace util {
+    /* GetTemplateContent在Windows 10/11上返回的传统模板XML，内嵌骨架必须与其逐字一致 */
+    constexpr std::wstring_view recorded_legacy_templates[] = {
+        L"<toast><visual><binding template=\"ToastImageAndText01\"><image id=\"1\" src=\"\"/><text id=\"1\"></text></binding></visual></toast>",
+        L"<toast><visual><binding template=\"ToastImageAndText02\"><image id=\"1\" src=\"\"/><text id=\"1\"></text><text id=\"2\"></text>"
+        L"</binding></visual></toast>",
+        L"<toast><visual><binding template=\"ToastImageAndText03\"><image id=\"1\" src=\"\"/><text id=\"1\"></text><text id=\"2\"></text>"
+        L"</binding></visual></toast>",
+        L"<toast><visual><binding template=\"ToastImageAndText04\"><image id=\"1\" src=\"\"/><text id=\"1\"></text><text id=\"2\"></text>"
+        L"<text id=\"3\"></text></binding></visual></toast>",
+        L"<toast><visual><binding template=\"ToastText01\"><text id=\"1\"></text></binding></visual></toast>",
+        L"<toast><visual><binding template=\"ToastText02\"><text id=\"1\"></text><text id=\"2\"></text></binding></visual></toast>",
+        L"<toast><visual><binding template=\"ToastText03\"><text id=\"1\"></text><text id=\"2\"></text></binding></visual></toast>",
+        L"<toast><visual><binding template=\"ToastText04\"><text id=\"1\"></text><text id=\"2\"></text><text id=\"3\"></text>"
+        L"</binding></visual></toast>",
+    };
+
+    constexpr bool at(std::wstring_view xml, std::size_t pos, std::wstring_view before, std::wstring_view after) noexcept {
+        return pos >= before.size() && xml.substr(pos - before.size(), before.size()) == before && xml.substr(pos, after.size()) == after;
+    }
+
+    constexpr bool verify_legacy_skeletons() noexcept {
+        for (std::size_t i = 0; i < std::size(internals::legacy_skeletons); ++i) {
+            const auto &skeleton = internals::legacy_skeletons[i];
+            if (skeleton.xml != recorded_legacy_templates[i] || !at(skeleton.xml, skeleton.toast_attributes, L"<toast", L">") ||
+                !at(skeleton.xml, skeleton.visual_begin, L"<toast>", L"<visual>") ||
+                !at(skeleton.xml, skeleton.binding_attributes, L"\"", L">") ||
+                !at(skeleton.xml, skeleton.binding_end, L"</text>", L"</binding>")) {
+                return false;
+            }
+            if (skeleton.image_src != internals::legacy_skeleton::npos && !at(skeleton.xml, skeleton.image_src, L"src=\"", L"\"/>")) {
+                return false;
+            }
+            for (std::size_t line = 0; line < std::size(skeleton.text); ++line) {
+                const bool present = line < internals::text_fields_count[i];
+                if (present != (skeleton.text[line] != internals::legacy_skeleton::npos) ||
+                    (present && !at(skeleton.xml, skeleton.text[line], L"\">", L"</text>"))) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static_assert(verify_legacy_skeletons(), "embedded legacy toast skeletons diverge from the recorded OS templates");
+}
+
+/* 只输出与形状相关的内容，插槽仅记录其在骨架中的位置 */
+struct utility::toast_xml_serializer::compile_writer {
+    compiled_toast_template &compiled;
 
-            // 设置 scenario 属性
-            toast_element.SetAttribute(L"scenario", scenario);
-        }
+    void literal(std::wstring_view text) {
+        compiled.skeleton_.append(text);
+    }
 
-        return S_OK;
+    void escaped(std::wstring_view text) {
+        append_escaped(compiled.skeleton_, text);
     }
-    catch (const winrt::hresult_error& e) {
-        return e.code();
+
+    void slot(compiled_toast_template::slot_kind kind) {
+        compiled.slots_.push_back({compiled.skeleton_.size(), kind});
+    }
+};
+
+namespace util {
+    template <typename Writer>
+    void write_attribute(Writer &writer, std::wstring_view name, std::wstring_view value) {
+        writer.literal(L" ");
+        writer.literal(name);
+        writer.literal(L"=\"");
+        writer.escaped(value);
+        writer.literal(L"\"");
     }
 }
 
-HRESULT utility::xml_notifcation_field::add_input() {
-    try {
-        // 定义属性列表
-        std::vector<std::wstring> attrbs = { L"id", L"type", L"placeHolderContent" };
-        std::vector<std::wstring> attrbs2 = { L"content", L"arguments" };
-        // 创建元素
-        util::create_element(xml, L"toast", L"actions", {});
-        util::create_element(xml, L"actions", L"input", attrbs);
-        util::create_element(xml, L"actions", L"action", attrbs2);
-        // 获取 "input" 节点列表
-        auto node_list = xml.GetElementsByTagName(L"input");
-        if (node_list.Size() > 0) {
-            // 获取指定位置的节点
-            auto input_node = node_list.GetAt(0);
-            auto toast_element = input_node.as<winrt::Windows::Data::Xml::Dom::XmlElement>();
-            // 设置属性
-            toast_element.SetAttribute(L"id", L"textBox");
-            toast_element.SetAttribute(L"type", L"text");
-            toast_element.SetAttribute(L"placeHolderContent", L"...");
-        }
-        // 获取 "action" 节点列表
-        auto node_list2 = xml.GetElementsByTagName(L"action");
-        if (node_list2.Size() > 0) {
-            // 获取指定位置的节点
-            auto action_node = node_list2.GetAt(0);
-            auto action_element = action_node.as<winrt::Windows::Data::Xml::Dom::XmlElement>();
-            // 设置属性
-            action_element.SetAttribute(L"content", L"Reply");
-            action_element.SetAttribute(L"arguments", L"action=reply");
-            action_element.SetAttribute(L"hint-inputId", L"textBox");
+/* <toast>起始标签及其属性 */
+template <typename Writer>
+void utility::toast_xml_serializer::write_open(const notification_template &notifcation_template, Writer &writer) const {
+    using duration_t = notification_template::duration_t;
+    writer.literal(L"<toast");
+    if (ctx_bridge_.is_supporting_modern_features() && ctx_bridge_.is_enable_modern_features()) {
+        const auto duration = notifcation_template.duration();
+        if (duration != duration_t::system) {
+            util::write_attribute(writer, L"duration", duration == duration_t::short_duration ? L"short" : L"long");
+        } else if (!notifcation_template.actions.empty() && !notifcation_template.has_input()) {
+            util::write_attribute(writer, L"duration", L"long"); // 带操作按钮的通知默认长时间显示
         }
-        return S_OK;
+        util::write_attribute(writer, L"scenario", notifcation_template.scenario());
     }
-    catch (const winrt::hresult_error& e) {
-        return e.code();
+    writer.literal(L">");
+}
+
+/* </visual>之后的操作按钮、音频以及</toast> */
+template <typename Writer>
+void utility::toast_xml_serializer::write_close(const notification_template &notifcation_template, Writer &writer) const {
+    using audio_option_t = notification_template::audio_option_t;
+    const auto attribute = [&writer](std::wstring_view name, std::wstring_view value) { util::write_attribute(writer, name, value); };
+    if (ctx_bridge_.is_supporting_modern_features() && ctx_bridge_.is_enable_modern_features()) {
+        const std::size_t actions_count = notifcation_template.actions.count();
+        if (notifcation_template.has_input()) {
+            if (ctx_bridge_.is_supporting_input()) {
+                // 存在输入框时仅允许回复操作，回复按钮关联第一个输入框，激活参数见toast_arguments
+                const auto inputs = notifcation_template.inputs();
+                writer.literal(L"<actions>");
+                for (const auto &input: inputs) {
+                    writer.literal(L"<input");
+                    attribute(L"id", input.id);
+                    writer.literal(L" type=\"text\"");
+                    attribute(L"placeHolderContent", input.placeholder);
+                    writer.literal(L"/>");
+                }
+                writer.literal(L"<action content=\"Reply\" arguments=\"action=reply;input=");
+                writer.escaped(inputs.front().id);
+                writer.literal(L";\"");
+                attribute(L"hint-inputId", inputs.front().id);
+                writer.literal(L"/></actions>");
+            }
+        } else if (actions_count != 0) {
+            writer.literal(L"<actions>");
+            for (std::size_t i = 0; i < actions_count; ++i) {
+                const wchar_t index = static_cast<wchar_t>(L'0' + i);
+                writer.literal(L"<action");
+                attribute(L"content", notifcation_template.actions.action_label(i));
+                writer.literal(L" arguments=\"action=");
+                writer.literal({&index, 1});
+                writer.literal(L";\"/>");
+            }
+            writer.literal(L"</actions>");
+        }
+        const auto audio_option = notifcation_template.audio_option();
+        if (!notifcation_template.audio_path().empty() || audio_option != audio_option_t::default_option) {
+            writer.literal(L"<audio");
+            if (!notifcation_template.audio_path().empty()) {
+                attribute(L"src", notifcation_template.audio_path());
+            }
+            if (audio_option == audio_option_t::loop) {
+                attribute(L"loop", L"true");
+            } else if (audio_option == audio_option_t::silent) {
+                attribute(L"silent", L"true");
+            }
+            writer.literal(L"/>");
+        }
     }
+    writer.literal(L"</toast>");
 }
 
-HRESULT utility::xml_notifcation_field::set_text_field( std::wstring_view text, std::uint32_t pos) {
-    try {
-        // 获取 "text" 节点列表
-        auto node_list = xml.GetElementsByTagName(L"text");
-        if (node_list.Size() > pos) {
-            // 获取指定位置的节点
-            auto node = node_list.GetAt(pos);
-            return util::set_node_string_value(text, &node, xml); // 设置节点的字符串值
+template <typename Writer>
+void utility::toast_xml_serializer::write(const notification_template &notifcation_template, Writer &writer) const {
+    using slot_kind = compiled_toast_template::slot_kind;
+    const auto attribute = [&writer](std::wstring_view name, std::wstring_view value) { util::write_attribute(writer, name, value); };
+    const bool modern = ctx_bridge_.is_supporting_modern_features() && ctx_bridge_.is_enable_modern_features();
+    write_open(notifcation_template, writer);
+    if (!notifcation_template.is_toast_generic()) {
+        // 传统模板的visual按预计算的偏移从内嵌骨架中分段复制
+        const auto &skeleton = internals::legacy_skeletons[static_cast<std::size_t>(notifcation_template.template_type())];
+        std::size_t offset = skeleton.visual_begin;
+        const auto copy_until = [&](const std::size_t pos) {
+            writer.literal(skeleton.xml.substr(offset, pos - offset));
+            offset = pos;
+        };
+        if (skeleton.image_src != internals::legacy_skeleton::npos) {
+            copy_until(skeleton.image_src);
+            writer.slot(slot_kind::image);
+        }
+        for (std::size_t i = 0; i < std::size(skeleton.text) && skeleton.text[i] != internals::legacy_skeleton::npos; ++i) {
+            copy_until(skeleton.text[i]);
+            writer.slot(static_cast<slot_kind>(static_cast<std::size_t>(slot_kind::first_line) + i));
+        }
+        copy_until(skeleton.binding_end);
+    } else {
+        writer.literal(L"<visual><binding template=\"ToastGeneric\">");
+        if (notifcation_template.has_image()) {
+            writer.literal(L"<image id=\"1\" src=\"");
+            writer.slot(slot_kind::image);
+            writer.literal(L"\"");
+            attribute(L"placement", L"appLogoOverride");
+            if (ctx_bridge_.is_supporting_crop_circle() && notifcation_template.is_crop_hint_circle()) {
+                attribute(L"hint-crop", L"circle");
+            }
+            writer.literal(L"/>");
+        }
+        for (std::size_t i = 0, fields_count = notifcation_template.text_fields_count(); i < fields_count; ++i) {
+            const wchar_t id = static_cast<wchar_t>(L'1' + i);
+            writer.literal(L"<text id=\"");
+            writer.literal({&id, 1});
+            writer.literal(L"\">");
+            writer.slot(static_cast<slot_kind>(static_cast<std::size_t>(slot_kind::first_line) + i));
+            writer.literal(L"</text>");
         }
-        return E_FAIL;
     }
-    catch (const winrt::hresult_error& e) {
-        return e.code();
+    if (modern && !notifcation_template.attribution_text().empty()) {
+        writer.literal(L"<text placement=\"attribution\">");
+        writer.slot(slot_kind::attribution);
+        writer.literal(L"</text>");
+    }
+    if (modern && notifcation_template.has_progress_bar()) {
+        // 进度条的属性通常是绑定占位符，按形状的一部分写入骨架
+        const auto &progress_bar = notifcation_template.progress_bar();
+        writer.literal(L"<progress");
+        if (!progress_bar.title.empty()) {
+            attribute(L"title", progress_bar.title);
+        }
+        attribute(L"value", progress_bar.value);
+        if (!progress_bar.value_string.empty()) {
+            attribute(L"valueStringOverride", progress_bar.value_string);
+        }
+        attribute(L"status", progress_bar.status);
+        writer.literal(L"/>");
+    }
+    if (ctx_bridge_.is_supporting_hero_image() && notifcation_template.has_hero_image()) {
+        writer.literal(L"<image");
+        if (!notifcation_template.is_inline_hero_image()) {
+            attribute(L"placement", L"hero");
+        }
+        writer.literal(L" src=\"");
+        writer.slot(slot_kind::hero_image);
+        writer.literal(L"\"/>");
     }
+    writer.literal(L"</binding></visual>");
+    write_close(notifcation_template, writer);
 }
 
-HRESULT utility::xml_notifcation_field::set_bind_toast_generic() {
-    try {
-        // 获取 "binding" 节点列表
-        auto nodeList = xml.GetElementsByTagName(L"binding");
-        if (nodeList.Size() > 0) {
-            // 获取第一个节点
-            auto toastNode = nodeList.GetAt(0);
-            // 获取节点并设置模板属性
-            if (auto toastElement = toastNode.as<winrt::Windows::Data::Xml::Dom::XmlElement>()) {
-                toastElement.SetAttribute(L"template", L"ToastGeneric");
+void utility::toast_xml_serializer::serialize(const notification_template &notifcation_template, std::wstring &buffer) const {
+    buffer.clear();
+    buffer.reserve(estimate_size(notifcation_template));
+    direct_writer writer{buffer, notifcation_template};
+    write(notifcation_template, writer);
+}
+
+template <notification_template_type Type>
+void utility::toast_xml_serializer::serialize(const static_notification_template<Type> &notifcation_template, std::wstring &buffer) const {
+    using layout = internals::static_layout<Type>;
+    using slot_kind = compiled_toast_template::slot_kind;
+    const notification_template &runtime_template = notifcation_template.get();
+    buffer.clear();
+    buffer.reserve(estimate_size(runtime_template));
+    direct_writer writer{buffer, runtime_template};
+    write_open(runtime_template, writer);
+    std::size_t segment = 0;
+    buffer.append(layout::segment(segment++));
+    if constexpr (layout::has_image) {
+        compiled_toast_template::fill_slot(buffer, slot_kind::image, runtime_template);
+        buffer.append(layout::segment(segment++));
+    }
+    for (std::size_t i = 0; i < layout::fields_count; ++i) {
+        compiled_toast_template::fill_slot(buffer, static_cast<slot_kind>(i), runtime_template);
+        buffer.append(layout::segment(segment++));
+    }
+    if (ctx_bridge_.is_supporting_modern_features() && ctx_bridge_.is_enable_modern_features() &&
+        !runtime_template.attribution_text().empty()) {
+        buffer.append(L"<text placement=\"attribution\">");
+        compiled_toast_template::fill_slot(buffer, slot_kind::attribution, runtime_template);
+        buffer.append(L"</text>");
+    }
+    buffer.append(layout::closing);
+    write_close(runtime_template, writer);
+}
+
+template void utility::toast_xml_serializer::serialize(const static_notification_template<notification_template_type::image_and_text01> &,
+                                                       std::wstring &) const;
+template void utility::toast_xml_serializer::serialize(const static_notification_template<notification_template_type::image_and_text02> &,
+                                                       std::wstring &) const;
+template void utility::toast_xml_serializer::serialize(const static_notification_template<notification_template_type::image_and_text03> &,
+                                                       std::wstring &) const;
+template void utility::toast_xml_serializer::serialize(const static_notification_template<notification_template_type::image_and_text04> &,
+                                                       std::wstring &) const;
+template void utility::toast_xml_serializer::serialize(const static_notification_template<notification_template_type::text01> &,
+                                                       std::wstring &) const;
+template void utility::toast_xml_serializer::serialize(const static_notification_template<notification_template_type::text02> &,
+                                                       std::wstring &) const;
+template void utility::toast_xml_serializer::serialize(const static_notification_template<notification_template_type::text03> &,
+                                                       std::wstring &) const;
+template void utility::toast_xml_serializer::serialize(const static_notification_template<notification_template_type::text04> &,
+                                                       std::wstring &) const;
+
+utility::compiled_toast_template utility::toast_xml_serializer::compile(const notification_template &notifcation_template) const {
+    compiled_toast_template compiled;
+    compiled.skeleton_.reserve(estimate_size(notifcation_template));
+    compile_writer writer{compiled};
+    write(notifcation_template, writer);
+    compiled.skeleton_.shrink_to_fit();
+    return compiled;
+}
+
+void utility::compiled_toast_template::fill_slot(std::wstring &buffer, slot_kind kind, const notification_template &notifcation_template) {
+    switch (kind) {
+        case slot_kind::first_line:
+        case slot_kind::second_line:
+        case slot_kind::third_line:
+            toast_xml_serializer::append_escaped(
+                buffer, notifcation_template.text_field(notification_template::textfield(static_cast<std::size_t>(kind))));
+            break;
+        case slot_kind::attribution:
+            toast_xml_serializer::append_escaped(buffer, notifcation_template.attribution_text());
+            break;
+        case slot_kind::image:
+            if (!notifcation_template.image_path().empty()) {
+                buffer.append(L"file:///");
+                toast_xml_serializer::append_escaped(buffer, notifcation_template.image_path());
             }
-            return S_OK;
+            break;
+        case slot_kind::hero_image:
+            toast_xml_serializer::append_escaped(buffer, notifcation_template.hero_image_path());
+            break;
+    }
+}
+
+void utility::compiled_toast_template::render(const notification_template &notifcation_template, std::wstring &buffer) const {
+    std::size_t size = skeleton_.size() + 16;
+    for (const auto &slot: slots_) {
+        switch (slot.kind) {
+            case slot_kind::attribution:
+                size += notifcation_template.attribution_text().size();
+                break;
+            case slot_kind::image:
+                size += notifcation_template.image_path().size() + 8;
+                break;
+            case slot_kind::hero_image:
+                size += notifcation_template.hero_image_path().size();
+                break;
+            default:
+                size += notifcation_template.text_field(notification_template::textfield(static_cast<std::size_t>(slot.kind))).size();
+                break;
         }
-        return E_FAIL;
     }
-    catch (const winrt::hresult_error& e) {
-        return e.code();
+    buffer.clear();
+    buffer.reserve(size);
+    const std::wstring_view skeleton = skeleton_;
+    std::size_t offset = 0;
+    for (const auto &slot: slots_) {
+        buffer.append(skeleton.substr(offset, slot.offset - offset));
+        fill_slot(buffer, slot.kind, notifcation_template);
+        offset = slot.offset;
     }
+    buffer.append(skeleton.substr(offset));
 }
 
-std::optional<winrt::Windows::UI::Notifications::ToastNotifier> notification::create_notifier() const {
-    try {
-        auto notificationManager = winrt::Windows::UI::Notifications::ToastNotificationManager::GetDefault();
-        return notificationManager.CreateToastNotifier(aumi_);
+void utility::template_cache::make_shape_key(context_bridge ctx_bridge, const notification_template &notifcation_template,
+                                             std::wstring &key) {
+    // 变长字段以长度作为前缀，避免不同的形状拼接出相同的键
+    const auto append_field = [&key](std::wstring_view field) {
+        key.push_back(static_cast<wchar_t>(field.size()));
+        key.append(field);
+    };
+    key.clear();
+    key.push_back(static_cast<wchar_t>(ctx_bridge.options()));
+    key.push_back(static_cast<wchar_t>(notifcation_template.template_type()));
+    key.push_back(static_cast<wchar_t>(notifcation_template.is_toast_generic() | notifcation_template.is_crop_hint_circle() << 1 |
+                                       notifcation_template.has_hero_image() << 2 | notifcation_template.is_inline_hero_image() << 3 |
+                                       notifcation_template.has_input() << 4 | notifcation_template.attribution_text().empty() << 5));
+    key.push_back(static_cast<wchar_t>(notifcation_template.duration()));
+    key.push_back(static_cast<wchar_t>(notifcation_template.audio_option()));
+    append_field(notifcation_template.audio_path());
+    append_field(notifcation_template.scenario());
+    const auto &progress_bar = notifcation_template.progress_bar();
+    append_field(progress_bar.value);
+    append_field(progress_bar.status);
+    append_field(progress_bar.title);
+    append_field(progress_bar.value_string);
+    key.push_back(static_cast<wchar_t>(notifcation_template.inputs().size()));
+    for (const auto &input: notifcation_template.inputs()) {
+        append_field(input.id);
+        append_field(input.placeholder);
     }
-    catch (const winrt::hresult_error&) {
-        return std::nullopt;
+    key.push_back(static_cast<wchar_t>(notifcation_template.actions.count()));
+    for (std::size_t i = 0, actions_count = notifcation_template.actions.count(); i < actions_count; ++i) {
+        append_field(notifcation_template.actions.action_label(i));
     }
 }
 
-rainy::utility::xml_notifcation_field::xml_notifcation_field(context_bridge ctx_bridge,
-                                                             const notification_template &notifcation_template) {
-    using namespace winrt::Windows::UI::Notifications;
-    using namespace winrt::Windows::Data::Xml::Dom;
-    xml = ToastNotificationManager::GetTemplateContent(static_cast<ToastTemplateType>(notifcation_template.template_type()));
-    HRESULT hr = S_OK;
-    if (notifcation_template.is_toast_generic()) {
-        hr = set_bind_toast_generic();
-    }
-    for (std::uint32_t i = 0, fields_count = static_cast<std::uint32_t>(notifcation_template.text_fields_count());
-         i < fields_count && SUCCEEDED(hr); i++) {
-        hr = set_text_field(notifcation_template.text_field(notification_template::textfield(i)), i);
-    }
-    winrt::check_hresult(hr);
-    if (ctx_bridge.is_supporting_modern_features() && ctx_bridge.is_enable_modern_features()) {
-        if (!notifcation_template.attribution_text().empty()) {
-            hr = set_attribution_text_field(notifcation_template.attribution_text());
-        }
-        if (notifcation_template.has_input() && notifcation_template.actions.count() != 0) {
-            hr = add_input(); // 仅允许add_input
+void utility::template_cache::render(context_bridge ctx_bridge, const notification_template &notifcation_template,
+                                     std::wstring &buffer) {
+    std::shared_ptr<const compiled_toast_template> compiled;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (capacity_ == 0) {
+            ++misses_;
         } else {
-            std::array<WCHAR, 12> buf{};
-            for (std::size_t i = 0, actions_count = notifcation_template.actions.count(); i < actions_count && SUCCEEDED(hr); i++) {
-                _snwprintf_s(buf.data(), buf.size(), _TRUNCATE, L"%zd", i);
-                hr = add_action(notifcation_template.actions.action_label(i), buf.data());
-                winrt::check_hresult(hr);
-            }
-            if (notifcation_template.has_input()) {
-                hr = add_input();
-            }
-            winrt::check_hresult(hr);
-        }
-        hr = (notifcation_template.audio_path().empty() &&
-              notifcation_template.audio_option() == notification_template::audio_option_t::default_option)
-                 ? hr
-                 : set_audio_field(notifcation_template.audio_path(), notifcation_template.audio_option());
-        winrt::check_hresult(hr);
-        auto duration = notifcation_template.duration();
-        if (duration != notification_template::duration_t::system) {
-            hr = add_duration((duration == notification_template::duration_t::short_duration) ? L"short" : L"long");
-        }
-        winrt::check_hresult(hr);
-        hr = add_scenario(notifcation_template.scenario());
-    }
-    winrt::check_hresult(hr);
-    const bool is_win10_anniversary_or_above = notification::is_win10_anniversary_or_higher();
-    const bool is_circle_crop_hint = is_win10_anniversary_or_above ? notifcation_template.is_crop_hint_circle() : false;
-    hr = notifcation_template.has_image()
-             ? set_image_field(notifcation_template.image_path(), notifcation_template.is_toast_generic(), is_circle_crop_hint)
-             : hr;
-    winrt::check_hresult(hr);
-    if (is_win10_anniversary_or_above && notifcation_template.has_hero_image()) {
-        hr = set_hero_image(notifcation_template.hero_image_path(), notifcation_template.is_inline_hero_image());
-    }
-    winrt::check_hresult(hr);
+            make_shape_key(ctx_bridge, notifcation_template, key_buffer_);
+            const auto iter = index_.find(key_buffer_);
+            if (iter != index_.end()) {
+                ++hits_;
+                lru_.splice(lru_.begin(), lru_, iter->second); // 移动到最近使用的位置，迭代器保持有效
+                compiled = iter->second->compiled;
+            } else {
+                ++misses_;
+            }
+        }
+    }
+    if (compiled) {
+        compiled->render(notifcation_template, buffer);
+        return;
+    }
+    toast_xml_serializer serializer(ctx_bridge);
+    auto fresh = std::make_shared<const compiled_toast_template>(serializer.compile(notifcation_template));
+    fresh->render(notifcation_template, buffer);
+    std::lock_guard<std::mutex> guard(lock_);
+    if (capacity_ == 0) {
+        return;
+    }
+    make_shape_key(ctx_bridge, notifcation_template, key_buffer_);
+    if (index_.find(key_buffer_) != index_.end()) {
+        return; // 其他线程已经编译了相同的形状
+    }
+    evict_to(capacity_ - 1);
+    lru_.push_front({key_buffer_, std::move(fresh)});
+    index_.emplace(lru_.front().key, lru_.begin());
+}
+
+void utility::template_cache::evict_to(std::size_t capacity) {
+    while (lru_.size() > capacity) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+        ++evictions_;
+    }
+}
+
+void utility::template_cache::set_capacity(std::size_t capacity) {
+    std::lock_guard<std::mutex> guard(lock_);
+    capacity_ = capacity;
+    evict_to(capacity);
+}
+
+void utility::template_cache::clear() {
+    std::lock_guard<std::mutex> guard(lock_);
+    index_.clear();
+    lru_.clear();
+}
+
+utility::template_cache::statistics utility::template_cache::stats() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return {hits_, misses_, evictions_, lru_.size(), capacity_};
 }
 
+#ifdef _WIN32
 HRESULT utility::xml_notifcation_field::set_image_field(
     std::wstring_view path,
     bool is_toast_generic,
@@ -1164,9 +4021,422 @@ HRESULT utility::xml_notifcation_field::set_hero_image( std::wstring_view path,
         return e.code();
     }
 }
+#endif
 
 void notification::set_error(notification_error* error, notification_error value) {
     if (error) {
         *error = value;
     }
-}
\ No newline at end of file
+}
+
+utility::admission_controller::admission_controller(clock_function clock) : clock_(std::move(clock)) {
+}
+
+utility::admission_controller::time_point utility::admission_controller::now() const {
+    return clock_ ? clock_() : std::chrono::steady_clock::now();
+}
+
+void utility::admission_controller::set_policy(const admission_policy& policy) {
+    std::lock_guard<std::mutex> guard(lock_);
+    policy_ = policy;
+    app_bucket_ = { policy.burst, now() };
+    buckets_.clear();
+    windows_.clear();
+    enabled_.store(policy.rate > 0.0 || policy.coalescing_window.count() > 0, std::memory_order_release);
+}
+
+void utility::admission_controller::set_clock(clock_function clock) {
+    std::lock_guard<std::mutex> guard(lock_);
+    clock_ = std::move(clock);
+    app_bucket_.last = now();
+    buckets_.clear();
+}
+
+bool utility::admission_controller::take_token(const std::wstring_view key, const time_point current) {
+    if (policy_.rate <= 0.0) {
+        return true;
+    }
+    const auto refill = [&](bucket& target) {
+        const std::chrono::duration<double> elapsed = current - target.last;
+        target.tokens = (std::min)(policy_.burst, target.tokens + elapsed.count() * policy_.rate);
+        target.last = current;
+    };
+    bucket* target = &app_bucket_;
+    if (policy_.per_key && !key.empty()) {
+        auto iter = buckets_.find(key);
+        if (iter == buckets_.end()) {
+            if (buckets_.size() >= 1024) {
+                // 丢弃已经补满的令牌桶，它们与新建的令牌桶没有区别
+                for (auto item = buckets_.begin(); item != buckets_.end();) {
+                    refill(item->second);
+                    item = item->second.tokens >= policy_.burst ? buckets_.erase(item) : std::next(item);
+                }
+            }
+            iter = buckets_.emplace(std::wstring{ key }, bucket{ policy_.burst, current }).first;
+        }
+        target = &iter->second;
+    }
+    refill(*target);
+    if (target->tokens < 1.0) {
+        return false;
+    }
+    target->tokens -= 1.0;
+    return true;
+}
+
+utility::admission_controller::decision utility::admission_controller::admit(const notification_template& notification,
+                                                                             internals::inline_handler& handler,
+                                                                             std::int64_t& coalesced_id) {
+    std::lock_guard<std::mutex> guard(lock_);
+    const time_point current = now();
+    const std::wstring_view key = notification.coalescing_key();
+    const bool coalescing = policy_.coalescing_window.count() > 0 && !key.empty();
+    if (coalescing) {
+        const auto iter = windows_.find(key);
+        if (iter != windows_.end() && iter->second.id == -1) {
+            // 最初的通知仍在显示中，没有可以返回的ID，也可能随后显示失败，此时不合并
+            if (!take_token(key, current)) {
+                ++stats_.suppressed;
+                return decision::suppress;
+            }
+            ++stats_.admitted;
+            return decision::admit;
+        }
+        if (iter != windows_.end() && current < iter->second.opened + policy_.coalescing_window) {
+            auto& target = iter->second;
+            ++target.merged;
+            target.latest = notification;
+            std::swap(target.handler, handler);
+            coalesced_id = target.id;
+            ++stats_.merged;
+            return decision::merge;
+        }
+    }
+    if (!take_token(key, current)) {
+        ++stats_.suppressed;
+        return decision::suppress;
+    }
+    if (coalescing) {
+        // 窗口在显示之前就登记，以便并发的同键通知能够合并
+        auto& target = windows_[std::wstring{ key }];
+        target = window{ current };
+        ++stats_.admitted;
+        return decision::open;
+    }
+    ++stats_.admitted;
+    return decision::admit;
+}
+
+internals::inline_handler utility::admission_controller::opened(const std::wstring_view key, const std::int64_t id) {
+    std::lock_guard<std::mutex> guard(lock_);
+    const auto iter = windows_.find(key);
+    if (iter == windows_.end()) {
+        return {};
+    }
+    if (id != -1) {
+        iter->second.id = id;
+        return {};
+    }
+    internals::inline_handler handler = std::move(iter->second.handler);
+    windows_.erase(iter);
+    return handler;
+}
+
+void utility::admission_controller::collect_expired(std::vector<summary>& summaries) {
+    std::lock_guard<std::mutex> guard(lock_);
+    const time_point current = now();
+    for (auto iter = windows_.begin(); iter != windows_.end();) {
+        auto& target = iter->second;
+        // 仍在显示中的窗口由opened关闭或登记ID
+        if (target.id == -1 || current < target.opened + policy_.coalescing_window) {
+            ++iter;
+            continue;
+        }
+        if (target.merged != 0 && target.latest) {
+            notification_template notification = std::move(*target.latest);
+            std::wstring first_line{ notification.text_field(notification_template::textfield::first_line) };
+            first_line.append(L" (+").append(std::to_wstring(target.merged)).append(L")");
+            notification.set_first_line(first_line);
+            summaries.push_back({ std::move(notification), std::move(target.handler), target.id });
+            ++stats_.summaries;
+        }
+        iter = windows_.erase(iter);
+    }
+}
+
+void utility::admission_controller::summary_failed() {
+    std::lock_guard<std::mutex> guard(lock_);
+    ++stats_.summary_failures;
+}
+
+utility::admission_controller::statistics utility::admission_controller::stats() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return stats_;
+}
+
+utility::timer_wheel::timer_wheel(const std::uint64_t now) noexcept : now_(now) {
+    heads_.fill(npos);
+    tails_.fill(npos);
+}
+
+utility::timer_wheel::timer_id utility::timer_wheel::insert(const std::uint64_t deadline, const std::int64_t value) {
+    std::uint32_t index;
+    if (!free_.empty()) {
+        index = free_.back();
+        free_.pop_back();
+    } else {
+        index = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+    }
+    nodes_[index].deadline = deadline;
+    nodes_[index].value = value;
+    place(index);
+    ++size_;
+    return (static_cast<timer_id>(nodes_[index].generation) << 32) | (static_cast<timer_id>(index) + 1);
+}
+
+bool utility::timer_wheel::cancel(const timer_id timer) noexcept {
+    const auto index = static_cast<std::uint32_t>(timer & 0xFFFFFFFF) - 1;
+    if (timer == invalid_timer || index >= nodes_.size()) {
+        return false;
+    }
+    if (nodes_[index].generation != static_cast<std::uint32_t>(timer >> 32) || nodes_[index].slot == npos) {
+        return false; // 已到期或已取消，节点可能已被复用
+    }
+    unlink(index);
+    release(index);
+    --size_;
+    return true;
+}
+
+void utility::timer_wheel::advance(const std::uint64_t now, std::vector<std::int64_t>& expired) {
+    while (now_ < now) {
+        const auto next = next_expiry();
+        if (!next || *next > now) {
+            now_ = now; // 期间没有需要处理的槽，直接跳过
+            return;
+        }
+        process(*next, expired);
+    }
+}
+
+std::optional<std::uint64_t> utility::timer_wheel::next_expiry() const noexcept {
+    std::optional<std::uint64_t> result;
+    if (size_ == 0) {
+        return result;
+    }
+    for (unsigned level = 0; level < level_count; ++level) {
+        if (const auto tick = next_slot_tick(level); tick && (!result || *tick < *result)) {
+            result = tick;
+        }
+    }
+    return result;
+}
+
+void utility::timer_wheel::clear() noexcept {
+    for (std::uint32_t index = 0; index < nodes_.size(); ++index) {
+        if (nodes_[index].slot != npos) {
+            release(index);
+        }
+    }
+    heads_.fill(npos);
+    tails_.fill(npos);
+    occupied_.fill(0);
+    size_ = 0;
+}
+
+void utility::timer_wheel::place(const std::uint32_t index) {
+    // 过期的定时器在下一个tick到期。下一个tick恰好是某层的边界时与其他在该tick到期的定时器放在同一层，保持插入顺序
+    const std::uint64_t deadline = (std::max)(nodes_[index].deadline, now_ + 1);
+    std::uint32_t slot;
+    if (const unsigned level = static_cast<unsigned>(std::bit_width(deadline ^ now_) - 1) / slot_bits; level < level_count) {
+        // 与当前tick在更高层上相同，因此该层的槽号一定大于当前槽号
+        slot = level * slot_count + static_cast<std::uint32_t>((deadline >> (level * slot_bits)) & (slot_count - 1));
+    } else {
+        // 超出最高层的范围时放入最高层的0号槽，在下一圈开始时（不晚于到期时间）重新放置
+        slot = (level_count - 1) * slot_count;
+    }
+    link(index, slot);
+}
+
+void utility::timer_wheel::link(const std::uint32_t index, const std::uint32_t slot) noexcept {
+    node& target = nodes_[index];
+    target.slot = slot;
+    target.next = npos;
+    target.prev = tails_[slot];
+    if (tails_[slot] != npos) {
+        nodes_[tails_[slot]].next = index;
+    } else {
+        heads_[slot] = index;
+        occupied_[slot / 64] |= std::uint64_t{1} << (slot % 64);
+    }
+    tails_[slot] = index;
+}
+
+void utility::timer_wheel::unlink(const std::uint32_t index) noexcept {
+    const node& target = nodes_[index];
+    if (target.prev != npos) {
+        nodes_[target.prev].next = target.next;
+    } else {
+        heads_[target.slot] = target.next;
+    }
+    if (target.next != npos) {
+        nodes_[target.next].prev = target.prev;
+    } else {
+        tails_[target.slot] = target.prev;
+    }
+    if (heads_[target.slot] == npos) {
+        occupied_[target.slot / 64] &= ~(std::uint64_t{1} << (target.slot % 64));
+    }
+}
+
+void utility::timer_wheel::release(const std::uint32_t index) noexcept {
+    nodes_[index].slot = npos;
+    ++nodes_[index].generation;
+    free_.push_back(index); // 容量不小于节点数，不会分配
+}
+
+std::uint32_t utility::timer_wheel::take_slot(const std::uint32_t slot) noexcept {
+    const std::uint32_t head = heads_[slot];
+    heads_[slot] = npos;
+    tails_[slot] = npos;
+    occupied_[slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+    return head;
+}
+
+void utility::timer_wheel::process(const std::uint64_t tick, std::vector<std::int64_t>& expired) {
+    now_ = tick;
+    // 先由高到低降级到达边界的槽，降级后恰好在本tick到期的定时器直接输出
+    for (unsigned level = level_count - 1; level > 0; --level) {
+        const unsigned shift = level * slot_bits;
+        if ((tick & ((std::uint64_t{1} << shift) - 1)) != 0) {
+            continue;
+        }
+        const auto slot = level * slot_count + static_cast<std::uint32_t>((tick >> shift) & (slot_count - 1));
+        for (std::uint32_t index = take_slot(slot); index != npos;) {
+            const std::uint32_t next = nodes_[index].next;
+            if (nodes_[index].deadline <= tick) {
+                expired.push_back(nodes_[index].value);
+                release(index);
+                --size_;
+            } else {
+                place(index);
+            }
+            index = next;
+        }
+    }
+    for (std::uint32_t index = take_slot(static_cast<std::uint32_t>(tick & (slot_count - 1))); index != npos;) {
+        const std::uint32_t next = nodes_[index].next;
+        expired.push_back(nodes_[index].value);
+        release(index);
+        --size_;
+        index = next;
+    }
+}
+
+std::optional<std::uint64_t> utility::timer_wheel::next_slot_tick(const unsigned level) const noexcept {
+    constexpr unsigned words = slot_count / 64;
+    const unsigned shift = level * slot_bits;
+    const auto current = static_cast<unsigned>((now_ >> shift) & (slot_count - 1));
+    const std::uint64_t base = (now_ >> (shift + slot_bits)) << (shift + slot_bits);
+    // 在[from, to)中查找第一个非空槽
+    const auto find = [&](const unsigned from, const unsigned to) -> std::optional<unsigned> {
+        for (unsigned word = from / 64; word < words && word * 64 < to; ++word) {
+            std::uint64_t bits = occupied_[level * words + word];
+            if (word == from / 64) {
+                bits &= ~std::uint64_t{0} << (from % 64);
+            }
+            if (bits != 0) {
+                const unsigned slot = word * 64 + static_cast<unsigned>(std::countr_zero(bits));
+                return slot < to ? std::optional<unsigned>{slot} : std::nullopt;
+            }
+        }
+        return std::nullopt;
+    };
+    if (const auto slot = find(current + 1, slot_count)) {
+        return base + (static_cast<std::uint64_t>(*slot) << shift);
+    }
+    if (const auto slot = find(0, current + 1)) {
+        // 当前槽号之前的槽在下一圈处理
+        return base + (std::uint64_t{1} << (shift + slot_bits)) + (static_cast<std::uint64_t>(*slot) << shift);
+    }
+    return std::nullopt;
+}
+
+std::size_t utility::latency_histogram::bucket_of(const std::uint64_t value) noexcept {
+    if (value < linear_limit) {
+        return static_cast<std::size_t>(value);
+    }
+    const auto exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+    if (exponent > max_exponent) {
+        return bucket_count - 1;
+    }
+    const auto sub_bucket = static_cast<std::size_t>((value >> (exponent - sub_bucket_bits)) & ((1u << sub_bucket_bits) - 1));
+    return static_cast<std::size_t>(linear_limit) + (exponent - sub_bucket_bits - 1) * (1u << sub_bucket_bits) + sub_bucket;
+}
+
+std::uint64_t utility::latency_histogram::bucket_upper(const std::size_t bucket) noexcept {
+    if (bucket < linear_limit) {
+        return bucket;
+    }
+    const std::size_t offset = bucket - static_cast<std::size_t>(linear_limit);
+    const unsigned exponent = static_cast<unsigned>(offset >> sub_bucket_bits) + sub_bucket_bits + 1;
+    const std::uint64_t sub_bucket = offset & ((1u << sub_bucket_bits) - 1);
+    const unsigned shift = exponent - sub_bucket_bits;
+    return (((std::uint64_t{1} << sub_bucket_bits) + sub_bucket + 1) << shift) - 1;
+}
+
+void utility::latency_histogram::record(const std::uint64_t nanoseconds) noexcept {
+    buckets_[bucket_of(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(nanoseconds, std::memory_order_relaxed);
+    std::uint64_t observed = max_.load(std::memory_order_relaxed);
+    while (nanoseconds > observed && !max_.compare_exchange_weak(observed, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+utility::latency_histogram::summary utility::latency_histogram::summarize() const noexcept {
+    summary result;
+    std::array<std::uint64_t, bucket_count> counts;
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        result.count += counts[i];
+    }
+    result.total_ns = total_.load(std::memory_order_relaxed);
+    result.max_ns = max_.load(std::memory_order_relaxed);
+    if (result.count == 0) {
+        return result;
+    }
+    // 分位数取所在桶的上界，不超过最大值
+    const auto rank = [&](const std::uint64_t per_mille) {
+        return (std::max<std::uint64_t>)((result.count * per_mille + 999) / 1000, 1);
+    };
+    const std::array<std::pair<std::uint64_t, std::uint64_t *>, 4> targets{{
+        {rank(500), &result.p50_ns},
+        {rank(900), &result.p90_ns},
+        {rank(990), &result.p99_ns},
+        {rank(999), &result.p999_ns},
+    }};
+    std::size_t next = 0;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count && next < targets.size(); ++i) {
+        seen += counts[i];
+        while (next < targets.size() && seen >= targets[next].first) {
+            *targets[next].second = (std::min)(bucket_upper(i), result.max_ns);
+            ++next;
+        }
+    }
+    return result;
+}
+
+void utility::pipeline_metrics::fill(metrics_snapshot &snapshot) const noexcept {
+    for (std::size_t i = 0; i < pipeline_phase_count; ++i) {
+        snapshot.phases[i] = phases_[i].summarize();
+    }
+    for (std::size_t i = 0; i < notification_event_type_count; ++i) {
+        snapshot.events[i] = events_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.shown = counters_[static_cast<std::size_t>(counter::shown)].load(std::memory_order_relaxed);
+    snapshot.show_failures = counters_[static_cast<std::size_t>(counter::show_failures)].load(std::memory_order_relaxed);
+    snapshot.evicted = counters_[static_cast<std::size_t>(counter::evicted)].load(std::memory_order_relaxed);
+    snapshot.expired = counters_[static_cast<std::size_t>(counter::expired)].load(std::memory_order_relaxed);
+}
@@ -0,0 +1,53 @@
+﻿/*
+ * actions_t的标签存放在内联缓冲区中，合计不超过inline_capacity个字符时添加、复制、清空与重新添加都不分配堆内存
+ */
+#include "allocation_counter.hpp"
+#include "test_support.hpp"
+
+using namespace rainy;
+using actions_t = notification_template::actions_t;
+
+int main() {
+    notification_template toast;
+    notification_template other;
+    {
+        const rainy_test::allocation_scope scope;
+        toast.actions.add_action({L"Reply", L"Archive", L"Mark as read", L"Snooze", L"Delete"});
+        RAINY_CHECK(toast.actions.count() == 5);
+        RAINY_CHECK(toast.actions.action_label(2) == L"Mark as read");
+        const auto labels = toast.actions.get_container();
+        RAINY_CHECK(labels[4] == L"Delete");
+        other.actions = toast.actions;
+        RAINY_CHECK(other.actions.count() == 5 && other.actions.action_label(0) == L"Reply");
+        toast.actions.clear();
+        toast.actions.add_action(L"Open");
+        other.actions = std::move(toast.actions);
+        RAINY_CHECK(other.actions.count() == 1 && other.actions.action_label(0) == L"Open");
+        RAINY_CHECK(scope.count() == 0);
+    }
+
+    // 恰好填满内联缓冲区时仍不分配
+    const std::wstring half(actions_t::inline_capacity / 2, L'a');
+    {
+        const rainy_test::allocation_scope scope;
+        other.actions.clear();
+        other.actions.add_action({half, half});
+        RAINY_CHECK(other.actions.count() == 2 && other.actions.action_label(1) == half);
+        RAINY_CHECK(scope.count() == 0);
+    }
+
+    // 超出内联容量时分配一次，此后清空并重新添加复用已分配的存储
+    const std::wstring long_label(actions_t::inline_capacity, L'b');
+    {
+        notification_template large;
+        const rainy_test::allocation_scope scope;
+        large.actions.add_action({long_label, L"More"});
+        RAINY_CHECK(large.actions.count() == 2 && large.actions.action_label(0) == long_label);
+        RAINY_CHECK(scope.count() == 1);
+        large.actions.clear();
+        large.actions.add_action({L"Short", long_label});
+        RAINY_CHECK(large.actions.action_label(1) == long_label);
+        RAINY_CHECK(scope.count() == 1);
+    }
+    return rainy_test::finish("actions_allocation_test");
+}
@@ -0,0 +1,228 @@
+﻿/*
+ * 准入控制：以可注入的时钟确定地检验令牌桶限流、合并窗口与汇总通知，以及被替换的处理器都会收到结束事件
+ */
+#include "test_support.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace rainy;
+using namespace std::chrono_literals;
+using reason = notification_handler::dismissal_reason;
+using event_type = notification_event::event_type;
+
+namespace {
+    struct manual_clock {
+        std::chrono::steady_clock::time_point now{};
+
+        utility::admission_controller::clock_function function() {
+            return [this] { return now; };
+        }
+    };
+
+    struct recorder {
+        int hidden{0};
+        int other_dismissals{0};
+        int failures{0};
+        int activations{0};
+
+        auto handler() {
+            return [this](const notification_event &event) {
+                switch (event.type) {
+                    case event_type::dismissed:
+                        ++(std::get<reason>(event.data) == reason::application_hidden ? hidden : other_dismissals);
+                        break;
+                    case event_type::failed:
+                        ++failures;
+                        break;
+                    default:
+                        ++activations;
+                        break;
+                }
+            };
+        }
+    };
+
+    /**
+     * @brief 第一次显示阻塞到release()后以E_FAIL返回，其余显示立即成功，用于让最初的通知停在显示中
+     */
+    class failing_first_backend final : public notification_backend {
+    public:
+        HRESULT create_notifier(std::wstring_view) override {
+            return S_OK;
+        }
+
+        void release_notifier() noexcept override {
+        }
+
+        platform_capabilities query_capabilities() override {
+            return {true, true, true, true, true};
+        }
+
+        HRESULT show(const toast_request &, event_sink &, std::unique_ptr<toast_handle> &handle) override {
+            std::unique_lock<std::mutex> guard(lock_);
+            if (entered_++ == 0) {
+                changed_.notify_all();
+                changed_.wait(guard, [this] { return released_; });
+                return E_FAIL;
+            }
+            handle = std::make_unique<toast_handle>();
+            return S_OK;
+        }
+
+        HRESULT hide(toast_handle &) override {
+            return S_OK;
+        }
+
+        void wait_first() {
+            std::unique_lock<std::mutex> guard(lock_);
+            changed_.wait(guard, [this] { return entered_ != 0; });
+        }
+
+        void release() {
+            std::lock_guard<std::mutex> guard(lock_);
+            released_ = true;
+            changed_.notify_all();
+        }
+
+    private:
+        std::mutex lock_;
+        std::condition_variable changed_;
+        std::size_t entered_{0};
+        bool released_{false};
+    };
+
+    notification_template keyed(const std::wstring_view line) {
+        notification_template result;
+        result.set_first_line(line);
+        result.coalescing_key(L"chat");
+        return result;
+    }
+
+    void coalescing() {
+        manual_clock clock;
+        auto n = rainy_test::make_notification();
+        auto backend = std::dynamic_pointer_cast<memory_notification_backend>(n->backend());
+        n->set_admission_clock(clock.function());
+        n->set_admission_policy({0.0, 1.0, false, 1000ms});
+
+        recorder first, second, third;
+        const auto id = n->show(keyed(L"first"), first.handler());
+        RAINY_CHECK(id != -1);
+        // 窗口内的同键通知合并到最初的通知，返回相同的ID
+        RAINY_CHECK(n->show(keyed(L"second"), second.handler()) == id);
+        RAINY_CHECK(second.hidden == 0);
+        clock.now += 500ms;
+        RAINY_CHECK(n->show(keyed(L"third"), third.handler()) == id);
+        // 第二条的处理器被第三条替换，不会再有任何事件，因此以application_hidden结束
+        RAINY_CHECK(second.hidden == 1);
+        RAINY_CHECK(backend->visible_count() == 1);
+
+        // 窗口未结束时不汇总
+        n->maintenance();
+        RAINY_CHECK(first.hidden == 0 && backend->visible_count() == 1);
+
+        clock.now += 600ms;
+        n->maintenance();
+        // 最初的通知被汇总通知替换，其处理器以application_hidden结束
+        RAINY_CHECK(first.hidden == 1 && first.other_dismissals == 0);
+        RAINY_CHECK(backend->visible_count() == 1);
+        std::int64_t summary_id = -1;
+        for (const auto &record: backend->records()) {
+            if (record.visible) {
+                summary_id = record.id;
+                RAINY_CHECK(record.xml.find(L"third (+2)") != std::wstring::npos);
+            }
+        }
+        RAINY_CHECK(summary_id != -1 && summary_id != id);
+        // 汇总通知的事件送达最后一个被合并的处理器，且最初通知的平台事件不会再次送达
+        RAINY_CHECK(backend->simulate_activated(summary_id));
+        RAINY_CHECK(third.activations == 1);
+        backend->simulate_dismissed(id, reason::user_canceled);
+        RAINY_CHECK(first.hidden == 1 && first.other_dismissals == 0);
+
+        const auto stats = n->admission_stats();
+        RAINY_CHECK(stats.admitted == 1 && stats.merged == 2 && stats.summaries == 1 && stats.summary_failures == 0);
+        RAINY_CHECK(second.failures + second.activations + second.other_dismissals == 0);
+    }
+
+    void summary_failure() {
+        manual_clock clock;
+        auto n = rainy_test::make_notification();
+        auto backend = std::dynamic_pointer_cast<memory_notification_backend>(n->backend());
+        n->set_admission_clock(clock.function());
+        n->set_admission_policy({0.0, 1.0, false, 1000ms});
+        recorder first, merged;
+        RAINY_CHECK(n->show(keyed(L"first"), first.handler()) != -1);
+        RAINY_CHECK(n->show(keyed(L"merged"), merged.handler()) != -1);
+        clock.now += 2s;
+        backend->inject_show_result(E_FAIL);
+        n->maintenance();
+        // 汇总通知显示失败：处理器收到failed()并计数
+        RAINY_CHECK(first.hidden == 1);
+        RAINY_CHECK(merged.failures == 1);
+        RAINY_CHECK(n->admission_stats().summary_failures == 1);
+        RAINY_CHECK(backend->visible_count() == 0);
+    }
+
+    void pending_window() {
+        auto backend = std::make_shared<failing_first_backend>();
+        auto n = rainy_test::make_notification(backend);
+        n->set_admission_policy({0.0, 1.0, false, 1000ms});
+        recorder first, concurrent;
+        notification_error first_error{};
+        std::int64_t first_id = 0;
+        std::thread shower([&] { first_id = n->show(keyed(L"first"), first.handler(), &first_error); });
+        backend->wait_first();
+        // 最初的通知仍在显示中，同键通知没有可以合并的ID，作为独立的通知放行
+        notification_error error{};
+        const auto id = n->show(keyed(L"concurrent"), concurrent.handler(), &error);
+        RAINY_CHECK(id != -1 && error == notification_error::no_error);
+        backend->release();
+        shower.join();
+        RAINY_CHECK(first_id == -1 && first_error == notification_error::not_displayed);
+        // 最初的通知显示失败时窗口被关闭，放行的通知不受影响
+        RAINY_CHECK(n->active_count() == 1);
+        RAINY_CHECK(concurrent.hidden + concurrent.failures + concurrent.other_dismissals == 0);
+        const auto stats = n->admission_stats();
+        RAINY_CHECK(stats.admitted == 2 && stats.merged == 0);
+        // 之后的同键通知开启新的窗口并正常合并
+        const auto reopened = n->show(keyed(L"reopened"), [](const notification_event &) {});
+        RAINY_CHECK(reopened != -1 && reopened != id);
+        RAINY_CHECK(n->show(keyed(L"merged"), [](const notification_event &) {}) == reopened);
+    }
+
+    void rate_limiting() {
+        manual_clock clock;
+        auto n = rainy_test::make_notification();
+        n->set_admission_clock(clock.function());
+        n->set_admission_policy({2.0, 3.0, false, 0ms});
+        notification_template toast;
+        toast.set_first_line(L"limited");
+        notification_error error{};
+        for (int i = 0; i < 3; ++i) {
+            RAINY_CHECK(n->show(toast, [](const notification_event &) {}, &error) != -1);
+        }
+        RAINY_CHECK(n->show(toast, [](const notification_event &) {}, &error) == -1 && error == notification_error::rate_limited);
+        // 每秒补充2个令牌
+        clock.now += 500ms;
+        RAINY_CHECK(n->show(toast, [](const notification_event &) {}, &error) != -1);
+        RAINY_CHECK(n->show(toast, [](const notification_event &) {}, &error) == -1 && error == notification_error::rate_limited);
+        clock.now += 10s;
+        for (int i = 0; i < 3; ++i) {
+            RAINY_CHECK(n->show(toast, [](const notification_event &) {}, &error) != -1);
+        }
+        RAINY_CHECK(n->show(toast, [](const notification_event &) {}, &error) == -1);
+        const auto stats = n->admission_stats();
+        RAINY_CHECK(stats.admitted == 7 && stats.suppressed == 3);
+    }
+}
+
+int main() {
+    coalescing();
+    summary_failure();
+    pending_window();
+    rate_limiting();
+    return rainy_test::finish("admission_test");
+}
@@ -0,0 +1,84 @@
+﻿/*
+ * 统计当前线程上的全局operator new调用次数，以及全进程尚未释放的分配数。替换全局分配函数，每个可执行文件中只能有一个源文件包含本文件
+ */
+#ifndef RAINY_NOTIFICATION_ALLOCATION_COUNTER_HPP
+#define RAINY_NOTIFICATION_ALLOCATION_COUNTER_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace rainy_test {
+    inline thread_local std::size_t thread_allocations = 0;
+    inline std::atomic<std::ptrdiff_t> live_allocations{0}; // 全部线程上尚未释放的分配数
+
+    /**
+     * @brief 记录构造之后当前线程上发生的分配次数
+     */
+    class allocation_scope {
+    public:
+        allocation_scope() noexcept : start_(thread_allocations) {
+        }
+
+        std::size_t count() const noexcept {
+            return thread_allocations - start_;
+        }
+
+    private:
+        std::size_t start_;
+    };
+}
+
+void *operator new(const std::size_t size) {
+    ++rainy_test::thread_allocations;
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        rainy_test::live_allocations.fetch_add(1, std::memory_order_relaxed);
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](const std::size_t size) {
+    return ::operator new(size);
+}
+
+void *operator new(const std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *operator new[](const std::size_t size, const std::nothrow_t &) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void *memory) noexcept {
+    if (memory) {
+        rainy_test::live_allocations.fetch_sub(1, std::memory_order_relaxed);
+        std::free(memory);
+    }
+}
+
+void operator delete[](void *memory) noexcept {
+    ::operator delete(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    ::operator delete(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept {
+    ::operator delete(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept {
+    ::operator delete(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept {
+    ::operator delete(memory);
+}
+
+#endif
@@ -0,0 +1,201 @@
+﻿/*
+ * show_async的入队延迟，以及队列已满时block、drop_oldest与reject三种背压策略的行为
+ */
+#include "test_support.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace rainy;
+using namespace std::chrono_literals;
+
+namespace {
+    /**
+     * @brief 显示在闸门打开之前一直阻塞的后端，用于让分发线程停在一次显示中，使队列确定地被填满
+     */
+    class gated_backend final : public notification_backend {
+    public:
+        HRESULT create_notifier(std::wstring_view) override {
+            return S_OK;
+        }
+
+        void release_notifier() noexcept override {
+        }
+
+        platform_capabilities query_capabilities() override {
+            return {true, true, true, true, true};
+        }
+
+        HRESULT show(const toast_request &request, event_sink &, std::unique_ptr<toast_handle> &handle) override {
+            std::unique_lock<std::mutex> guard(lock_);
+            ++entered_;
+            changed_.notify_all();
+            changed_.wait(guard, [this] { return open_; });
+            shown_ids.push_back(request.id);
+            handle = std::make_unique<toast_handle>();
+            return S_OK;
+        }
+
+        HRESULT hide(toast_handle &) override {
+            return S_OK;
+        }
+
+        void wait_entered(const std::size_t count) {
+            std::unique_lock<std::mutex> guard(lock_);
+            changed_.wait(guard, [&] { return entered_ >= count; });
+        }
+
+        void open() {
+            std::lock_guard<std::mutex> guard(lock_);
+            open_ = true;
+            changed_.notify_all();
+        }
+
+        std::vector<std::int64_t> shown_ids; // 仅在open()之后读取
+
+    private:
+        std::mutex lock_;
+        std::condition_variable changed_;
+        std::size_t entered_{0};
+        bool open_{false};
+    };
+
+    struct completions {
+        std::mutex lock;
+        std::condition_variable changed;
+        std::vector<std::optional<notification::show_result>> results;
+
+        explicit completions(const std::size_t count) : results(count) {
+        }
+
+        notification::completion_callback at(const std::size_t index) {
+            return [this, index](const notification::show_result &result) {
+                std::lock_guard<std::mutex> guard(lock);
+                results[index] = result;
+                changed.notify_all();
+            };
+        }
+
+        bool done(const std::size_t index) {
+            std::lock_guard<std::mutex> guard(lock);
+            return results[index].has_value();
+        }
+
+        notification_error wait(const std::size_t index) {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&] { return results[index].has_value(); });
+            return results[index]->error;
+        }
+    };
+
+    constexpr std::size_t capacity = 4;
+
+    /**
+     * @brief 分发线程阻塞在第0个请求上，第1至capacity个请求填满队列
+     */
+    std::unique_ptr<notification> saturated(const std::shared_ptr<gated_backend> &backend, const backpressure_policy policy,
+                                            completions &results, const notification_template &toast) {
+        auto n = rainy_test::make_notification(backend);
+        n->set_async_queue_capacity(capacity);
+        n->set_backpressure_policy(policy);
+        auto handler = std::make_shared<rainy_test::null_handler>();
+        n->show_async(toast, handler, results.at(0));
+        backend->wait_entered(1);
+        for (std::size_t i = 1; i <= capacity; ++i) {
+            n->show_async(toast, handler, results.at(i));
+        }
+        return n;
+    }
+
+    void reject_policy(const notification_template &toast) {
+        auto backend = std::make_shared<gated_backend>();
+        completions results(capacity + 2);
+        auto n = saturated(backend, backpressure_policy::reject, results, toast);
+        const auto depth = n->metrics().async_depth;
+        RAINY_CHECK(depth[static_cast<std::size_t>(toast.priority())] == capacity);
+        auto handler = std::make_shared<rainy_test::null_handler>();
+        n->show_async(toast, handler, results.at(capacity + 1));
+        // 被拒绝的请求在调用者线程上立即完成
+        RAINY_CHECK(results.done(capacity + 1) && results.wait(capacity + 1) == notification_error::queue_full);
+        backend->open();
+        for (std::size_t i = 0; i <= capacity; ++i) {
+            RAINY_CHECK(results.wait(i) == notification_error::no_error);
+        }
+    }
+
+    void drop_oldest_policy(const notification_template &toast) {
+        auto backend = std::make_shared<gated_backend>();
+        completions results(capacity + 2);
+        auto n = saturated(backend, backpressure_policy::drop_oldest, results, toast);
+        auto handler = std::make_shared<rainy_test::null_handler>();
+        n->show_async(toast, handler, results.at(capacity + 1));
+        // 队列中最早的请求（第1个）被丢弃，新请求入队
+        RAINY_CHECK(results.done(1) && results.wait(1) == notification_error::queue_full);
+        backend->open();
+        RAINY_CHECK(results.wait(0) == notification_error::no_error);
+        for (std::size_t i = 2; i <= capacity + 1; ++i) {
+            RAINY_CHECK(results.wait(i) == notification_error::no_error);
+        }
+    }
+
+    void block_policy(const notification_template &toast) {
+        auto backend = std::make_shared<gated_backend>();
+        completions results(capacity + 2);
+        auto n = saturated(backend, backpressure_policy::block, results, toast);
+        std::atomic<bool> returned{false};
+        std::thread producer([&] {
+            n->show_async(toast, std::make_shared<rainy_test::null_handler>(), results.at(capacity + 1));
+            returned = true;
+        });
+        std::this_thread::sleep_for(50ms);
+        RAINY_CHECK(!returned.load());
+        RAINY_CHECK(!results.done(capacity + 1));
+        backend->open();
+        producer.join();
+        for (std::size_t i = 0; i <= capacity + 1; ++i) {
+            RAINY_CHECK(results.wait(i) == notification_error::no_error);
+        }
+        RAINY_CHECK(backend->shown_ids.size() == capacity + 2);
+    }
+
+    void enqueue_latency(const notification_template &toast, const std::size_t requests) {
+        auto backend = std::make_shared<rainy_test::counting_backend>();
+        auto n = rainy_test::make_notification(backend);
+        n->set_default_expiration(0ms);
+        n->set_async_queue_capacity(requests);
+        auto handler = std::make_shared<rainy_test::null_handler>();
+        std::atomic<std::size_t> completed{0};
+        // 首次调用启动分发线程并分配队列，不计入样本
+        n->show_async(toast, handler, [&](const notification::show_result &) { completed.fetch_add(1); });
+        std::vector<std::int64_t> samples;
+        samples.reserve(requests);
+        for (std::size_t i = 0; i < requests; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            n->show_async(toast, handler, [&](const notification::show_result &) { completed.fetch_add(1); });
+            samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+        while (completed.load() < requests + 1) {
+            std::this_thread::sleep_for(1ms);
+        }
+        std::sort(samples.begin(), samples.end());
+        const auto p50 = rainy_test::percentile(samples, 0.50);
+        const auto p99 = rainy_test::percentile(samples, 0.99);
+        std::printf("show_async enqueue: p50=%lld ns p99=%lld ns max=%lld ns (%zu requests)\n", static_cast<long long>(p50),
+                    static_cast<long long>(p99), static_cast<long long>(samples.back()), requests);
+        RAINY_CHECK(backend->shows == requests + 1);
+        // 入队只复制模板并推入无锁队列，不等待XML构建与显示
+        RAINY_CHECK(p99 < 2'000'000);
+    }
+}
+
+int main(int argc, char **argv) {
+    notification_template toast;
+    toast.set_first_line(L"async");
+    toast.set_second_line(L"backpressure");
+    reject_policy(toast);
+    drop_oldest_policy(toast);
+    block_policy(toast);
+    enqueue_latency(toast, 20000 * rainy_test::scale(argc, argv));
+    return rainy_test::finish("async_queue_test");
+}
@@ -0,0 +1,58 @@
+﻿/*
+ * 事件回调与退役清理的每事件耗时，不应随仍然存在的通知数量增长
+ */
+#include "test_support.hpp"
+
+using namespace rainy;
+using reason = notification_handler::dismissal_reason;
+
+namespace {
+    double per_event_ns(const std::size_t live, const std::size_t events, const std::size_t rounds) {
+        auto backend = std::make_shared<rainy_test::counting_backend>();
+        auto n = rainy_test::make_notification(backend);
+        n->set_default_expiration(std::chrono::milliseconds(0));
+        n->set_cleanup_batch_size(0); // 清理只在计时区间内发生
+        notification_template toast;
+        toast.set_first_line(L"live");
+        rainy_test::null_handler handler;
+        for (std::size_t i = 0; i < live; ++i) {
+            n->show(toast, handler);
+        }
+        n->set_cleanup_batch_size(events);
+        std::vector<std::int64_t> ids(events);
+        std::vector<double> samples;
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (auto &id: ids) {
+                id = n->show(toast, handler);
+            }
+            auto *sink = backend->sink.load();
+            const auto start = std::chrono::steady_clock::now();
+            for (const auto id: ids) {
+                sink->on_dismissed(id, reason::user_canceled);
+            }
+            while (n->maintenance() != 0) {
+            }
+            samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                              static_cast<double>(events));
+        }
+        RAINY_CHECK(n->active_count() == live);
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::size_t scale = rainy_test::scale(argc, argv);
+    const std::size_t events = 1000;
+    double smallest = 0;
+    double largest = 0;
+    for (const std::size_t live: {std::size_t{100}, std::size_t{10'000}, 100'000 * scale}) {
+        const double cost = per_event_ns(live, events, 15);
+        std::printf("live=%zu: %.1f ns/event (dismiss + drain)\n", live, cost);
+        smallest = smallest == 0 ? cost : (std::min)(smallest, cost);
+        largest = (std::max)(largest, cost);
+    }
+    // 代价应与通知数量无关，规模放大1000倍时每事件耗时只受缓存影响而略有波动。耗时随负载变化，只输出不检查
+    std::printf("largest/smallest: %.2f\n", largest / smallest);
+    return rainy_test::finish("drain_retired_bench");
+}
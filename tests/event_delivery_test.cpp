@@ -0,0 +1,200 @@
+﻿/*
+ * 延迟投递事件：多个线程同时触发时处理器串行执行且保持各线程的触发顺序，队列已满时触发线程阻塞而不空转，
+ * 投递延迟，以及init()之后不能再修改投递方式
+ */
+#include "test_support.hpp"
+
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace rainy;
+using reason = notification_handler::dismissal_reason;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+    constexpr std::size_t threads_count = 8;
+
+    std::unique_ptr<notification> make_deferred(const event_delivery delivery, notification::event_submit_function submit = {}) {
+        auto n = std::make_unique<notification>();
+        n->set_app_name(L"rainy-tests");
+        n->set_aumi(L"rainy.notification.tests");
+        n->set_shortcut_policy(utility::shortcut_policy::ignore);
+        n->set_event_delivery(delivery, std::move(submit));
+        if (!n->init()) {
+            std::fprintf(stderr, "notification::init failed\n");
+            std::exit(2);
+        }
+        return n;
+    }
+
+    memory_notification_backend &memory_backend(notification &n) {
+        return static_cast<memory_notification_backend &>(*n.backend());
+    }
+
+    /**
+     * @brief 每个线程关闭各自的一组通知，处理器记录投递顺序、检测并发执行，并统计从触发到投递的延迟
+     */
+    struct ordering_state {
+        explicit ordering_state(const std::size_t per_thread) :
+            per_thread(per_thread), fired(threads_count * per_thread), latency_ns(threads_count * per_thread) {
+        }
+
+        std::size_t per_thread;
+        std::vector<std::atomic<clock_type::rep>> fired;
+        std::vector<clock_type::rep> latency_ns;
+        std::vector<std::size_t> next = std::vector<std::size_t>(threads_count, 0); // 每个线程下一个应投递的序号
+        std::atomic<bool> in_handler{false};
+        std::atomic<std::size_t> delivered{0};
+        std::size_t out_of_order = 0;
+        std::size_t overlapped = 0;
+    };
+
+    void fire_from_threads(notification &n, ordering_state &state, const std::chrono::nanoseconds handler_cost) {
+        std::vector<std::int64_t> ids(state.fired.size());
+        for (std::size_t index = 0; index < ids.size(); ++index) {
+            notification_template toast;
+            toast.set_first_line(L"ordered");
+            ids[index] = n.show(toast, [&state, index, handler_cost](const notification_event &event) {
+                if (event.type != notification_event::event_type::dismissed) {
+                    return;
+                }
+                if (state.in_handler.exchange(true)) {
+                    ++state.overlapped;
+                }
+                state.latency_ns[index] = clock_type::now().time_since_epoch().count() - state.fired[index].load();
+                const std::size_t thread = index / state.per_thread;
+                if (index % state.per_thread != state.next[thread]++) {
+                    ++state.out_of_order;
+                }
+                const auto until = clock_type::now() + handler_cost;
+                while (clock_type::now() < until) {
+                }
+                state.in_handler.store(false);
+                state.delivered.fetch_add(1, std::memory_order_release);
+            });
+        }
+        auto &backend = memory_backend(n);
+        std::atomic<std::size_t> ready{0};
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads_count; ++t) {
+            workers.emplace_back([&, t] {
+                ready.fetch_add(1);
+                while (ready.load() < threads_count) {
+                }
+                for (std::size_t i = 0; i < state.per_thread; ++i) {
+                    const std::size_t index = t * state.per_thread + i;
+                    state.fired[index].store(clock_type::now().time_since_epoch().count());
+                    backend.simulate_dismissed(ids[index], reason::user_canceled);
+                }
+            });
+        }
+        for (auto &worker: workers) {
+            worker.join();
+        }
+        const auto deadline = clock_type::now() + std::chrono::seconds(30);
+        while (state.delivered.load(std::memory_order_acquire) != state.fired.size() && clock_type::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // 延迟随机器负载变化，只输出不检查；顺序与互斥由各用例检查
+    void report_latency(const char *label, ordering_state &state) {
+        std::vector<clock_type::rep> sorted(state.latency_ns);
+        std::sort(sorted.begin(), sorted.end());
+        const auto p50 = rainy_test::percentile(sorted, 0.5);
+        const auto p99 = rainy_test::percentile(sorted, 0.99);
+        std::printf("%s: %zu events from %zu threads, latency p50=%lld us p99=%lld us\n", label, sorted.size(), threads_count,
+                    static_cast<long long>(p50 / 1000), static_cast<long long>(p99 / 1000));
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::size_t scale = rainy_test::scale(argc, argv);
+
+    // 投递方式只能在init()之前设置
+    {
+        auto n = rainy_test::make_notification();
+        bool rejected = false;
+        try {
+            n->set_event_delivery(event_delivery::event_thread);
+        } catch (const std::logic_error &) {
+            rejected = true;
+        }
+        RAINY_CHECK(rejected);
+    }
+
+    // 廉价的处理器：事件线程跟得上时的顺序与延迟
+    {
+        auto n = make_deferred(event_delivery::event_thread);
+        ordering_state state(2000 * scale);
+        fire_from_threads(*n, state, std::chrono::nanoseconds(0));
+        RAINY_CHECK(state.delivered.load() == state.fired.size());
+        RAINY_CHECK(state.out_of_order == 0);
+        RAINY_CHECK(state.overlapped == 0);
+        report_latency("event_thread", state);
+    }
+
+    // 处理器每次耗时20us：触发速度远超投递速度，队列反复填满，触发线程在阻塞与恢复之间切换时顺序仍然不变
+    {
+        auto n = make_deferred(event_delivery::event_thread);
+        ordering_state state(500 * scale);
+        fire_from_threads(*n, state, std::chrono::microseconds(20));
+        RAINY_CHECK(state.delivered.load() == state.fired.size());
+        RAINY_CHECK(state.out_of_order == 0);
+        RAINY_CHECK(state.overlapped == 0);
+        report_latency("event_thread, slow handler", state);
+    }
+
+    // submit方式下任务暂不执行：队列满后触发线程阻塞，不占用CPU，任务执行后全部事件按序投递
+    {
+        std::mutex lock;
+        std::vector<std::function<void()>> tasks;
+        auto n = make_deferred(event_delivery::submit, [&](std::function<void()> task) {
+            std::lock_guard<std::mutex> guard(lock);
+            tasks.push_back(std::move(task));
+        });
+        constexpr std::size_t events = 1500; // 超过事件队列的容量1024
+        std::vector<std::int64_t> ids(events);
+        std::size_t delivered = 0;
+        std::size_t out_of_order = 0;
+        for (std::size_t i = 0; i < events; ++i) {
+            notification_template toast;
+            toast.set_first_line(L"stalled");
+            ids[i] = n->show(toast, [&, i](const notification_event &) { out_of_order += delivered++ != i ? 1 : 0; });
+        }
+        std::atomic<std::size_t> fired{0};
+        std::thread producer([&] {
+            for (const auto id: ids) {
+                memory_backend(*n).simulate_dismissed(id, reason::timed_out);
+                fired.fetch_add(1);
+            }
+        });
+        while (fired.load() < 1024) {
+            std::this_thread::yield();
+        }
+        const std::clock_t cpu_before = std::clock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const double cpu_ms = 1000.0 * static_cast<double>(std::clock() - cpu_before) / CLOCKS_PER_SEC;
+        std::printf("submit stalled for 200 ms: producer fired %zu of %zu, process cpu %.1f ms\n", fired.load(), events, cpu_ms);
+        RAINY_CHECK(fired.load() < events);
+        RAINY_CHECK(cpu_ms < 100);
+        // 执行任务时唤醒触发线程；它入队的剩余事件可能由新提交的任务投递
+        while (delivered != events) {
+            std::vector<std::function<void()>> pending;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                pending.swap(tasks);
+            }
+            for (auto &task: pending) {
+                task();
+            }
+            std::this_thread::yield();
+        }
+        producer.join();
+        RAINY_CHECK(out_of_order == 0);
+    }
+    return rainy_test::finish("event_delivery_test");
+}
@@ -0,0 +1,115 @@
+﻿/*
+ * hide_group/hide_tag的批量移除：一次平台调用，代价只与组的大小有关。对照逐个hide以及后端不支持按组移除时的退化路径
+ */
+#include "test_support.hpp"
+
+using namespace rainy;
+
+namespace {
+    struct removal_result {
+        double ns_per_group = 0;
+        std::size_t backend_calls = 0;
+    };
+
+    /**
+     * @brief 显示groups组、每组group_size条通知，再按组全部移除
+     * @param mode 0为hide_group，1为逐个hide，2为不支持按组移除的后端上的hide_group
+     */
+    removal_result remove_groups(const std::size_t groups, const std::size_t group_size, const int mode) {
+        auto backend = std::make_shared<rainy_test::counting_backend>();
+        backend->bulk_removal.store(mode != 2);
+        auto n = rainy_test::make_notification(backend);
+        n->set_default_expiration(std::chrono::milliseconds(0));
+        rainy_test::null_handler handler;
+        std::vector<std::wstring> names(groups);
+        std::vector<std::vector<std::int64_t>> ids(groups);
+        for (std::size_t g = 0; g < groups; ++g) {
+            names[g] = L"group" + std::to_wstring(g);
+            notification_template toast;
+            toast.set_first_line(L"grouped");
+            toast.group(names[g]);
+            for (std::size_t i = 0; i < group_size; ++i) {
+                ids[g].push_back(n->show(toast, handler));
+            }
+        }
+        RAINY_CHECK(n->active_count() == groups * group_size);
+        const std::size_t calls_before = backend->hides.load() + backend->history_removals.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t g = 0; g < groups; ++g) {
+            if (mode == 1) {
+                for (const std::int64_t id: ids[g]) {
+                    RAINY_CHECK(n->hide(id));
+                }
+            } else {
+                RAINY_CHECK(n->hide_group(names[g]));
+            }
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        RAINY_CHECK(n->active_count() == 0);
+        removal_result result;
+        result.ns_per_group = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(groups);
+        result.backend_calls = backend->hides.load() + backend->history_removals.load() - calls_before;
+        return result;
+    }
+
+    removal_result remove_tags(const std::size_t count, const bool by_tag) {
+        auto backend = std::make_shared<rainy_test::counting_backend>();
+        auto n = rainy_test::make_notification(backend);
+        n->set_default_expiration(std::chrono::milliseconds(0));
+        rainy_test::null_handler handler;
+        std::vector<std::wstring> tags(count);
+        std::vector<std::int64_t> ids(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            tags[i] = L"tag" + std::to_wstring(i);
+            notification_template toast;
+            toast.set_first_line(L"tagged");
+            toast.tag(tags[i]);
+            toast.group(L"tags");
+            ids[i] = n->show(toast, handler);
+        }
+        const std::size_t calls_before = backend->hides.load() + backend->history_removals.load();
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < count; ++i) {
+            RAINY_CHECK(by_tag ? n->hide_tag(tags[i], L"tags") : n->hide(ids[i]));
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        RAINY_CHECK(n->active_count() == 0);
+        removal_result result;
+        result.ns_per_group = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+        result.backend_calls = backend->hides.load() + backend->history_removals.load() - calls_before;
+        return result;
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::size_t scale = rainy_test::scale(argc, argv);
+    const std::size_t group_size = 1000;
+
+    const removal_result bulk = remove_groups(20 * scale, group_size, 0);
+    const removal_result loop = remove_groups(20 * scale, group_size, 1);
+    const removal_result fallback = remove_groups(20 * scale, group_size, 2);
+    std::printf("hide_group:            %.1f us/group, %zu backend call(s)\n", bulk.ns_per_group / 1000, bulk.backend_calls);
+    std::printf("hide loop:             %.1f us/group, %zu backend call(s)\n", loop.ns_per_group / 1000, loop.backend_calls);
+    std::printf("hide_group (fallback): %.1f us/group, %zu backend call(s)\n", fallback.ns_per_group / 1000, fallback.backend_calls);
+    // 按组移除每组只调用一次后端；不支持时退化为每条通知一次
+    RAINY_CHECK(bulk.backend_calls == 20 * scale);
+    RAINY_CHECK(loop.backend_calls == 20 * scale * group_size);
+    RAINY_CHECK(fallback.backend_calls == 20 * scale * group_size);
+
+    // 每组的代价只与组的大小有关：其他组的数量增加20倍时，与同规模下逐个hide的比值保持不变，差异只来自缓存
+    const removal_result few = remove_groups(5, group_size, 0);
+    const removal_result few_loop = remove_groups(5, group_size, 1);
+    const removal_result many = remove_groups(100 * scale, group_size, 0);
+    const removal_result many_loop = remove_groups(100 * scale, group_size, 1);
+    std::printf("hide_group / hide loop with 5 groups: %.2f, with %zu groups: %.2f\n", few.ns_per_group / few_loop.ns_per_group,
+                100 * scale, many.ns_per_group / many_loop.ns_per_group);
+    RAINY_CHECK(many.ns_per_group < many_loop.ns_per_group * 2);
+    RAINY_CHECK(many.ns_per_group < few.ns_per_group * 5);
+
+    const removal_result tagged = remove_tags(10'000 * scale, true);
+    const removal_result hidden = remove_tags(10'000 * scale, false);
+    std::printf("hide_tag: %.1f ns/toast, hide: %.1f ns/toast\n", tagged.ns_per_group, hidden.ns_per_group);
+    RAINY_CHECK(tagged.backend_calls == 10'000 * scale);
+    RAINY_CHECK(hidden.backend_calls == 10'000 * scale);
+    return rainy_test::finish("group_removal_bench");
+}
@@ -0,0 +1,138 @@
+﻿/*
+ * 事件处理器的构造与分发：internals::inline_handler对照以前的make_shared<callable_handler>加虚函数调用，
+ * 以前每次分发都要从注册表中复制一份shared_ptr
+ */
+#include "allocation_counter.hpp"
+#include "test_support.hpp"
+
+#include <thread>
+
+using namespace rainy;
+using reason = notification_handler::dismissal_reason;
+
+namespace {
+    struct counting_callable {
+        std::size_t *events; // 按事件类型计数，激活参数的解析结果因此不会被优化掉
+
+        void operator()(const notification_event &event) const {
+            ++events[static_cast<std::size_t>(event.type)];
+        }
+    };
+
+    struct counting_handler final : notification_handler {
+        void activated() const override {
+        }
+
+        void activated(int) const override {
+        }
+
+        void activated(const std::wstring_view) const override {
+        }
+
+        void dismissed(dismissal_reason) const override {
+            ++events;
+        }
+
+        void failed() const override {
+        }
+
+        mutable std::size_t events = 0;
+    };
+}
+
+int main(int argc, char **argv) {
+    // 启动过线程后libstdc++的shared_ptr引用计数使用原子操作，与真实的多线程进程一致
+    std::thread([] {}).join();
+    const std::size_t handlers = 1024;
+    const std::size_t rounds = 100 * rainy_test::scale(argc, argv);
+    const std::size_t operations = handlers * rounds;
+    std::size_t events[5] = {};
+    const counting_callable callable{events};
+    const activation click{L"action=1;", {}};
+
+    std::vector<internals::inline_handler> inline_slots(handlers);
+    std::vector<std::shared_ptr<notification_handler>> shared_slots(handlers);
+    std::size_t inline_allocations = 0;
+    std::size_t shared_allocations = 0;
+    const double inline_make = rainy_test::median_ns(9, handlers, [&] {
+        const rainy_test::allocation_scope scope;
+        for (auto &slot: inline_slots) {
+            slot = internals::inline_handler::from_callable(callable);
+        }
+        inline_allocations = scope.count();
+    });
+    const double shared_make = rainy_test::median_ns(9, handlers, [&] {
+        const rainy_test::allocation_scope scope;
+        for (auto &slot: shared_slots) {
+            slot = std::make_shared<internals::callable_handler<counting_callable>>(counting_callable{callable});
+        }
+        shared_allocations = scope.count();
+    });
+    std::printf("construct:            inline %.1f ns (%zu allocations), shared_ptr %.1f ns (%zu allocations)\n", inline_make,
+                inline_allocations, shared_make, shared_allocations);
+    RAINY_CHECK(inline_allocations == 0);
+    RAINY_CHECK(shared_allocations == handlers);
+
+    const double inline_dismissed = rainy_test::median_ns(9, operations, [&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (const auto &slot: inline_slots) {
+                slot.dismissed(reason::user_canceled);
+            }
+        }
+    });
+    const double shared_dismissed = rainy_test::median_ns(9, operations, [&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (const auto &slot: shared_slots) {
+                const std::shared_ptr<notification_handler> handler = slot;
+                handler->dismissed(reason::user_canceled);
+            }
+        }
+    });
+    const double inline_activated = rainy_test::median_ns(9, operations, [&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (const auto &slot: inline_slots) {
+                slot.activated(click);
+            }
+        }
+    });
+    const double shared_activated = rainy_test::median_ns(9, operations, [&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (const auto &slot: shared_slots) {
+                const std::shared_ptr<notification_handler> handler = slot;
+                handler->activated(click);
+            }
+        }
+    });
+    std::printf("callable dismissed:   inline %.1f ns, shared_ptr %.1f ns\n", inline_dismissed, shared_dismissed);
+    std::printf("callable activated:   inline %.1f ns, shared_ptr %.1f ns\n", inline_activated, shared_activated);
+    RAINY_CHECK(events[static_cast<std::size_t>(notification_event::event_type::dismissed)] == 18 * operations);
+    RAINY_CHECK(events[static_cast<std::size_t>(notification_event::event_type::activated_with_action_idx)] == 18 * operations);
+
+    // 继承自notification_handler的处理器：借用时直接调用虚函数
+    const auto handler = std::make_shared<counting_handler>();
+    std::vector<internals::inline_handler> borrowed(handlers);
+    for (std::size_t i = 0; i < handlers; ++i) {
+        borrowed[i] = internals::inline_handler::borrow(*handler);
+        shared_slots[i] = handler;
+    }
+    const double borrowed_dismissed = rainy_test::median_ns(9, operations, [&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (const auto &slot: borrowed) {
+                slot.dismissed(reason::user_canceled);
+            }
+        }
+    });
+    const double handler_dismissed = rainy_test::median_ns(9, operations, [&] {
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (const auto &slot: shared_slots) {
+                const std::shared_ptr<notification_handler> copy = slot;
+                copy->dismissed(reason::user_canceled);
+            }
+        }
+    });
+    std::printf("handler dismissed:    borrowed %.1f ns, shared_ptr %.1f ns\n", borrowed_dismissed, handler_dismissed);
+    RAINY_CHECK(handler->events == 18 * operations);
+    // 共享同一个处理器时，每次复制shared_ptr都在同一个引用计数上做原子操作，内联分发没有这部分开销
+    RAINY_CHECK(borrowed_dismissed < handler_dismissed);
+    return rainy_test::finish("handler_dispatch_bench");
+}
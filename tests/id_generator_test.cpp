@@ -0,0 +1,65 @@
+﻿/*
+ * id_generator：同时存在的实例之间ID不冲突，实例标签在析构后被复用而不会与仍存在的实例重复
+ */
+#include "test_support.hpp"
+
+#include <thread>
+
+using namespace rainy;
+
+int main(int argc, char **argv) {
+    // 标签复用：长期存在的实例不会因为其后创建、销毁了大量实例而与新实例共享标签
+    {
+        const utility::id_generator long_lived;
+        bool distinct = true;
+        for (int i = 0; i < 40000; ++i) {
+            const utility::id_generator transient;
+            distinct = distinct && transient.tag() != long_lived.tag();
+        }
+        RAINY_CHECK(distinct);
+        std::vector<std::unique_ptr<utility::id_generator>> alive;
+        std::vector<bool> seen(std::size_t{1} << 15);
+        for (int i = 0; i < 1000; ++i) {
+            alive.push_back(std::make_unique<utility::id_generator>());
+            const auto tag = static_cast<std::size_t>(alive.back()->tag());
+            distinct = distinct && !seen[tag] && tag != long_lived.tag();
+            seen[tag] = true;
+        }
+        RAINY_CHECK(distinct);
+    }
+
+    // 多线程生成1000万个ID：每个线程各有一个实例，另有一个实例被所有线程共享
+    constexpr std::size_t threads_count = 8;
+    const std::size_t per_thread = 10'000'000 / threads_count * (std::min)(rainy_test::scale(argc, argv), std::size_t{4});
+    utility::id_generator shared;
+    std::vector<std::vector<std::int64_t>> produced(threads_count);
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads_count; ++t) {
+        workers.emplace_back([&, t] {
+            utility::id_generator own;
+            auto &ids = produced[t];
+            ids.reserve(per_thread);
+            for (std::size_t i = 0; i < per_thread; ++i) {
+                ids.push_back(i % 2 == 0 ? own.next() : shared.next());
+            }
+        });
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+    std::vector<std::int64_t> all;
+    all.reserve(per_thread * threads_count);
+    bool positive = true;
+    for (const auto &ids: produced) {
+        for (const auto id: ids) {
+            positive = positive && id > 0;
+        }
+        all.insert(all.end(), ids.begin(), ids.end());
+    }
+    produced.clear();
+    std::sort(all.begin(), all.end());
+    RAINY_CHECK(positive);
+    RAINY_CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+    std::printf("%zu ids from %zu threads, no collisions\n", all.size(), threads_count);
+    return rainy_test::finish("id_generator_test");
+}
@@ -0,0 +1,103 @@
+﻿/*
+ * memory_notification_backend上的端到端流程：显示、激活、数据绑定更新、分组移除、Tag替换、失败注入与静态模板
+ */
+#include "test_support.hpp"
+
+using namespace rainy;
+using event_type = notification_event::event_type;
+using reason = notification_handler::dismissal_reason;
+
+int main() {
+    auto n = rainy_test::make_notification();
+    auto backend = std::dynamic_pointer_cast<memory_notification_backend>(n->backend());
+    RAINY_CHECK(backend && backend->aumi() == L"rainy.notification.tests");
+    if (!backend) {
+        return rainy_test::finish("memory_backend_test");
+    }
+
+    notification_template text(notification_template_type::text02);
+    text.set_first_line(L"Hello & bye");
+    text.set_second_line(L"x");
+    text.actions.add_action({L"Yes", L"No"});
+    int action = -1;
+    bool dismissed = false;
+    const auto id = n->show(text, [&](const notification_event &event) {
+        if (event.type == event_type::activated_with_action_idx) {
+            action = std::get<int>(event.data);
+        }
+        if (event.type == event_type::dismissed) {
+            dismissed = true;
+        }
+    });
+    RAINY_CHECK(id != -1);
+    auto record = backend->find(id);
+    RAINY_CHECK(record && record->visible);
+    RAINY_CHECK(record && record->xml.find(L"Hello &amp; bye") != std::wstring::npos);
+    RAINY_CHECK(backend->simulate_activated(id, L"action=1;") && action == 1);
+
+    // 数据绑定更新会递增序号
+    notification_template progress;
+    progress.set_first_line(L"download");
+    progress.progress_bar(L"{v}", L"{s}");
+    progress.bind(L"v", L"0");
+    progress.bind(L"s", L"start");
+    const auto progress_id = n->show(progress, [](const notification_event &) {});
+    RAINY_CHECK(progress_id != -1);
+    RAINY_CHECK(n->update(progress_id, {{L"v", L"0.5"}}));
+    record = backend->find(progress_id);
+    RAINY_CHECK(record && record->sequence == 2 && !record->data.empty() && record->data[0].value == L"0.5");
+
+    // 分组
+    notification_template grouped;
+    grouped.set_first_line(L"g");
+    grouped.group(L"chat");
+    for (int i = 0; i < 3; ++i) {
+        RAINY_CHECK(n->show(grouped, [](const notification_event &) {}) != -1);
+    }
+    RAINY_CHECK(backend->visible_count() == 4);
+    RAINY_CHECK(n->hide_group(L"chat"));
+    RAINY_CHECK(backend->visible_count() == 1);
+
+    // Tag替换：新通知显示失败时旧通知仍在屏幕上，保持登记；显示成功后旧通知的处理器以application_hidden结束
+    notification_template tagged;
+    tagged.set_first_line(L"t");
+    tagged.tag(L"t");
+    std::optional<reason> replaced;
+    const auto old_id = n->show(tagged, [&](const notification_event &event) {
+        if (event.type == event_type::dismissed) {
+            replaced = std::get<reason>(event.data);
+        }
+    });
+    RAINY_CHECK(old_id != -1);
+    const std::size_t live = n->live_count();
+    notification_error error{};
+    backend->inject_show_result(E_FAIL);
+    RAINY_CHECK(n->show(tagged, [](const notification_event &) {}, &error) == -1 && error == notification_error::not_displayed);
+    record = backend->find(old_id);
+    RAINY_CHECK(record && record->visible && !replaced);
+    RAINY_CHECK(n->live_count() == live);
+    // 达到数量上限时，被替换的通知让出名额，不驱逐其他通知
+    n->set_live_limit(live);
+    const auto new_id = n->show(tagged, [](const notification_event &) {}, &error);
+    RAINY_CHECK(new_id != -1 && error == notification_error::no_error);
+    RAINY_CHECK(replaced == reason::application_hidden);
+    RAINY_CHECK(n->live_count() == live && backend->visible_count() == live);
+    RAINY_CHECK(n->hide_tag(L"t"));
+    record = backend->find(new_id);
+    RAINY_CHECK(record && !record->visible);
+    n->set_live_limit(0);
+
+    // 静态模板、失败注入与关闭
+    static_notification_template<notification_template_type::text01> fixed;
+    fixed.set_line<0>(L"s");
+    backend->inject_show_result(E_FAIL);
+    RAINY_CHECK(n->show(fixed, [](const notification_event &) {}, &error) == -1 && error == notification_error::not_displayed);
+    const auto fixed_id = n->show(fixed, [&](const notification_event &event) { dismissed = event.type == event_type::dismissed; });
+    RAINY_CHECK(backend->simulate_dismissed(fixed_id, notification_handler::dismissal_reason::timed_out) && dismissed);
+
+    RAINY_CHECK(n->show_async(text, [](const notification_event &) {}).get().id != -1);
+    n->clear();
+    RAINY_CHECK(backend->visible_count() == 0);
+    RAINY_CHECK(!backend->simulate_failed(id));
+    return rainy_test::finish("memory_backend_test");
+}
@@ -0,0 +1,62 @@
+﻿/*
+ * 插桩开销：同一份源码分别在启用与定义RAINY_NOTIFICATION_NO_METRICS时构建（metrics_overhead_bench与metrics_overhead_bench_off），
+ * 对比两者输出的show+hide与激活投递耗时即为计时与计数的代价
+ */
+#include "test_support.hpp"
+
+using namespace rainy;
+
+int main(int argc, char **argv) {
+    const std::size_t iterations = 5000 * rainy_test::scale(argc, argv);
+    constexpr std::size_t rounds = 9;
+    constexpr bool enabled = RAINY_NOTIFICATION_METRICS != 0;
+    const char *const variant = enabled ? "metrics on" : "metrics off";
+
+    notification_template toast;
+    toast.set_first_line(L"metrics");
+    toast.set_second_line(L"instrumentation overhead");
+    rainy_test::null_handler handler;
+
+    {
+        auto backend = std::make_shared<rainy_test::counting_backend>();
+        auto n = rainy_test::make_notification(backend);
+        const double per_toast = rainy_test::median_ns(rounds, iterations, [&] {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                n->hide(n->show(toast, handler));
+            }
+        });
+        RAINY_CHECK(backend->shows == rounds * iterations);
+
+        const auto metrics = n->metrics();
+        RAINY_CHECK(metrics.enabled == enabled);
+        RAINY_CHECK(metrics.shown == (enabled ? rounds * iterations : 0));
+        RAINY_CHECK(metrics.phase(utility::pipeline_phase::total).count == (enabled ? rounds * iterations : 0));
+        RAINY_CHECK(metrics.live == 0);
+        std::printf("%s: show+hide %.1f ns/toast\n", variant, per_toast);
+    }
+
+    {
+        auto n = rainy_test::make_notification();
+        auto &backend = static_cast<memory_notification_backend &>(*n->backend());
+        std::vector<std::int64_t> ids(iterations);
+        std::size_t activations = 0;
+        const double per_event = rainy_test::median_ns(rounds, iterations, [&] {
+            for (auto &id: ids) {
+                id = n->show(toast, handler);
+            }
+            for (const auto id: ids) {
+                activations += backend.simulate_activated(id);
+            }
+            for (const auto id: ids) {
+                n->hide(id);
+            }
+        });
+        RAINY_CHECK(activations == rounds * iterations);
+
+        const auto metrics = n->metrics();
+        RAINY_CHECK(metrics.enabled == enabled);
+        RAINY_CHECK(metrics.event_count(notification_event::event_type::activated) == (enabled ? activations : 0));
+        std::printf("%s: show+activate+hide %.1f ns/toast\n", variant, per_event);
+    }
+    return rainy_test::finish(enabled ? "metrics_overhead_bench" : "metrics_overhead_bench_off");
+}
@@ -0,0 +1,286 @@
+﻿/*
+ * 通知优先级：达到活动上限时的驱逐顺序、计划通知到期时保留优先级、show_async按优先级出队的顺序，以及低优先级洪峰下高优先级通知的延迟（只输出）
+ */
+#include "test_support.hpp"
+
+#include <mutex>
+#include <thread>
+
+using namespace rainy;
+using priority_t = notification_template::priority_t;
+using reason = notification_handler::dismissal_reason;
+using event_type = notification_event::event_type;
+
+namespace {
+    /**
+     * @brief 每次show忙等200us的内存后端，模拟较慢的平台调用。hold()之后的显示阻塞到release()，用于让请求确定地积压在队列中
+     */
+    class slow_backend final : public notification_backend {
+    public:
+        HRESULT create_notifier(std::wstring_view aumi) override {
+            return inner.create_notifier(aumi);
+        }
+
+        void release_notifier() noexcept override {
+            inner.release_notifier();
+        }
+
+        platform_capabilities query_capabilities() override {
+            return inner.query_capabilities();
+        }
+
+        HRESULT show(const toast_request &request, event_sink &sink, std::unique_ptr<toast_handle> &handle) override {
+            if (held_.load()) {
+                entered_ = true;
+                entered_.notify_all();
+                held_.wait(true);
+            }
+            const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(200);
+            while (std::chrono::steady_clock::now() < until) {
+            }
+            return inner.show(request, sink, handle);
+        }
+
+        HRESULT hide(toast_handle &handle) override {
+            return inner.hide(handle);
+        }
+
+        void hold() {
+            held_ = true;
+        }
+
+        void wait_entered() {
+            entered_.wait(false);
+        }
+
+        void release() {
+            held_ = false;
+            held_.notify_all();
+        }
+
+        memory_notification_backend inner;
+
+    private:
+        std::atomic<bool> held_{false};
+        std::atomic<bool> entered_{false};
+    };
+
+    std::unique_ptr<notification> make_slow(const std::shared_ptr<slow_backend> &backend) {
+        auto n = std::make_unique<notification>();
+        n->set_app_name(L"rainy-tests");
+        n->set_aumi(L"rainy.notification.tests");
+        n->set_shortcut_policy(utility::shortcut_policy::ignore);
+        n->set_backend(backend);
+        n->set_async_queue_capacity(1 << 14);
+        RAINY_CHECK(n->init());
+        return n;
+    }
+
+    struct hidden_counter final : notification_handler {
+        void activated() const override {
+        }
+
+        void activated(int) const override {
+        }
+
+        void activated(const std::wstring_view) const override {
+        }
+
+        void dismissed(dismissal_reason state) const override {
+            hidden += state == dismissal_reason::application_hidden ? 1 : 0;
+        }
+
+        void failed() const override {
+        }
+
+        mutable int hidden = 0;
+    };
+
+    void eviction_order() {
+        auto n = rainy_test::make_notification();
+        auto backend = std::dynamic_pointer_cast<memory_notification_backend>(n->backend());
+        n->set_live_limit(4);
+        std::vector<int> hidden(16, 0);
+        std::vector<int> other(16, 0);
+        const auto show = [&](const int k, const priority_t priority) {
+            notification_template toast;
+            toast.set_first_line(L"live");
+            toast.priority(priority);
+            notification_error error = notification_error::no_error;
+            const auto id = n->show(
+                toast,
+                [&, k](const notification_event &event) {
+                    if (event.type == event_type::dismissed && std::get<reason>(event.data) == reason::application_hidden) {
+                        ++hidden[k];
+                    } else {
+                        ++other[k];
+                    }
+                },
+                &error);
+            return std::pair{id, error};
+        };
+        const auto a0 = show(0, priority_t::low);
+        const auto a1 = show(1, priority_t::normal);
+        show(2, priority_t::low);
+        const auto a3 = show(3, priority_t::high);
+        RAINY_CHECK(n->live_count() == 4 && backend->visible_count() == 4);
+        // 驱逐优先级最低的通知中最早显示的一个
+        RAINY_CHECK(show(4, priority_t::normal).second == notification_error::no_error);
+        RAINY_CHECK(hidden[0] == 1 && n->live_count() == 4 && backend->visible_count() == 4);
+        RAINY_CHECK(show(5, priority_t::low).second == notification_error::no_error && hidden[2] == 1);
+        show(6, priority_t::low);
+        RAINY_CHECK(hidden[5] == 1);
+        show(7, priority_t::high);
+        RAINY_CHECK(hidden[6] == 1);
+        // 此时为1(normal)、3(high)、4(normal)、7(high)，低优先级的通知无可驱逐
+        const auto a8 = show(8, priority_t::low);
+        RAINY_CHECK(a8.first == -1 && a8.second == notification_error::live_limit_reached);
+        RAINY_CHECK(show(9, priority_t::normal).first != -1 && hidden[1] == 1);
+        // 已被驱逐的通知随后到达的平台事件不再回报
+        backend->simulate_dismissed(a0.first, reason::user_canceled);
+        backend->simulate_activated(a1.first);
+        RAINY_CHECK(hidden[0] == 1 && other[0] == 0 && other[1] == 0);
+        // hide与激活释放名额，不驱逐其他通知
+        RAINY_CHECK(n->hide(a3.first));
+        const auto a10 = show(10, priority_t::low);
+        RAINY_CHECK(a10.first != -1 && hidden[4] == 0 && n->live_count() == 4);
+        backend->simulate_activated(a10.first);
+        RAINY_CHECK(n->live_count() == 3 && other[10] == 1);
+        // 批量显示同样遵守上限
+        std::vector<notification_template> batch(6);
+        for (auto &toast: batch) {
+            toast.set_first_line(L"batch");
+            toast.priority(priority_t::high);
+        }
+        n->show_batch(batch, std::make_shared<hidden_counter>());
+        RAINY_CHECK(n->live_count() == 4 && backend->visible_count() == 4);
+        n->set_live_limit(0);
+        for (int i = 0; i < 100; ++i) {
+            RAINY_CHECK(show(11, priority_t::low).first != -1);
+        }
+        RAINY_CHECK(n->live_count() == 104);
+    }
+
+    void scheduled_priority() {
+        auto n = rainy_test::make_notification();
+        auto backend = std::dynamic_pointer_cast<memory_notification_backend>(n->backend());
+        auto now = std::chrono::steady_clock::time_point{} + std::chrono::hours(1);
+        n->set_schedule_clock([&now] { return now; });
+        n->set_live_limit(1);
+        notification_template live;
+        live.set_first_line(L"live");
+        live.priority(priority_t::high);
+        rainy_test::null_handler handler;
+        const auto shown = n->show(live, handler);
+        notification_template later;
+        later.set_first_line(L"later");
+        later.priority(priority_t::high);
+        const auto scheduled = n->schedule(later, now + std::chrono::seconds(10), [](const notification_event &) {});
+        RAINY_CHECK(shown != -1 && scheduled != -1);
+        now += std::chrono::seconds(10);
+        RAINY_CHECK(n->run_due_schedules() == 1);
+        // 到期时以计划时的优先级提交：高优先级可以驱逐同为高优先级的通知
+        const auto record = backend->find(scheduled);
+        RAINY_CHECK(record && record->visible && record->priority == priority_t::high);
+        const auto evicted = backend->find(shown);
+        RAINY_CHECK(evicted && !evicted->visible);
+        RAINY_CHECK(n->live_count() == 1);
+    }
+
+    void dispatch_order() {
+        auto backend = std::make_shared<slow_backend>();
+        auto n = make_slow(backend);
+        notification_template low;
+        low.set_first_line(L"low");
+        low.priority(priority_t::low);
+        notification_template high;
+        high.set_first_line(L"high");
+        high.priority(priority_t::high);
+        const auto handler = std::make_shared<hidden_counter>();
+        std::mutex lock;
+        std::vector<std::size_t> order;
+        const auto record = [&](const std::size_t index) {
+            return [&, index](const notification::show_result &result) {
+                RAINY_CHECK(result.error == notification_error::no_error);
+                std::lock_guard<std::mutex> guard(lock);
+                order.push_back(index);
+            };
+        };
+        // 分发线程停在第0个请求上，其余请求全部积压后再放行，完成顺序与时间无关
+        backend->hold();
+        n->show_async(low, handler, record(0));
+        backend->wait_entered();
+        constexpr std::size_t total = 200;
+        for (std::size_t i = 1; i < total; ++i) {
+            n->show_async(i % 50 == 25 ? high : low, handler, record(i));
+        }
+        backend->release();
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (order.size() == total) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // 正在显示的请求之后，高优先级请求先于排在它们之前的低优先级请求完成，同一优先级内保持入队顺序
+        const std::vector<std::size_t> highs{25, 75, 125, 175};
+        RAINY_CHECK(order.front() == 0);
+        RAINY_CHECK(std::equal(highs.begin(), highs.end(), order.begin() + 1));
+        RAINY_CHECK(std::is_sorted(order.begin() + 1 + static_cast<std::ptrdiff_t>(highs.size()), order.end()));
+    }
+
+    void high_priority_latency() {
+        auto n = make_slow(std::make_shared<slow_backend>());
+        std::mutex lock;
+        std::vector<double> high_ms;
+        std::vector<double> low_ms;
+        std::size_t failures = 0;
+        notification_template low;
+        low.set_first_line(L"low");
+        low.priority(priority_t::low);
+        notification_template high;
+        high.set_first_line(L"high");
+        high.priority(priority_t::high);
+        const auto handler = std::make_shared<hidden_counter>();
+        constexpr std::size_t total = 8000;
+        for (std::size_t i = 0; i < total; ++i) {
+            const bool is_high = i % 100 == 50;
+            const auto start = std::chrono::steady_clock::now();
+            n->show_async(is_high ? high : low, handler, [&, start, is_high](const notification::show_result &result) {
+                const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::lock_guard<std::mutex> guard(lock);
+                failures += result.error == notification_error::no_error ? 0 : 1;
+                (is_high ? high_ms : low_ms).push_back(ms);
+            });
+            if (i % 100 == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (high_ms.size() + low_ms.size() == total) {
+                    break;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::sort(high_ms.begin(), high_ms.end());
+        std::sort(low_ms.begin(), low_ms.end());
+        std::printf("show_async under a low-priority flood: high p50=%.2f ms p99=%.2f ms (%zu), low p50=%.2f ms p99=%.2f ms (%zu)\n",
+                    rainy_test::percentile(high_ms, 0.5), rainy_test::percentile(high_ms, 0.99), high_ms.size(),
+                    rainy_test::percentile(low_ms, 0.5), rainy_test::percentile(low_ms, 0.99), low_ms.size());
+        // 低优先级请求积压数百毫秒，高优先级请求只需等待正在执行的一次show。耗时随负载变化，顺序由dispatch_order检查
+        RAINY_CHECK(failures == 0);
+    }
+}
+
+int main() {
+    eviction_order();
+    scheduled_priority();
+    dispatch_order();
+    high_priority_latency();
+    return rainy_test::finish("priority_test");
+}
@@ -0,0 +1,121 @@
+﻿/*
+ * notification_registry与notification在多线程下插入同一ID：每个ID只能插入成功一次，其余插入报告重复
+ */
+#include "test_support.hpp"
+
+#include <thread>
+
+using namespace rainy;
+
+namespace {
+    constexpr int threads_count = 8;
+
+    struct counted {
+        explicit counted(const int owner) noexcept : owner(owner) {
+        }
+
+        int owner;
+    };
+
+    void registry_duplicates(const std::int64_t ids) {
+        utility::notification_registry<counted> registry(16); // 从很小的容量开始，让插入与扩容交错
+        std::vector<std::atomic<int>> wins(static_cast<std::size_t>(ids));
+        std::atomic<int> ready{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads_count; ++t) {
+            workers.emplace_back([&, t] {
+                ready.fetch_add(1);
+                while (ready.load() < threads_count) {
+                }
+                // 一半线程正序、一半倒序插入，使同一ID上的竞争集中发生
+                for (std::int64_t i = 0; i < ids; ++i) {
+                    const std::int64_t id = t % 2 == 0 ? i : ids - 1 - i;
+                    if (registry.emplace(id, t)) {
+                        wins[static_cast<std::size_t>(id)].fetch_add(1);
+                    }
+                }
+            });
+        }
+        for (auto &worker: workers) {
+            worker.join();
+        }
+        bool exactly_once = true;
+        for (auto &win: wins) {
+            exactly_once = exactly_once && win.load() == 1;
+        }
+        RAINY_CHECK(exactly_once);
+        RAINY_CHECK(registry.size() == static_cast<std::size_t>(ids));
+        std::size_t visited = 0;
+        registry.for_each([&](std::int64_t, counted &) { ++visited; });
+        RAINY_CHECK(visited == static_cast<std::size_t>(ids));
+    }
+
+    void registry_reinsert(const std::int64_t ids) {
+        // 移除与重新插入交错进行时，同一ID在任意时刻至多存在一个条目
+        utility::notification_registry<counted> registry(16);
+        std::atomic<int> violations{0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads_count; ++t) {
+            workers.emplace_back([&, t] {
+                for (int round = 0; round < 200; ++round) {
+                    for (std::int64_t id = 0; id < ids; ++id) {
+                        if (registry.emplace(id, t)) {
+                            registry.visit(id, [&](counted &entry) { violations.fetch_add(entry.owner != t); });
+                            registry.erase_if(id, [t](const counted &entry) { return entry.owner == t; });
+                        }
+                    }
+                }
+            });
+        }
+        for (auto &worker: workers) {
+            worker.join();
+        }
+        RAINY_CHECK(violations.load() == 0);
+        RAINY_CHECK(registry.size() == 0);
+    }
+
+    void notification_duplicates(const std::int64_t ids) {
+        // 生成的ID是实例标签与递增计数的组合，调用者的ID取在计数不会到达的范围，使重复只来自调用者之间
+        constexpr std::int64_t caller_base = std::int64_t{1} << 40;
+        auto backend = std::make_shared<rainy_test::counting_backend>();
+        auto n = rainy_test::make_notification(backend);
+        n->set_default_expiration(std::chrono::milliseconds(0));
+        std::atomic<int> shown{0};
+        std::atomic<int> duplicates{0};
+        std::atomic<int> generated{0};
+        rainy_test::null_handler handler;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads_count; ++t) {
+            workers.emplace_back([&, t] {
+                notification_template toast;
+                toast.set_first_line(L"stress");
+                for (std::int64_t i = 0; i < ids; ++i) {
+                    toast.id(caller_base + (t % 2 == 0 ? i : ids - 1 - i));
+                    notification_error error{};
+                    if (n->show(toast, handler, &error) != -1) {
+                        shown.fetch_add(1);
+                    } else if (error == notification_error::duplicate_id) {
+                        duplicates.fetch_add(1);
+                    }
+                    // 生成的ID与调用者指定的ID同时插入
+                    toast.id(-1);
+                    generated.fetch_add(n->show(toast, handler) != -1);
+                }
+            });
+        }
+        for (auto &worker: workers) {
+            worker.join();
+        }
+        RAINY_CHECK(shown.load() == ids);
+        RAINY_CHECK(duplicates.load() == ids * (threads_count - 1));
+        RAINY_CHECK(generated.load() == ids * threads_count);
+        RAINY_CHECK(n->active_count() == static_cast<std::size_t>(ids + ids * threads_count));
+    }
+}
+
+int main() {
+    registry_duplicates(20000);
+    registry_reinsert(64);
+    notification_duplicates(2000);
+    return rainy_test::finish("registry_stress_test");
+}
@@ -0,0 +1,171 @@
+﻿/*
+ * shortcut_cache在假文件系统上的行为：探测、记录与比对状态，损坏或不兼容的状态文件，文件系统失败，以及std_file_system的读写
+ */
+#include "test_support.hpp"
+
+#include <filesystem>
+#include <map>
+
+using namespace rainy;
+using utility::shortcut_cache;
+using utility::shortcut_state;
+
+namespace {
+    /**
+     * @brief 内存中的文件系统，统计各操作的调用次数，并可让读写失败
+     */
+    class fake_file_system final : public utility::file_system {
+    public:
+        struct file {
+            std::string contents;
+            std::int64_t write_time;
+        };
+
+        std::optional<std::int64_t> last_write_time(std::wstring_view path) override {
+            ++stats;
+            const auto found = files.find(std::wstring{path});
+            return found == files.end() ? std::nullopt : std::optional<std::int64_t>{found->second.write_time};
+        }
+
+        bool read_file(std::wstring_view path, std::string &contents) override {
+            ++reads;
+            const auto found = files.find(std::wstring{path});
+            if (fail_reads || found == files.end()) {
+                return false;
+            }
+            contents = found->second.contents;
+            return true;
+        }
+
+        bool write_file(std::wstring_view path, std::string_view contents) override {
+            ++writes;
+            if (fail_writes) {
+                return false;
+            }
+            files[std::wstring{path}] = {std::string{contents}, ++clock};
+            return true;
+        }
+
+        void touch(const std::wstring &path) {
+            files[path].write_time = ++clock;
+        }
+
+        std::map<std::wstring, file> files;
+        std::int64_t clock = 1000;
+        std::size_t stats = 0;
+        std::size_t reads = 0;
+        std::size_t writes = 0;
+        bool fail_reads = false;
+        bool fail_writes = false;
+    };
+
+    constexpr wchar_t link_path[] = L"C:\\Start Menu\\rainy.lnk";
+    constexpr wchar_t state_path[] = L"C:\\state\\rainy.shortcut";
+    constexpr wchar_t executable[] = L"C:\\bin\\rainy.exe";
+
+    std::optional<shortcut_state> probe(const shortcut_cache &cache) {
+        return cache.probe(L"rainy", L"rainy.notification.tests", executable, link_path);
+    }
+}
+
+int main() {
+    auto fs = std::make_shared<fake_file_system>();
+    const shortcut_cache cache(fs, state_path);
+
+    // 快捷方式不存在时必须校验
+    RAINY_CHECK(!probe(cache));
+    fs->touch(link_path);
+    auto current = probe(cache);
+    RAINY_CHECK(current && current->link_write_time == fs->files[link_path].write_time);
+    RAINY_CHECK(current && current->appname == L"rainy" && current->executable_path == executable);
+    if (!current) {
+        return rainy_test::finish("shortcut_cache_test");
+    }
+
+    // 首次启动没有状态文件；记录之后，状态未变化的启动只需一次stat与一次读取
+    RAINY_CHECK(!cache.is_current(*current));
+    RAINY_CHECK(cache.store(*current));
+    RAINY_CHECK(fs->files.count(state_path) == 1);
+    fs->stats = fs->reads = fs->writes = 0;
+    current = probe(cache);
+    RAINY_CHECK(current && cache.is_current(*current));
+    RAINY_CHECK(fs->stats == 1 && fs->reads == 1 && fs->writes == 0);
+
+    // 任意一项变化都需要重新校验
+    shortcut_state changed = *current;
+    changed.appname = L"other";
+    RAINY_CHECK(!cache.is_current(changed));
+    changed = *current;
+    changed.aumi = L"other.aumi";
+    RAINY_CHECK(!cache.is_current(changed));
+    changed = *current;
+    changed.executable_path = L"D:\\moved\\rainy.exe";
+    RAINY_CHECK(!cache.is_current(changed));
+    fs->touch(link_path);
+    const auto relinked = probe(cache);
+    RAINY_CHECK(relinked && !cache.is_current(*relinked));
+    RAINY_CHECK(relinked && cache.store(*relinked) && cache.is_current(*relinked));
+
+    // 编码往返，包括空字符串与非ASCII字符
+    const shortcut_state unicode{L"\x96e8\x901a\x77e5", L"", L"C:\\\x7a0b\x5e8f\\a b.exe", -42};
+    RAINY_CHECK(shortcut_cache::decode(shortcut_cache::encode(unicode)) == unicode);
+    const std::string encoded = shortcut_cache::encode(*relinked);
+    RAINY_CHECK(shortcut_cache::decode(encoded) == *relinked);
+
+    // 截断在任意位置、多出字节、魔数、版本或字符宽度不符时均视为损坏
+    bool truncations_rejected = true;
+    for (std::size_t length = 0; length < encoded.size(); ++length) {
+        truncations_rejected = truncations_rejected && !shortcut_cache::decode(std::string_view{encoded}.substr(0, length));
+    }
+    RAINY_CHECK(truncations_rejected);
+    RAINY_CHECK(!shortcut_cache::decode(encoded + '\0'));
+    std::string corrupted = encoded;
+    corrupted[0] = 'X';
+    RAINY_CHECK(!shortcut_cache::decode(corrupted));
+    corrupted = encoded;
+    ++corrupted[4];
+    RAINY_CHECK(!shortcut_cache::decode(corrupted));
+    corrupted = encoded;
+    corrupted[5] = static_cast<char>(sizeof(wchar_t) == 2 ? 4 : 2);
+    RAINY_CHECK(!shortcut_cache::decode(corrupted));
+    // 长度字段远超文件大小时拒绝，不会按该长度分配
+    corrupted = encoded;
+    corrupted[6] = corrupted[7] = corrupted[8] = corrupted[9] = '\xff';
+    RAINY_CHECK(!shortcut_cache::decode(corrupted));
+    fs->files[state_path].contents = corrupted;
+    RAINY_CHECK(!cache.is_current(*relinked));
+
+    // 文件系统失败：读取失败时重新校验，写入失败时store报告失败
+    RAINY_CHECK(cache.store(*relinked));
+    fs->fail_reads = true;
+    RAINY_CHECK(!cache.is_current(*relinked));
+    fs->fail_reads = false;
+    fs->fail_writes = true;
+    RAINY_CHECK(!cache.store(unicode));
+    RAINY_CHECK(cache.is_current(*relinked));
+    fs->fail_writes = false;
+
+    // 没有文件系统或状态文件路径时不缓存
+    const shortcut_cache without_fs(nullptr, state_path);
+    RAINY_CHECK(!probe(without_fs));
+    RAINY_CHECK(!without_fs.store(*relinked) && !without_fs.is_current(*relinked));
+    const shortcut_cache without_path(fs, L"");
+    RAINY_CHECK(!without_path.store(*relinked) && !without_path.is_current(*relinked));
+
+    // std_file_system：写入时创建缺失的目录，读取与修改时间一致
+    const auto root = std::filesystem::temp_directory_path() / ("rainy-shortcut-cache-" + std::to_string(std::rand()));
+    const std::wstring nested = (root / "a" / "b" / "state.bin").wstring();
+    utility::std_file_system disk;
+    RAINY_CHECK(!disk.last_write_time(nested));
+    std::string contents;
+    RAINY_CHECK(!disk.read_file(nested, contents));
+    RAINY_CHECK(disk.write_file(nested, encoded));
+    RAINY_CHECK(disk.last_write_time(nested).has_value());
+    RAINY_CHECK(disk.read_file(nested, contents) && contents == encoded);
+    RAINY_CHECK(disk.write_file(nested, "short") && disk.read_file(nested, contents) && contents == "short");
+    const shortcut_cache on_disk(std::make_shared<utility::std_file_system>(), nested);
+    RAINY_CHECK(on_disk.store(unicode) && on_disk.is_current(unicode));
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    return rainy_test::finish("shortcut_cache_test");
+}
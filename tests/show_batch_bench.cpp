@@ -0,0 +1,45 @@
+﻿/*
+ * show_batch与逐个show的每条通知耗时对比
+ */
+#include "test_support.hpp"
+
+using namespace rainy;
+
+int main(int argc, char **argv) {
+    constexpr std::size_t batch_size = 64;
+    const std::size_t batches = 100 * rainy_test::scale(argc, argv);
+    auto backend = std::make_shared<rainy_test::counting_backend>();
+    auto n = rainy_test::make_notification(backend);
+    n->set_default_expiration(std::chrono::milliseconds(0));
+
+    std::vector<notification_template> burst(batch_size);
+    for (std::size_t i = 0; i < batch_size; ++i) {
+        burst[i].set_first_line(L"message " + std::to_wstring(i));
+        burst[i].set_second_line(L"from the batch benchmark");
+    }
+    auto handler = std::make_shared<rainy_test::null_handler>();
+    rainy_test::null_handler borrowed;
+    std::size_t failures = 0;
+    const double batched = rainy_test::median_ns(9, batches * batch_size, [&] {
+        for (std::size_t b = 0; b < batches; ++b) {
+            for (const auto &result: n->show_batch(burst, handler)) {
+                failures += result.id == -1;
+            }
+            n->clear();
+        }
+    });
+    RAINY_CHECK(backend->batches == 9 * batches);
+    const double single = rainy_test::median_ns(9, batches * batch_size, [&] {
+        for (std::size_t b = 0; b < batches; ++b) {
+            for (const auto &toast: burst) {
+                failures += n->show(toast, borrowed) == -1;
+            }
+            n->clear();
+        }
+    });
+    RAINY_CHECK(failures == 0);
+    RAINY_CHECK(backend->shows == 2 * 9 * batches * batch_size);
+    RAINY_CHECK(backend->notifier_creations == 1);
+    std::printf("show_batch(%zu): %.1f ns/toast, show loop: %.1f ns/toast\n", batch_size, batched, single);
+    return rainy_test::finish("show_batch_bench");
+}
@@ -0,0 +1,41 @@
+﻿/*
+ * show/hide吞吐量。通知器在init()中创建一次并在之后复用，只有在显示返回通知器失效时才重新创建
+ */
+#include "test_support.hpp"
+
+using namespace rainy;
+
+int main(int argc, char **argv) {
+    const std::size_t iterations = 5000 * rainy_test::scale(argc, argv);
+    auto backend = std::make_shared<rainy_test::counting_backend>();
+    auto n = rainy_test::make_notification(backend);
+    RAINY_CHECK(backend->notifier_creations == 1);
+
+    notification_template toast;
+    toast.set_first_line(L"throughput");
+    toast.set_second_line(L"show and hide");
+    rainy_test::null_handler handler;
+    constexpr std::size_t rounds = 9;
+    const double per_toast = rainy_test::median_ns(rounds, iterations, [&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            const auto id = n->show(toast, handler);
+            n->hide(id);
+        }
+    });
+    RAINY_CHECK(backend->shows == rounds * iterations);
+    RAINY_CHECK(backend->hides == rounds * iterations);
+    RAINY_CHECK(backend->notifier_creations == 1);
+
+    // 通知器失效时重新创建一次并重试，之后继续复用
+    backend->stale_shows = 1;
+    RAINY_CHECK(n->show(toast, handler) != -1);
+    RAINY_CHECK(backend->notifier_creations == 2);
+    for (int i = 0; i < 100; ++i) {
+        n->hide(n->show(toast, handler));
+    }
+    RAINY_CHECK(backend->notifier_creations == 2);
+
+    std::printf("show+hide: %.1f ns/toast, notifier creations: %zu for %zu toasts\n", per_toast, backend->notifier_creations.load(),
+                backend->shows.load());
+    return rainy_test::finish("show_hide_bench");
+}
@@ -0,0 +1,116 @@
+﻿/*
+ * 虚拟时钟上的长时间运行：以固定速率显示通知，一部分被激活、一部分被隐藏，其余按默认的3天保留时长过期。
+ * 注册表大小与尚未释放的分配数在保留时长之后保持稳定，过期的通知恰好收到一次timed_out
+ */
+#include "allocation_counter.hpp"
+#include "test_support.hpp"
+
+#include <deque>
+
+using namespace rainy;
+using event_type = notification_event::event_type;
+using reason = notification_handler::dismissal_reason;
+
+namespace {
+    struct outcome_counts {
+        std::size_t activated = 0;
+        std::size_t dismissed = 0;
+        std::size_t timed_out = 0;
+        std::size_t other = 0;
+    };
+}
+
+int main(int argc, char **argv) {
+    const std::size_t days = 10 * rainy_test::scale(argc, argv);
+    constexpr std::size_t per_minute = 10;
+    constexpr std::size_t retention_days = 3;
+    auto now = std::chrono::steady_clock::time_point{} + std::chrono::hours(1);
+
+    auto n = rainy_test::make_notification();
+    auto backend = std::dynamic_pointer_cast<memory_notification_backend>(n->backend());
+    RAINY_CHECK(backend != nullptr);
+    if (!backend) {
+        return rainy_test::finish("soak_test");
+    }
+    n->set_schedule_clock([&now] { return now; });
+
+    outcome_counts counts;
+    std::deque<std::int64_t> to_activate;
+    std::deque<std::int64_t> to_hide;
+    std::size_t to_activate_total = 0;
+    std::size_t left_to_expire = 0;
+    std::size_t expired_due = 0; // 到运行结束时已超过保留时长、应当收到timed_out的通知数
+    std::vector<std::ptrdiff_t> live_by_day;
+    std::vector<std::size_t> active_by_day;
+    const std::size_t minutes = days * 24 * 60;
+    for (std::size_t minute = 0; minute < minutes; ++minute) {
+        for (std::size_t i = 0; i < per_minute; ++i) {
+            notification_template toast;
+            toast.set_first_line(L"soak " + std::to_wstring(minute));
+            toast.set_second_line(L"#" + std::to_wstring(i));
+            const bool tagged = i % 5 == 0; // Tag每50分钟重复一次，旧的通知被替换，不会再过期
+            if (tagged) {
+                toast.group(L"soak");
+                toast.tag(std::to_wstring(minute % 50) + L"-" + std::to_wstring(i));
+            }
+            const auto id = n->show(toast, [&counts](const notification_event &event) {
+                if (event.type == event_type::activated) {
+                    ++counts.activated;
+                } else if (event.type == event_type::dismissed) {
+                    ++(std::get<reason>(event.data) == reason::timed_out ? counts.timed_out : counts.dismissed);
+                } else {
+                    ++counts.other;
+                }
+            });
+            switch (i % 3) {
+                case 0:
+                    to_activate.push_back(id);
+                    ++to_activate_total;
+                    break;
+                case 1:
+                    to_hide.push_back(id);
+                    break;
+                default:
+                    ++left_to_expire;
+                    if (!tagged && minutes - minute >= retention_days * 24 * 60) {
+                        ++expired_due;
+                    }
+                    break;
+            }
+        }
+        // 用户在一分钟后点击，应用在五分钟后隐藏
+        while (to_activate.size() > per_minute) {
+            backend->simulate_activated(to_activate.front());
+            to_activate.pop_front();
+        }
+        while (to_hide.size() > 5 * per_minute) {
+            n->hide(to_hide.front());
+            to_hide.pop_front();
+        }
+        now += std::chrono::minutes(1);
+        n->run_due_schedules();
+        if ((minute + 1) % (24 * 60) == 0) {
+            n->maintenance();
+            backend->clear(); // 后端的记录只保留仍被持有句柄的通知，与操作中心按保留时长清理一致
+            live_by_day.push_back(rainy_test::live_allocations.load());
+            active_by_day.push_back(n->active_count());
+            std::printf("day %zu: active=%zu live allocations=%td\n", live_by_day.size(), active_by_day.back(), live_by_day.back());
+        }
+    }
+
+    // 保留时长之后注册表只含最近3天内留待过期的通知以及少量待激活、待隐藏的通知
+    const std::size_t steady = left_to_expire / minutes * 24 * 60 * retention_days;
+    bool bounded = true;
+    for (std::size_t day = retention_days + 1; day < active_by_day.size(); ++day) {
+        bounded = bounded && active_by_day[day] <= steady + 2 * per_minute * 60 &&
+                  live_by_day[day] <= live_by_day[retention_days + 1] + live_by_day[retention_days + 1] / 20;
+    }
+    RAINY_CHECK(bounded);
+    // 每个留待过期的通知恰好收到一次timed_out，被激活或隐藏的通知不会收到
+    RAINY_CHECK(counts.timed_out == expired_due);
+    RAINY_CHECK(counts.other == 0);
+    RAINY_CHECK(counts.activated == to_activate_total - to_activate.size());
+    std::printf("soak: %zu virtual days, %zu toasts, %zu timed out of %zu left to expire\n", days, minutes * per_minute,
+                counts.timed_out, left_to_expire);
+    return rainy_test::finish("soak_test");
+}
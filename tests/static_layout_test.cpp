@@ -0,0 +1,117 @@
+﻿/*
+ * static_layout在编译期生成的分段与骨架：每种传统模板的segment(i)、closing与完整骨架都以static_assert固定，
+ * 运行时再检查legacy_skeletons中的偏移恰好指向各插槽
+ */
+#include "test_support.hpp"
+
+using namespace rainy;
+using namespace rainy::internals;
+
+namespace {
+    using image_and_text01 = static_layout<notification_template_type::image_and_text01>;
+    static_assert(image_and_text01::slots_count == 2);
+    static_assert(image_and_text01::segment(0) == L"<visual><binding template=\"ToastImageAndText01\"><image id=\"1\" src=\"");
+    static_assert(image_and_text01::segment(1) == L"\"/><text id=\"1\">");
+    static_assert(image_and_text01::segment(2) == L"</text>");
+    static_assert(image_and_text01::closing == L"</binding></visual>");
+    static_assert(image_and_text01::skeleton.view() == L"<visual><binding template=\"ToastImageAndText01\"><image id=\"1\" src=\"\"/><text id=\"1\"></text></binding></visual>");
+
+    using image_and_text02 = static_layout<notification_template_type::image_and_text02>;
+    static_assert(image_and_text02::slots_count == 3);
+    static_assert(image_and_text02::segment(0) == L"<visual><binding template=\"ToastImageAndText02\"><image id=\"1\" src=\"");
+    static_assert(image_and_text02::segment(1) == L"\"/><text id=\"1\">");
+    static_assert(image_and_text02::segment(2) == L"</text><text id=\"2\">");
+    static_assert(image_and_text02::segment(3) == L"</text>");
+    static_assert(image_and_text02::closing == L"</binding></visual>");
+    static_assert(image_and_text02::skeleton.view() == L"<visual><binding template=\"ToastImageAndText02\"><image id=\"1\" src=\"\"/><text id=\"1\"></text><text id=\"2\"></text></binding></visual>");
+
+    using image_and_text03 = static_layout<notification_template_type::image_and_text03>;
+    static_assert(image_and_text03::slots_count == 3);
+    static_assert(image_and_text03::segment(0) == L"<visual><binding template=\"ToastImageAndText03\"><image id=\"1\" src=\"");
+    static_assert(image_and_text03::segment(1) == L"\"/><text id=\"1\">");
+    static_assert(image_and_text03::segment(2) == L"</text><text id=\"2\">");
+    static_assert(image_and_text03::segment(3) == L"</text>");
+    static_assert(image_and_text03::closing == L"</binding></visual>");
+    static_assert(image_and_text03::skeleton.view() == L"<visual><binding template=\"ToastImageAndText03\"><image id=\"1\" src=\"\"/><text id=\"1\"></text><text id=\"2\"></text></binding></visual>");
+
+    using image_and_text04 = static_layout<notification_template_type::image_and_text04>;
+    static_assert(image_and_text04::slots_count == 4);
+    static_assert(image_and_text04::segment(0) == L"<visual><binding template=\"ToastImageAndText04\"><image id=\"1\" src=\"");
+    static_assert(image_and_text04::segment(1) == L"\"/><text id=\"1\">");
+    static_assert(image_and_text04::segment(2) == L"</text><text id=\"2\">");
+    static_assert(image_and_text04::segment(3) == L"</text><text id=\"3\">");
+    static_assert(image_and_text04::segment(4) == L"</text>");
+    static_assert(image_and_text04::closing == L"</binding></visual>");
+    static_assert(image_and_text04::skeleton.view() == L"<visual><binding template=\"ToastImageAndText04\"><image id=\"1\" src=\"\"/><text id=\"1\"></text><text id=\"2\"></text><text id=\"3\"></text></binding></visual>");
+
+    using text01 = static_layout<notification_template_type::text01>;
+    static_assert(text01::slots_count == 1);
+    static_assert(text01::segment(0) == L"<visual><binding template=\"ToastText01\"><text id=\"1\">");
+    static_assert(text01::segment(1) == L"</text>");
+    static_assert(text01::closing == L"</binding></visual>");
+    static_assert(text01::skeleton.view() == L"<visual><binding template=\"ToastText01\"><text id=\"1\"></text></binding></visual>");
+
+    using text02 = static_layout<notification_template_type::text02>;
+    static_assert(text02::slots_count == 2);
+    static_assert(text02::segment(0) == L"<visual><binding template=\"ToastText02\"><text id=\"1\">");
+    static_assert(text02::segment(1) == L"</text><text id=\"2\">");
+    static_assert(text02::segment(2) == L"</text>");
+    static_assert(text02::closing == L"</binding></visual>");
+    static_assert(text02::skeleton.view() == L"<visual><binding template=\"ToastText02\"><text id=\"1\"></text><text id=\"2\"></text></binding></visual>");
+
+    using text03 = static_layout<notification_template_type::text03>;
+    static_assert(text03::slots_count == 2);
+    static_assert(text03::segment(0) == L"<visual><binding template=\"ToastText03\"><text id=\"1\">");
+    static_assert(text03::segment(1) == L"</text><text id=\"2\">");
+    static_assert(text03::segment(2) == L"</text>");
+    static_assert(text03::closing == L"</binding></visual>");
+    static_assert(text03::skeleton.view() == L"<visual><binding template=\"ToastText03\"><text id=\"1\"></text><text id=\"2\"></text></binding></visual>");
+
+    using text04 = static_layout<notification_template_type::text04>;
+    static_assert(text04::slots_count == 3);
+    static_assert(text04::segment(0) == L"<visual><binding template=\"ToastText04\"><text id=\"1\">");
+    static_assert(text04::segment(1) == L"</text><text id=\"2\">");
+    static_assert(text04::segment(2) == L"</text><text id=\"3\">");
+    static_assert(text04::segment(3) == L"</text>");
+    static_assert(text04::closing == L"</binding></visual>");
+    static_assert(text04::skeleton.view() == L"<visual><binding template=\"ToastText04\"><text id=\"1\"></text><text id=\"2\"></text><text id=\"3\"></text></binding></visual>");
+
+    template <notification_template_type Type>
+    bool offsets_match() {
+        using layout = static_layout<Type>;
+        const auto &skeleton = legacy_skeletons[layout::index];
+        // 偏移处之前的内容应当以对应插槽之前的分段结尾
+        std::size_t slot = 0;
+        const auto ends_with_segment = [&](const std::size_t offset) {
+            const std::wstring_view before = skeleton.xml.substr(0, offset);
+            const std::wstring_view segment = layout::segment(slot++);
+            return before.size() >= segment.size() && before.substr(before.size() - segment.size()) == segment;
+        };
+        bool matched = skeleton.xml == L"<toast>" + std::wstring(layout::skeleton.view()) + L"</toast>";
+        if (layout::has_image) {
+            matched = matched && ends_with_segment(skeleton.image_src);
+        } else {
+            matched = matched && skeleton.image_src == legacy_skeleton::npos;
+        }
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (i < layout::fields_count) {
+                matched = matched && ends_with_segment(skeleton.text[i]);
+            } else {
+                matched = matched && skeleton.text[i] == legacy_skeleton::npos;
+            }
+        }
+        return matched && skeleton.xml.substr(skeleton.binding_end).starts_with(L"</binding>");
+    }
+}
+
+int main() {
+    RAINY_CHECK(offsets_match<notification_template_type::image_and_text01>());
+    RAINY_CHECK(offsets_match<notification_template_type::image_and_text02>());
+    RAINY_CHECK(offsets_match<notification_template_type::image_and_text03>());
+    RAINY_CHECK(offsets_match<notification_template_type::image_and_text04>());
+    RAINY_CHECK(offsets_match<notification_template_type::text01>());
+    RAINY_CHECK(offsets_match<notification_template_type::text02>());
+    RAINY_CHECK(offsets_match<notification_template_type::text03>());
+    RAINY_CHECK(offsets_match<notification_template_type::text04>());
+    return rainy_test::finish("static_layout_test");
+}
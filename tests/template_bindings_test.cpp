@@ -0,0 +1,52 @@
+﻿/*
+ * 数据绑定：reset()之后重新声明绑定复用已有的键值字符串，且绑定在显示与更新中保持正确
+ */
+#include "allocation_counter.hpp"
+#include "test_support.hpp"
+
+using namespace rainy;
+
+int main() {
+    notification_template toast;
+    const auto fill = [&toast](const int round) {
+        toast.set_first_line(L"download");
+        toast.progress_bar(L"{progress}", L"{status}");
+        toast.bind(L"progress", round % 2 == 0 ? L"0.25" : L"0.5");
+        toast.bind(L"status", L"downloading");
+        toast.bind(L"progress", L"0.75"); // 重复声明覆盖初始值
+    };
+    fill(0);
+    RAINY_CHECK(toast.bindings().size() == 2);
+    RAINY_CHECK(toast.bindings()[0].key == L"progress" && toast.bindings()[0].value == L"0.75");
+    toast.reset();
+    RAINY_CHECK(toast.bindings().empty());
+    {
+        const rainy_test::allocation_scope scope;
+        for (int round = 1; round < 100; ++round) {
+            fill(round);
+            toast.reset();
+        }
+        RAINY_CHECK(scope.count() == 0);
+    }
+    fill(1);
+    RAINY_CHECK(toast.bindings().size() == 2);
+    RAINY_CHECK(toast.bindings()[1].key == L"status" && toast.bindings()[1].value == L"downloading");
+
+    // reset()后较少的绑定只暴露有效的项
+    toast.reset();
+    toast.bind(L"only", L"1");
+    RAINY_CHECK(toast.bindings().size() == 1 && toast.bindings()[0].key == L"only");
+
+    // 复用的模板仍能正确显示与更新
+    auto n = rainy_test::make_notification();
+    auto backend = std::dynamic_pointer_cast<memory_notification_backend>(n->backend());
+    toast.reset();
+    fill(0);
+    const auto id = n->show(toast, [](const notification_event &) {});
+    RAINY_CHECK(id != -1);
+    RAINY_CHECK(n->update(id, {{L"status", L"done"}}));
+    const auto record = backend->find(id);
+    RAINY_CHECK(record && record->data.size() == 2);
+    RAINY_CHECK(record && record->data[1].key == L"status" && record->data[1].value == L"done");
+    return rainy_test::finish("template_bindings_test");
+}
@@ -0,0 +1,36 @@
+﻿/*
+ * template_cache命中路径与逐次序列化路径的每次渲染耗时
+ */
+#include "test_support.hpp"
+
+using namespace rainy;
+
+int main(int argc, char **argv) {
+    const std::size_t iterations = 2000 * rainy_test::scale(argc, argv);
+    const utility::context_bridge bridge(platform_capabilities{true, true, true, true, true}, true);
+    const utility::toast_xml_serializer serializer(bridge);
+    utility::template_cache cache;
+    const auto shapes = rainy_test::template_shapes(1);
+    std::wstring buffer;
+    std::size_t checksum = 0;
+    const double cached = rainy_test::median_ns(9, iterations * shapes.size(), [&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            for (const auto &shape: shapes) {
+                cache.render(bridge, shape, buffer);
+                checksum += buffer.size();
+            }
+        }
+    });
+    const double per_call = rainy_test::median_ns(9, iterations * shapes.size(), [&] {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            for (const auto &shape: shapes) {
+                serializer.serialize(shape, buffer);
+                checksum += buffer.size();
+            }
+        }
+    });
+    std::printf("template_cache hit: %.1f ns/render, toast_xml_serializer: %.1f ns/render (checksum %zu)\n", cached, per_call,
+                checksum);
+    RAINY_CHECK(cache.stats().misses == shapes.size());
+    return rainy_test::finish("template_cache_bench");
+}
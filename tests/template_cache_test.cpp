@@ -0,0 +1,33 @@
+﻿/*
+ * template_cache命中时由compiled_toast_template::render生成的XML，必须与toast_xml_serializer逐次序列化的结果完全一致
+ */
+#include "test_support.hpp"
+
+#include <iostream>
+
+using namespace rainy;
+
+int main() {
+    for (const bool modern: {true, false}) {
+        const utility::context_bridge bridge(platform_capabilities{true, true, true, true, true}, modern);
+        const utility::toast_xml_serializer serializer(bridge);
+        utility::template_cache cache;
+        std::wstring buffer;
+        for (int variant = 0; variant < 3; ++variant) {
+            for (const auto &shape: rainy_test::template_shapes(variant)) {
+                cache.render(bridge, shape, buffer);
+                const std::wstring expected = serializer.serialize(shape);
+                if (!RAINY_CHECK(buffer == expected)) {
+                    std::wcerr << L"expected: " << expected << L"\n  actual: " << buffer << L"\n";
+                }
+            }
+        }
+        const auto stats = cache.stats();
+        const std::size_t shapes = rainy_test::template_shapes().size();
+        // 同一形状只编译一次，内容不同的后续渲染都命中缓存
+        RAINY_CHECK(stats.misses <= shapes);
+        RAINY_CHECK(stats.hits + stats.misses == shapes * 3);
+        RAINY_CHECK(stats.hits >= shapes * 2);
+    }
+    return rainy_test::finish("template_cache_test");
+}
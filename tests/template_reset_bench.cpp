@@ -0,0 +1,67 @@
+﻿/*
+ * 循环复用同一模板：reset()后重新填充所有字段不分配堆内存，并与每次构造新模板的耗时对比
+ */
+#include "allocation_counter.hpp"
+#include "test_support.hpp"
+
+using namespace rainy;
+
+namespace {
+    void fill(notification_template &toast, const std::size_t i, const bool with_input) {
+        toast.set_first_line(i % 2 == 0 ? L"New message from Alice" : L"New message from Bob");
+        toast.set_second_line(L"Are we still on for lunch tomorrow?");
+        toast.set_third_line(L"Sent from the mobile app");
+        toast.set_image_path(L"C:\\Users\\demo\\AppData\\Local\\app\\avatar.png", notification_template::crop_hint::circle);
+        toast.hero_image_path(L"C:\\Users\\demo\\AppData\\Local\\app\\hero.png");
+        toast.audio_path(L"ms-winsoundevent:Notification.IM");
+        toast.set_attribution_text(L"via chat");
+        toast.coalescing_key(L"conversation-42");
+        toast.tag(L"message");
+        toast.group(L"chat");
+        toast.progress_bar(L"{progress}", L"{status}", L"Upload");
+        toast.bind(L"progress", L"0.5");
+        toast.bind(L"status", L"uploading");
+        toast.expiration(60000);
+        toast.priority(notification_template::priority_t::high);
+        if (with_input) {
+            toast.add_input(L"reply", L"Type a reply");
+        } else {
+            toast.actions.add_action({L"Reply", L"Mark as read"});
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::size_t iterations = 20000 * rainy_test::scale(argc, argv);
+    // 以三行文本的布局预热，使每个字段都分配过存储
+    notification_template reused(notification_template_type::image_and_text04);
+    fill(reused, 0, true);
+    reused.reset(notification_template_type::image_and_text04);
+    fill(reused, 0, false);
+
+    // 两种形状各填充过一次之后，后续的reset()与重新填充都不分配
+    std::size_t reuse_allocations = 0;
+    const double reuse = rainy_test::median_ns(9, iterations, [&] {
+        const rainy_test::allocation_scope scope;
+        for (std::size_t i = 0; i < iterations; ++i) {
+            reused.reset(i % 3 == 0 ? notification_template_type::text04 : notification_template_type::image_and_text02);
+            fill(reused, i, i % 2 == 0);
+        }
+        reuse_allocations += scope.count();
+    });
+    RAINY_CHECK(reuse_allocations == 0);
+
+    std::size_t fresh_allocations = 0;
+    const double fresh = rainy_test::median_ns(9, iterations, [&] {
+        const rainy_test::allocation_scope scope;
+        for (std::size_t i = 0; i < iterations; ++i) {
+            notification_template toast(notification_template_type::image_and_text02);
+            fill(toast, i, i % 2 == 0);
+        }
+        fresh_allocations += scope.count();
+    });
+    std::printf("reset()+fill: %.1f ns, %.2f allocations per template; new template+fill: %.1f ns, %.2f allocations per template\n",
+                reuse, static_cast<double>(reuse_allocations) / static_cast<double>(9 * iterations), fresh,
+                static_cast<double>(fresh_allocations) / static_cast<double>(9 * iterations));
+    return rainy_test::finish("template_reset_bench");
+}
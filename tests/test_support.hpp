@@ -0,0 +1,262 @@
+﻿/*
+ * 测试与基准共用的辅助设施。测试不依赖任何框架：RAINY_CHECK记录失败并继续执行，main返回rainy_test::finish()
+ */
+#ifndef RAINY_NOTIFICATION_TEST_SUPPORT_HPP
+#define RAINY_NOTIFICATION_TEST_SUPPORT_HPP
+#include "rainy_notification.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__SANITIZE_THREAD__) || defined(__SANITIZE_ADDRESS__)
+#define RAINY_TEST_SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer) || __has_feature(address_sanitizer)
+#define RAINY_TEST_SANITIZED 1
+#endif
+#endif
+
+namespace rainy_test {
+    /**
+     * @brief 是否在sanitizer下运行。此时耗时大幅增加，延迟类的检查只输出结果而不判断阈值
+     */
+#ifdef RAINY_TEST_SANITIZED
+    inline constexpr bool sanitized = true;
+#else
+    inline constexpr bool sanitized = false;
+#endif
+
+    inline int &failures() noexcept {
+        static int count = 0;
+        return count;
+    }
+
+    inline bool check(const bool passed, const char *expression, const char *file, const int line) {
+        if (!passed) {
+            ++failures();
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        }
+        return passed;
+    }
+
+    /**
+     * @brief 输出结果并返回main的退出码
+     */
+    inline int finish(const char *name) {
+        if (failures() != 0) {
+            std::fprintf(stderr, "%s: %d check(s) failed\n", name, failures());
+            return 1;
+        }
+        std::printf("%s: ok\n", name);
+        return 0;
+    }
+
+    /**
+     * @brief 基准的规模倍数，取自第一个命令行参数，默认为1
+     */
+    inline std::size_t scale(const int argc, char **argv) {
+        if (argc > 1) {
+            const long value = std::strtol(argv[1], nullptr, 10);
+            if (value > 0) {
+                return static_cast<std::size_t>(value);
+            }
+        }
+        return 1;
+    }
+
+    /**
+     * @brief 重复运行fx若干轮，返回每次操作耗时（纳秒）的中位数
+     * @param operations 每轮执行的操作次数，fx执行一轮
+     */
+    template <typename Fx>
+    double median_ns(const std::size_t rounds, const std::size_t operations, Fx &&fx) {
+        std::vector<double> samples;
+        samples.reserve(rounds);
+        for (std::size_t round = 0; round < rounds; ++round) {
+            const auto start = std::chrono::steady_clock::now();
+            fx();
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(operations));
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    /**
+     * @brief 取已排序样本的分位数
+     */
+    template <typename Ty>
+    Ty percentile(const std::vector<Ty> &sorted, const double q) {
+        if (sorted.empty()) {
+            return Ty{};
+        }
+        const auto index = static_cast<std::size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[(std::min)(index, sorted.size() - 1)];
+    }
+
+    struct null_handler final : rainy::notification_handler {
+        void activated() const override {
+        }
+
+        void activated(int) const override {
+        }
+
+        void activated(const std::wstring_view) const override {
+        }
+
+        void dismissed(dismissal_reason) const override {
+        }
+
+        void failed() const override {
+        }
+    };
+
+    /**
+     * @brief 只计数、不保存记录的假后端，用于吞吐量基准。记录通知器的创建次数，并可让若干次show返回通知器失效。
+     * @brief 平台事件通过sink直接回报
+     */
+    class counting_backend final : public rainy::notification_backend {
+    public:
+        struct counting_handle final : toast_handle {
+            std::int64_t id;
+
+            explicit counting_handle(const std::int64_t id) noexcept : id(id) {
+            }
+        };
+
+        HRESULT create_notifier(std::wstring_view) override {
+            notifier_creations.fetch_add(1, std::memory_order_relaxed);
+            has_notifier_ = true;
+            return S_OK;
+        }
+
+        void release_notifier() noexcept override {
+            has_notifier_ = false;
+        }
+
+        rainy::platform_capabilities query_capabilities() override {
+            return {true, true, true, true, true};
+        }
+
+        HRESULT show(const toast_request &request, event_sink &sink, std::unique_ptr<toast_handle> &handle) override {
+            this->sink.store(&sink, std::memory_order_relaxed);
+            if (!has_notifier_) {
+                return E_FAIL;
+            }
+            if (stale_shows.load(std::memory_order_relaxed) != 0) {
+                stale_shows.fetch_sub(1, std::memory_order_relaxed);
+                return stale_result;
+            }
+            shows.fetch_add(1, std::memory_order_relaxed);
+            handle = std::make_unique<counting_handle>(request.id);
+            return S_OK;
+        }
+
+        void show_batch(std::span<const toast_request> requests, event_sink &sink, std::span<std::unique_ptr<toast_handle>> handles,
+                        std::span<HRESULT> results) override {
+            batches.fetch_add(1, std::memory_order_relaxed);
+            notification_backend::show_batch(requests, sink, handles, results);
+        }
+
+        HRESULT hide(toast_handle &) override {
+            hides.fetch_add(1, std::memory_order_relaxed);
+            return S_OK;
+        }
+
+        HRESULT remove_group(std::wstring_view) override {
+            if (!bulk_removal.load(std::memory_order_relaxed)) {
+                return E_NOTIMPL;
+            }
+            history_removals.fetch_add(1, std::memory_order_relaxed);
+            return S_OK;
+        }
+
+        HRESULT remove_tag(std::wstring_view, std::wstring_view) override {
+            if (!bulk_removal.load(std::memory_order_relaxed)) {
+                return E_NOTIMPL;
+            }
+            history_removals.fetch_add(1, std::memory_order_relaxed);
+            return S_OK;
+        }
+
+        static constexpr HRESULT stale_result = static_cast<HRESULT>(0x80010108); // RPC_E_DISCONNECTED
+
+        std::atomic<std::size_t> notifier_creations{0};
+        std::atomic<std::size_t> shows{0};
+        std::atomic<std::size_t> batches{0};
+        std::atomic<std::size_t> hides{0};
+        std::atomic<std::size_t> history_removals{0};
+        std::atomic<std::size_t> stale_shows{0};
+        std::atomic<bool> bulk_removal{true}; // 为false时remove_group/remove_tag返回E_NOTIMPL，模拟不支持按组移除的平台
+        std::atomic<event_sink *> sink{nullptr}; // 最近一次show收到的事件接收者，用于模拟平台事件
+
+    private:
+        bool has_notifier_{false};
+    };
+
+    /**
+     * @brief 创建已初始化的notification
+     * @param backend 为空时使用默认的后端（非Windows平台上为memory_notification_backend）
+     */
+    inline std::unique_ptr<rainy::notification> make_notification(std::shared_ptr<rainy::notification_backend> backend = nullptr) {
+        auto instance = std::make_unique<rainy::notification>();
+        instance->set_app_name(L"rainy-tests");
+        instance->set_aumi(L"rainy.notification.tests");
+        instance->set_shortcut_policy(rainy::utility::shortcut_policy::ignore);
+        if (backend) {
+            instance->set_backend(std::move(backend));
+        }
+        if (!instance->init()) {
+            std::fprintf(stderr, "notification::init failed\n");
+            std::exit(2);
+        }
+        return instance;
+    }
+}
+
+namespace rainy_test {
+    /**
+     * @brief 覆盖各种模板形状的样本：八种传统布局，以及带徽标、hero image、进度条、操作按钮与输入框的ToastGeneric
+     * @param variant 改变文本内容而不改变形状，用于命中缓存
+     */
+    inline std::vector<rainy::notification_template> template_shapes(const int variant = 0) {
+        using rainy::notification_template;
+        using rainy::notification_template_type;
+        const std::wstring suffix = std::to_wstring(variant);
+        std::vector<notification_template> shapes;
+        for (int i = 0; i < 8; ++i) {
+            notification_template &shape = shapes.emplace_back(static_cast<notification_template_type>(i));
+            shape.set_first_line(L"first & " + suffix);
+            shape.set_second_line(L"<second> " + suffix);
+            shape.set_third_line(L"third " + suffix);
+            if (i <= static_cast<int>(notification_template_type::image_and_text04)) {
+                shape.set_image_path(L"C:\\images\\" + suffix + L".png");
+            }
+        }
+        notification_template &logo = shapes.emplace_back(notification_template_type::image_and_text02);
+        logo.set_first_line(L"logo " + suffix);
+        logo.set_second_line(L"\"quoted\"");
+        logo.set_image_path(L"C:\\logo" + suffix + L".png", notification_template::crop_hint::circle);
+        logo.set_attribution_text(L"via " + suffix);
+        logo.actions.add_action({L"Yes", L"No"});
+        notification_template &hero = shapes.emplace_back(notification_template_type::text02);
+        hero.set_first_line(L"hero " + suffix);
+        hero.hero_image_path(L"C:\\hero" + suffix + L".png", true);
+        hero.audio_option(notification_template::audio_option_t::loop);
+        notification_template &progress = shapes.emplace_back(notification_template_type::text01);
+        progress.set_first_line(L"download " + suffix);
+        progress.progress_bar(L"{value}", L"{status}", L"File");
+        progress.add_input(L"reply", L"Type");
+        return shapes;
+    }
+}
+
+#define RAINY_CHECK(expression) ::rainy_test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,81 @@
+﻿/*
+ * timer_wheel的插入、取消与到期吞吐量，对照以到期时间为键的std::multimap
+ */
+#include "allocation_counter.hpp"
+#include "test_support.hpp"
+
+#include <map>
+#include <random>
+
+using namespace rainy;
+using utility::timer_wheel;
+
+int main(int argc, char **argv) {
+    const std::size_t timers = 100'000 * rainy_test::scale(argc, argv);
+    std::mt19937_64 random(7);
+    std::vector<std::uint64_t> deadlines(timers);
+    for (auto &deadline: deadlines) {
+        deadline = 1 + random() % (std::uint64_t{1} << 26); // 约18小时（以毫秒为tick），覆盖前4层
+    }
+
+    timer_wheel wheel;
+    std::vector<timer_wheel::timer_id> ids(timers);
+    std::size_t steady_allocations = 0;
+    const auto insert_cancel = [&] {
+        for (std::size_t i = 0; i < timers; ++i) {
+            ids[i] = wheel.insert(deadlines[i], static_cast<std::int64_t>(i));
+        }
+        for (const auto id: ids) {
+            wheel.cancel(id);
+        }
+    };
+    insert_cancel(); // 预热节点与空闲列表
+    const double wheel_ns = rainy_test::median_ns(9, 2 * timers, [&] {
+        const rainy_test::allocation_scope scope;
+        insert_cancel();
+        steady_allocations += scope.count();
+    });
+    RAINY_CHECK(wheel.size() == 0);
+    RAINY_CHECK(steady_allocations == 0);
+
+    std::multimap<std::uint64_t, std::int64_t> map;
+    std::vector<std::multimap<std::uint64_t, std::int64_t>::iterator> positions(timers);
+    const double map_ns = rainy_test::median_ns(9, 2 * timers, [&] {
+        for (std::size_t i = 0; i < timers; ++i) {
+            positions[i] = map.emplace(deadlines[i], static_cast<std::int64_t>(i));
+        }
+        for (const auto position: positions) {
+            map.erase(position);
+        }
+    });
+    std::printf("insert+cancel: timer_wheel %.1f ns/op (0 allocations), std::multimap %.1f ns/op\n", wheel_ns, map_ns);
+
+    // 到期：全部插入后按next_expiry推进到最后一个到期时间
+    std::vector<std::int64_t> expired;
+    expired.reserve(timers);
+    const double expire_ns = rainy_test::median_ns(9, timers, [&] {
+        timer_wheel fresh(0);
+        for (std::size_t i = 0; i < timers; ++i) {
+            fresh.insert(deadlines[i], static_cast<std::int64_t>(i));
+        }
+        expired.clear();
+        while (const auto next = fresh.next_expiry()) {
+            fresh.advance(*next, expired);
+        }
+    });
+    RAINY_CHECK(expired.size() == timers);
+    const double map_expire_ns = rainy_test::median_ns(9, timers, [&] {
+        for (std::size_t i = 0; i < timers; ++i) {
+            map.emplace(deadlines[i], static_cast<std::int64_t>(i));
+        }
+        expired.clear();
+        while (!map.empty()) {
+            expired.push_back(map.begin()->second);
+            map.erase(map.begin());
+        }
+    });
+    std::printf("insert+expire: timer_wheel %.1f ns/timer, std::multimap %.1f ns/timer\n", expire_ns, map_expire_ns);
+    // 插入与取消是O(1)，不应比平衡树更慢
+    RAINY_CHECK(wheel_ns < map_ns);
+    return rainy_test::finish("timer_wheel_bench");
+}
@@ -0,0 +1,243 @@
+﻿/*
+ * timer_wheel在虚拟时钟上的行为：各层边界与超出2^32个tick的到期时间、节点复用后的取消、跨越整圈的next_expiry，
+ * 以及与按到期时间排序的参考模型逐tick对照
+ */
+#include "test_support.hpp"
+
+#include <map>
+#include <random>
+
+using namespace rainy;
+using utility::timer_wheel;
+
+namespace {
+    /**
+     * @brief 参考模型：到期时间不晚于插入时的当前tick时在下一个tick到期，同一tick内按插入顺序输出
+     */
+    class reference_wheel {
+    public:
+        explicit reference_wheel(const std::uint64_t now) : now_(now) {
+        }
+
+        void insert(const std::uint64_t deadline, const std::int64_t value) {
+            timers_.emplace(std::pair{(std::max)(deadline, now_ + 1), sequence_++}, value);
+        }
+
+        void cancel(const std::int64_t value) {
+            std::erase_if(timers_, [value](const auto &entry) { return entry.second == value; });
+        }
+
+        void advance(const std::uint64_t now, std::vector<std::int64_t> &expired) {
+            if (now <= now_) {
+                return;
+            }
+            now_ = now;
+            while (!timers_.empty() && timers_.begin()->first.first <= now) {
+                expired.push_back(timers_.begin()->second);
+                timers_.erase(timers_.begin());
+            }
+        }
+
+        std::optional<std::uint64_t> earliest() const {
+            return timers_.empty() ? std::nullopt : std::optional<std::uint64_t>{timers_.begin()->first.first};
+        }
+
+    private:
+        std::uint64_t now_;
+        std::uint64_t sequence_ = 0;
+        std::map<std::pair<std::uint64_t, std::uint64_t>, std::int64_t> timers_;
+    };
+
+    /**
+     * @brief 只按next_expiry推进，记录每个定时器实际到期的tick
+     * @return 推进的次数
+     */
+    std::size_t run_by_next_expiry(timer_wheel &wheel, std::map<std::int64_t, std::uint64_t> &fired) {
+        std::size_t steps = 0;
+        std::vector<std::int64_t> expired;
+        while (const auto next = wheel.next_expiry()) {
+            RAINY_CHECK(*next > wheel.now());
+            wheel.advance(*next, expired);
+            for (const auto value: expired) {
+                fired[value] = wheel.now();
+            }
+            expired.clear();
+            ++steps;
+        }
+        return steps;
+    }
+
+    void boundaries(const std::uint64_t origin) {
+        // 每一层的边界及其前后一个tick，以及超出4层范围的到期时间
+        std::vector<std::uint64_t> deadlines;
+        for (const unsigned bits: {8u, 16u, 24u, 32u, 33u, 40u, 48u}) {
+            const std::uint64_t boundary = std::uint64_t{1} << bits;
+            for (const std::uint64_t offset: {boundary - 1, boundary, boundary + 1, 3 * boundary + 7}) {
+                deadlines.push_back(origin + offset);
+            }
+        }
+        deadlines.push_back(origin + 255);
+        deadlines.push_back(origin + 256 + 255);
+        timer_wheel wheel(origin);
+        for (std::size_t i = 0; i < deadlines.size(); ++i) {
+            wheel.insert(deadlines[i], static_cast<std::int64_t>(i));
+        }
+        std::map<std::int64_t, std::uint64_t> fired;
+        const std::size_t steps = run_by_next_expiry(wheel, fired);
+        bool exact = fired.size() == deadlines.size();
+        for (std::size_t i = 0; i < deadlines.size() && exact; ++i) {
+            exact = fired[static_cast<std::int64_t>(i)] == deadlines[i];
+        }
+        RAINY_CHECK(exact);
+        RAINY_CHECK(wheel.size() == 0);
+        // 每个定时器在每层最多降级一次，超出范围的定时器使最高层每转一圈多推进一次
+        const std::uint64_t turns = (*std::max_element(deadlines.begin(), deadlines.end()) - origin) >> 32;
+        RAINY_CHECK(steps <= turns + deadlines.size() * 4 + 1);
+
+        // 大步推进：一次advance跨过全部到期时间时仍按到期顺序输出
+        timer_wheel jump(origin);
+        for (std::size_t i = 0; i < deadlines.size(); ++i) {
+            jump.insert(deadlines[i], static_cast<std::int64_t>(i));
+        }
+        std::vector<std::int64_t> expired;
+        jump.advance(origin + (std::uint64_t{1} << 32) - 1, expired);
+        bool partial = true;
+        for (const auto value: expired) {
+            partial = partial && deadlines[static_cast<std::size_t>(value)] <= origin + (std::uint64_t{1} << 32) - 1;
+        }
+        jump.advance(origin + (std::uint64_t{1} << 52), expired);
+        RAINY_CHECK(partial);
+        RAINY_CHECK(expired.size() == deadlines.size() && jump.size() == 0);
+        RAINY_CHECK(std::is_sorted(expired.begin(), expired.end(), [&](const std::int64_t left, const std::int64_t right) {
+            return deadlines[static_cast<std::size_t>(left)] < deadlines[static_cast<std::size_t>(right)];
+        }));
+    }
+}
+
+int main(int argc, char **argv) {
+    boundaries(0);
+    boundaries(255);
+    boundaries((std::uint64_t{1} << 33) + 12345);
+
+    // 超出2^32个tick的到期时间：到期之前一个tick都不会输出
+    {
+        const std::uint64_t far = (std::uint64_t{1} << 32) * 5 + 17;
+        timer_wheel wheel(3);
+        wheel.insert(far, 1);
+        std::vector<std::int64_t> expired;
+        wheel.advance(far - 1, expired);
+        RAINY_CHECK(expired.empty() && wheel.size() == 1);
+        RAINY_CHECK(wheel.next_expiry() == far);
+        wheel.advance(far, expired);
+        RAINY_CHECK(expired.size() == 1 && wheel.size() == 0);
+    }
+
+    // 节点复用后，旧ID不能取消新的定时器
+    {
+        timer_wheel wheel;
+        const auto fired_id = wheel.insert(10, 1);
+        std::vector<std::int64_t> expired;
+        wheel.advance(10, expired);
+        const auto reused = wheel.insert(20, 2); // 复用同一个节点
+        RAINY_CHECK((reused & 0xFFFFFFFF) == (fired_id & 0xFFFFFFFF) && reused != fired_id);
+        RAINY_CHECK(!wheel.cancel(fired_id));
+        const auto cancelled = wheel.insert(30, 3);
+        RAINY_CHECK(wheel.cancel(cancelled) && !wheel.cancel(cancelled));
+        const auto after_cancel = wheel.insert(40, 4);
+        RAINY_CHECK(!wheel.cancel(cancelled));
+        RAINY_CHECK(!wheel.cancel(timer_wheel::invalid_timer) && !wheel.cancel(~timer_wheel::timer_id{0}));
+        RAINY_CHECK(wheel.size() == 2);
+        wheel.advance(100, expired);
+        RAINY_CHECK((expired == std::vector<std::int64_t>{1, 2, 4}));
+        RAINY_CHECK(!wheel.cancel(after_cancel) && !wheel.cancel(reused));
+    }
+
+    // 跨越整圈的next_expiry：槽号不大于当前槽号的到期时间属于下一圈
+    {
+        timer_wheel wheel(250);
+        wheel.insert(250 + 256, 1); // 与当前tick同槽
+        wheel.insert(250 + 10, 2);  // 槽号回绕，先放在第1层，在256降级
+        RAINY_CHECK(wheel.next_expiry() == 256);
+        std::vector<std::int64_t> expired;
+        wheel.advance(259, expired);
+        RAINY_CHECK(expired.empty() && wheel.next_expiry() == 260);
+        wheel.advance(260, expired);
+        RAINY_CHECK((expired == std::vector<std::int64_t>{2}));
+        const auto next = wheel.next_expiry();
+        RAINY_CHECK(next && *next > 260 && *next <= 506);
+        std::map<std::int64_t, std::uint64_t> fired;
+        run_by_next_expiry(wheel, fired);
+        RAINY_CHECK(fired[1] == 506);
+        RAINY_CHECK(!wheel.next_expiry());
+        // 过期的到期时间在下一个tick输出；下一个tick是层边界时与在该tick到期的其他定时器保持插入顺序
+        wheel.insert(100, 3);
+        RAINY_CHECK(wheel.next_expiry() == wheel.now() + 1);
+        timer_wheel boundary(511);
+        boundary.insert(100, 5);
+        boundary.insert(512, 6);
+        boundary.insert(511, 7);
+        expired.clear();
+        boundary.advance(512, expired);
+        RAINY_CHECK((expired == std::vector<std::int64_t>{5, 6, 7}));
+        wheel.insert(wheel.now() + 1000, 4);
+        wheel.clear();
+        RAINY_CHECK(wheel.size() == 0 && !wheel.next_expiry());
+    }
+
+    // 随机插入、取消与推进，与参考模型逐次对照；next_expiry不晚于最早的到期时间
+    {
+        std::mt19937_64 random(20261016);
+        const std::size_t operations = 200'000 * rainy_test::scale(argc, argv);
+        const std::uint64_t origin = random() >> 20;
+        timer_wheel wheel(origin);
+        reference_wheel reference(origin);
+        std::vector<std::pair<timer_wheel::timer_id, std::int64_t>> live;
+        std::vector<std::int64_t> expired;
+        std::vector<std::int64_t> expected;
+        std::size_t mismatches = 0;
+        std::size_t early = 0;
+        std::size_t fired = 0;
+        std::int64_t next_value = 0;
+        const auto span = [&random] {
+            // 偏向较近的到期时间，同时覆盖各层以及超出2^32的范围
+            const unsigned bits = static_cast<unsigned>(random() % 40);
+            return random() & ((std::uint64_t{1} << bits) - 1);
+        };
+        for (std::size_t i = 0; i < operations; ++i) {
+            const auto choice = random() % 8;
+            if (choice < 4) {
+                const std::int64_t value = next_value++;
+                const std::uint64_t deadline = choice == 0 ? wheel.now() - (random() % 4) : wheel.now() + span();
+                live.emplace_back(wheel.insert(deadline, value), value);
+                reference.insert(deadline, value);
+            } else if (choice < 6 && !live.empty()) {
+                const std::size_t pick = static_cast<std::size_t>(random() % live.size());
+                const bool cancelled = wheel.cancel(live[pick].first);
+                if (cancelled) {
+                    reference.cancel(live[pick].second);
+                }
+                live[pick] = live.back();
+                live.pop_back();
+            } else {
+                const auto earliest = reference.earliest();
+                const auto next = wheel.next_expiry();
+                if (earliest && (!next || *next > *earliest)) {
+                    ++early;
+                }
+                const std::uint64_t target = choice == 6 && next ? *next : wheel.now() + span() / 64;
+                expired.clear();
+                expected.clear();
+                wheel.advance(target, expired);
+                reference.advance(target, expected);
+                mismatches += expired == expected ? 0 : 1;
+                fired += expired.size();
+            }
+        }
+        RAINY_CHECK(mismatches == 0);
+        RAINY_CHECK(early == 0);
+        RAINY_CHECK(fired != 0);
+        std::printf("random: %zu operations, %lld timers, %zu fired, %zu pending\n", operations, static_cast<long long>(next_value),
+                    fired, wheel.size());
+    }
+    return rainy_test::finish("timer_wheel_test");
+}
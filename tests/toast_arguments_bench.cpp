@@ -0,0 +1,60 @@
+﻿/*
+ * 激活参数的解析耗时：toast_arguments对照以前的字符串比较加std::stoi
+ */
+#include "allocation_counter.hpp"
+#include "test_support.hpp"
+
+#include <stdexcept>
+
+using namespace rainy;
+
+namespace {
+    /**
+     * @brief 以前的做法：复制参数，与"action=reply"比较，否则以std::stoi取索引，格式错误时捕获异常
+     */
+    int legacy_resolve(const std::wstring_view arguments) {
+        const std::wstring copy(arguments);
+        if (copy == L"action=reply") {
+            return -2;
+        }
+        try {
+            return std::stoi(copy.substr(7));
+        } catch (const std::exception &) {
+            return -1;
+        }
+    }
+
+    int resolve(const std::wstring_view arguments, const std::span<const user_input> inputs) {
+        std::optional<int> action_index;
+        std::optional<std::wstring_view> reply;
+        activation{arguments, inputs}.resolve(action_index, reply);
+        return reply ? -2 : action_index.value_or(-1);
+    }
+}
+
+int main(int argc, char **argv) {
+    const std::size_t operations = 100'000 * rainy_test::scale(argc, argv);
+    const user_input inputs[] = {{L"textBox", L"hello"}};
+    const std::wstring_view samples[] = {L"action=3;", L"action=reply;input=textBox;", L"malformed"};
+    const std::wstring_view legacy_samples[] = {L"action=3", L"action=reply", L"malformed"};
+    volatile int sink = 0;
+    for (std::size_t k = 0; k < std::size(samples); ++k) {
+        std::size_t allocations = 0;
+        const double parsed = rainy_test::median_ns(9, operations, [&] {
+            const rainy_test::allocation_scope scope;
+            for (std::size_t i = 0; i < operations; ++i) {
+                sink = resolve(samples[k], inputs);
+            }
+            allocations = scope.count();
+        });
+        const double legacy = rainy_test::median_ns(9, operations, [&] {
+            for (std::size_t i = 0; i < operations; ++i) {
+                sink = legacy_resolve(legacy_samples[k]);
+            }
+        });
+        std::printf("%-28ls toast_arguments: %.1f ns, legacy: %.1f ns\n", samples[k].data(), parsed, legacy);
+        RAINY_CHECK(allocations == 0);
+    }
+    RAINY_CHECK(resolve(samples[0], inputs) == 3 && resolve(samples[1], inputs) == -2 && resolve(samples[2], inputs) == -1);
+    return rainy_test::finish("toast_arguments_bench");
+}
@@ -0,0 +1,158 @@
+﻿/*
+ * toast_arguments的解析：固定样例、与朴素参考实现对照的随机模糊测试、不分配内存，以及add_input对id的校验与端到端回复
+ */
+#include "allocation_counter.hpp"
+#include "test_support.hpp"
+
+#include <random>
+
+using namespace rainy;
+using event_type = notification_event::event_type;
+
+namespace {
+    struct reference_field {
+        std::wstring key;
+        std::wstring value;
+    };
+
+    /**
+     * @brief 按toast_arguments的文档逐字段切分的参考实现
+     */
+    std::optional<std::vector<reference_field>> reference_parse(const std::wstring &text) {
+        std::vector<reference_field> fields;
+        std::size_t begin = 0;
+        while (begin < text.size()) {
+            std::size_t end = text.find(L';', begin);
+            if (end == std::wstring::npos) {
+                end = text.size();
+            }
+            const std::wstring segment = text.substr(begin, end - begin);
+            const std::size_t separator = segment.find(L'=');
+            if (separator == std::wstring::npos || separator == 0 || fields.size() == toast_arguments::max_fields) {
+                return std::nullopt;
+            }
+            fields.push_back({segment.substr(0, separator), segment.substr(separator + 1)});
+            begin = end + 1;
+        }
+        return fields;
+    }
+
+    bool inside(const std::wstring_view view, const std::wstring &text) {
+        const wchar_t *const first = text.data();
+        return view.data() >= first && view.data() + view.size() <= first + text.size();
+    }
+
+    bool matches_reference(const std::wstring &text) {
+        toast_arguments parsed;
+        const bool accepted = parsed.parse(text);
+        const auto expected = reference_parse(text);
+        if (accepted != expected.has_value()) {
+            return false;
+        }
+        if (!accepted) {
+            return parsed.fields().empty() && !parsed.find(L"action");
+        }
+        const auto fields = parsed.fields();
+        if (fields.size() != expected->size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i].key != (*expected)[i].key || fields[i].value != (*expected)[i].value || !inside(fields[i].key, text) ||
+                !inside(fields[i].value, text)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv) {
+    // 固定样例
+    toast_arguments parsed;
+    RAINY_CHECK(parsed.parse(L"action=2;") && parsed.action_index() == 2 && !parsed.is_reply());
+    RAINY_CHECK(parsed.parse(L"action=reply;input=reply") && parsed.is_reply() && parsed.find(L"input") == std::wstring_view{L"reply"});
+    RAINY_CHECK(parsed.parse(L"") && parsed.fields().empty());
+    RAINY_CHECK(parsed.parse(L"k=a=b;") && parsed.find(L"k") == std::wstring_view{L"a=b"});
+    RAINY_CHECK(parsed.parse(L"k=;k=2;") && parsed.find(L"k") == std::wstring_view{});
+    RAINY_CHECK(parsed.parse(L"action=999999999;") && parsed.action_index() == 999'999'999);
+    RAINY_CHECK(parsed.parse(L"action=1234567890;") && !parsed.action_index());
+    RAINY_CHECK(parsed.parse(L"action=-1;") && !parsed.action_index());
+    RAINY_CHECK(parsed.parse(L"action=;") && !parsed.action_index());
+    for (const wchar_t *malformed: {L";", L"=x;", L"action", L"action=1;;", L"a=1;b", L"a=1;b;", L";a=1"}) {
+        RAINY_CHECK(!parsed.parse(malformed) && parsed.fields().empty());
+    }
+    std::wstring full;
+    for (std::size_t i = 0; i < toast_arguments::max_fields; ++i) {
+        full += L"k" + std::to_wstring(i) + L"=v;";
+    }
+    RAINY_CHECK(parsed.parse(full) && parsed.fields().size() == toast_arguments::max_fields);
+    RAINY_CHECK(!parsed.parse(full + L"k=v;"));
+
+    // 随机输入：字母表偏向分隔符，覆盖空键、空值、连续分隔符与超长字段列表
+    const std::size_t iterations = 200'000 * rainy_test::scale(argc, argv);
+    std::mt19937 random(20261016);
+    constexpr wchar_t alphabet[] = {L'=', L';', L'=', L';', L'a', L'b', L'0', L'9', L'\0', L'\x4e2d', L' ', L'-'};
+    std::uniform_int_distribution<std::size_t> pick(0, std::size(alphabet) - 1);
+    std::uniform_int_distribution<std::size_t> length(0, 48);
+    std::size_t accepted = 0;
+    std::size_t mismatches = 0;
+    std::wstring text;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        text.assign(length(random), L'\0');
+        for (auto &ch: text) {
+            ch = alphabet[pick(random)];
+        }
+        if (!matches_reference(text)) {
+            ++mismatches;
+        }
+        accepted += parsed.parse(text) ? 1 : 0;
+    }
+    RAINY_CHECK(mismatches == 0);
+    RAINY_CHECK(accepted != 0 && accepted != iterations);
+    std::printf("fuzz: %zu inputs, %zu accepted\n", iterations, accepted);
+
+    // 解析与按键查找不分配内存
+    {
+        const std::wstring reply = L"action=reply;input=textBox;";
+        const rainy_test::allocation_scope scope;
+        for (int i = 0; i < 1000; ++i) {
+            RAINY_CHECK(parsed.parse(reply) && parsed.is_reply());
+        }
+        RAINY_CHECK(scope.count() == 0);
+    }
+
+    // add_input拒绝空id、重复id，以及含有编码分隔符'='或';'的id
+    notification_template toast;
+    toast.set_first_line(L"reply");
+    RAINY_CHECK(!toast.add_input(L""));
+    RAINY_CHECK(!toast.add_input(L"a;b"));
+    RAINY_CHECK(!toast.add_input(L";"));
+    RAINY_CHECK(!toast.add_input(L"a=b"));
+    RAINY_CHECK(toast.inputs().empty());
+    RAINY_CHECK(toast.add_input(L"r&b", L"Type"));
+    RAINY_CHECK(!toast.add_input(L"r&b"));
+    for (std::size_t i = 1; i < notification_template::max_inputs; ++i) {
+        RAINY_CHECK(toast.add_input(L"extra" + std::to_wstring(i)));
+    }
+    RAINY_CHECK(!toast.add_input(L"overflow"));
+    RAINY_CHECK(toast.inputs().size() == notification_template::max_inputs);
+
+    // 回复按钮的激活参数经XML转义后，平台回报的原始参数仍能解析出关联的输入框
+    auto n = rainy_test::make_notification();
+    auto backend = std::dynamic_pointer_cast<memory_notification_backend>(n->backend());
+    RAINY_CHECK(backend != nullptr);
+    if (backend) {
+        std::wstring reply;
+        const auto id = n->show(toast, [&](const notification_event &event) {
+            if (event.type == event_type::activated_with_reply) {
+                reply = std::get<std::wstring_view>(event.data);
+            }
+        });
+        const auto record = backend->find(id);
+        RAINY_CHECK(record && record->xml.find(L"arguments=\"action=reply;input=r&amp;b;\"") != std::wstring::npos);
+        const user_input inputs[] = {{L"extra1", L"wrong"}, {L"r&b", L"hello"}};
+        RAINY_CHECK(backend->simulate_activated(id, L"action=reply;input=r&b;", inputs));
+        RAINY_CHECK(reply == L"hello");
+    }
+    return rainy_test::finish("toast_arguments_test");
+}
@@ -0,0 +1,89 @@
+﻿/*
+ * toast_xml_serializer的输出与固定的期望XML逐字节比较，覆盖八种传统布局与ToastGeneric的各个可选节点
+ */
+#include "test_support.hpp"
+
+#include <iostream>
+
+using namespace rainy;
+using template_type = notification_template_type;
+
+namespace {
+    const platform_capabilities full_capabilities{true, true, true, true, true};
+
+    bool expect_xml(const std::wstring &actual, const std::wstring_view expected) {
+        if (actual == expected) {
+            return true;
+        }
+        std::wcerr << L"expected: " << expected << L"\n  actual: " << actual << L"\n";
+        return false;
+    }
+
+    notification_template filled(const template_type type) {
+        notification_template result(type);
+        result.set_first_line(L"one");
+        result.set_second_line(L"two");
+        result.set_third_line(L"three");
+        if (static_cast<int>(type) <= static_cast<int>(template_type::image_and_text04)) {
+            result.set_image_path(LR"(C:\a.png)");
+        }
+        return result;
+    }
+}
+
+int main() {
+    const utility::toast_xml_serializer serializer(utility::context_bridge(full_capabilities, true));
+
+    // 八种传统布局，未使用的行不会输出
+    constexpr std::wstring_view legacy_expected[] = {
+        LR"(<toast scenario="Default"><visual><binding template="ToastImageAndText01"><image id="1" src="file:///C:\a.png"/><text id="1">one</text></binding></visual></toast>)",
+        LR"(<toast scenario="Default"><visual><binding template="ToastImageAndText02"><image id="1" src="file:///C:\a.png"/><text id="1">one</text><text id="2">two</text></binding></visual></toast>)",
+        LR"(<toast scenario="Default"><visual><binding template="ToastImageAndText03"><image id="1" src="file:///C:\a.png"/><text id="1">one</text><text id="2">two</text></binding></visual></toast>)",
+        LR"(<toast scenario="Default"><visual><binding template="ToastImageAndText04"><image id="1" src="file:///C:\a.png"/><text id="1">one</text><text id="2">two</text><text id="3">three</text></binding></visual></toast>)",
+        LR"(<toast scenario="Default"><visual><binding template="ToastText01"><text id="1">one</text></binding></visual></toast>)",
+        LR"(<toast scenario="Default"><visual><binding template="ToastText02"><text id="1">one</text><text id="2">two</text></binding></visual></toast>)",
+        LR"(<toast scenario="Default"><visual><binding template="ToastText03"><text id="1">one</text><text id="2">two</text></binding></visual></toast>)",
+        LR"(<toast scenario="Default"><visual><binding template="ToastText04"><text id="1">one</text><text id="2">two</text><text id="3">three</text></binding></visual></toast>)",
+    };
+    for (int i = 0; i < 8; ++i) {
+        RAINY_CHECK(expect_xml(serializer.serialize(filled(static_cast<template_type>(i))), legacy_expected[i]));
+    }
+
+    // ToastGeneric：应用徽标使用placement="appLogoOverride"与hint-crop="circle"，文本经过转义
+    notification_template generic(template_type::image_and_text02);
+    generic.set_first_line(L"a<b");
+    generic.set_second_line(L"\"q\"");
+    generic.set_image_path(LR"(C:\a.png)", notification_template::crop_hint::circle);
+    generic.hero_image_path(LR"(C:\h.png)");
+    generic.set_attribution_text(L"via");
+    generic.actions.add_action({L"Yes", L"No"});
+    generic.audio_option(notification_template::audio_option_t::silent);
+    RAINY_CHECK(expect_xml(
+        serializer.serialize(generic),
+        LR"(<toast duration="long" scenario="Default"><visual><binding template="ToastGeneric"><image id="1" src="file:///C:\a.png" placement="appLogoOverride" hint-crop="circle"/><text id="1">a&lt;b</text><text id="2">&quot;q&quot;</text><text placement="attribution">via</text><image placement="hero" src="C:\h.png"/></binding></visual><actions><action content="Yes" arguments="action=0;"/><action content="No" arguments="action=1;"/></actions><audio silent="true"/></toast>)"));
+
+    // 进度条与回复输入框
+    notification_template progress;
+    progress.set_first_line(L"dl");
+    progress.progress_bar(L"{v}", L"{s}", L"File");
+    progress.add_input(L"reply", L"Type");
+    RAINY_CHECK(expect_xml(
+        serializer.serialize(progress),
+        LR"(<toast scenario="Default"><visual><binding template="ToastGeneric"><text id="1">dl</text><progress title="File" value="{v}" status="{s}"/></binding></visual><actions><input id="reply" type="text" placeHolderContent="Type"/><action content="Reply" arguments="action=reply;input=reply;" hint-inputId="reply"/></actions></toast>)"));
+
+    // 不支持Modern Toast时不输出toast属性与操作按钮
+    const utility::toast_xml_serializer legacy(utility::context_bridge(platform_capabilities{}, false));
+    notification_template plain(template_type::text02);
+    plain.set_first_line(L"a");
+    plain.set_second_line(L"b");
+    plain.actions.add_action({L"Yes"});
+    RAINY_CHECK(expect_xml(
+        legacy.serialize(plain),
+        LR"(<toast><visual><binding template="ToastText02"><text id="1">a</text><text id="2">b</text></binding></visual></toast>)"));
+
+    // 复用缓冲区时结果不变
+    std::wstring buffer = L"stale";
+    serializer.serialize(filled(template_type::text04), buffer);
+    RAINY_CHECK(expect_xml(buffer, legacy_expected[7]));
+    return rainy_test::finish("toast_xml_serializer_test");
+}